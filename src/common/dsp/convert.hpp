@@ -0,0 +1,52 @@
+/*
+ * Copyright (C) 2021 fleroviux
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <common/integer.hpp>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #include <emmintrin.h>
+  #define CONVERT_SSE2
+#endif
+
+namespace common::dsp {
+
+/** Converts float samples in [-1, 1] to signed 16-bit samples.
+  * Out of range samples are clamped to slightly below full scale.
+  */
+inline void ConvertFloatToS16(float const* src, s16* dst, int count) {
+  static constexpr float kMaxAmplitude = 0.999;
+
+  int i = 0;
+
+#if defined(CONVERT_SSE2)
+  const __m128 min = _mm_set1_ps(-kMaxAmplitude);
+  const __m128 max = _mm_set1_ps( kMaxAmplitude);
+  const __m128 scale = _mm_set1_ps(32767.0);
+
+  for (; i + 8 <= count; i += 8) {
+    __m128 a = _mm_loadu_ps(&src[i + 0]);
+    __m128 b = _mm_loadu_ps(&src[i + 4]);
+
+    a = _mm_mul_ps(_mm_min_ps(_mm_max_ps(a, min), max), scale);
+    b = _mm_mul_ps(_mm_min_ps(_mm_max_ps(b, min), max), scale);
+
+    __m128i packed = _mm_packs_epi32(_mm_cvtps_epi32(a), _mm_cvtps_epi32(b));
+
+    _mm_storeu_si128((__m128i*)&dst[i], packed);
+  }
+#endif
+
+  for (; i < count; i++) {
+    dst[i] = s16(std::round(std::clamp(src[i], -kMaxAmplitude, kMaxAmplitude) * 32767.0f));
+  }
+}
+
+} // namespace common::dsp
@@ -7,90 +7,171 @@
 
 #pragma once
 
+#include <memory>
+#include <type_traits>
+
+#if defined(__AVX__)
+  #include <immintrin.h>
+  #define SINC_AVX
+#elif defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+  #include <xmmintrin.h>
+  #define SINC_SSE
+#endif
+
 #include "../resampler.hpp"
-#include "../ring_buffer.hpp"
 
 namespace common::dsp {
 
-template <typename T, int points>
+/** Windowed-sinc resampler with a polyphase kernel table.
+  * The kernel is sampled at phases + 1 points between two input samples,
+  * each phase is stored as one contiguous row of taps. Lower phase resolutions
+  * trade a little accuracy for a much smaller table.
+  */
+template <typename T, int points, int phases = 512>
 struct SincResampler : Resampler<T> {
   static_assert((points % 4) == 0, "DSP::SincResampler<T, points>: points must be divisible by four.");
 
-  SincResampler(std::shared_ptr<WriteStream<T>> output) 
+  SincResampler(std::shared_ptr<WriteStream<T>> output)
       : Resampler<T>(output) {
     SetSampleRates(1, 1);
-
-    for (int i = 0; i < points - 1; i++) {
-      taps.Write({});
-    }
   }
-  
+
   void SetSampleRates(float samplerate_in, float samplerate_out) final {
     Resampler<T>::SetSampleRates(samplerate_in, samplerate_out);
-    
-    float kernelSum = 0.0;
-    float cutoff = 1.0;//0.9;
-    
+
+    double kernelSum = 0.0;
+    double cutoff = 1.0;//0.9;
+
     if (this->resample_phase_shift > 1.0) {
       cutoff /= this->resample_phase_shift;
     }
 
-    for (int n = 0; n < points; n++) {
-      for (int m = 0; m < s_lut_resolution; m++) {
-        double t  = m/double(s_lut_resolution);
+    /* Dynamic rate control changes the rates by tiny amounts every frame.
+     * The kernel only depends on the cutoff, so rebuild it only if that changed noticeably.
+     */
+    if (std::abs(cutoff - lut_cutoff) < 0.001) {
+      return;
+    }
+
+    lut_cutoff = cutoff;
+
+    for (int m = 0; m <= phases; m++) {
+      for (int n = 0; n < points; n++) {
+        double t  = m/double(phases);
         double x1 = M_PI * (t - n + points/2) + 1e-6;
-        double x2 = 2 * M_PI * (n + t)/points; 
+        double x2 = 2 * M_PI * (n + t)/points;
         double sinc = std::sin(cutoff * x1)/x1;
         double blackman = 0.42 - 0.49 * std::cos(x2) + 0.076 * std::cos(2 * x2);
-        
-        lut[n * s_lut_resolution + m] = sinc * blackman;
-        kernelSum += sinc * blackman;
+
+        lut[m * points + n] = float(sinc * blackman);
+
+        // The last row equals the first one shifted by one tap.
+        if (m != phases) {
+          kernelSum += sinc * blackman;
+        }
       }
     }
-    
-    kernelSum /= s_lut_resolution;
-    
-    for (int i = 0; i < points * s_lut_resolution; i++) {
-      lut[i] /= kernelSum;
+
+    kernelSum /= phases;
+
+    for (int i = 0; i < (phases + 1) * points; i++) {
+      lut[i] = float(lut[i] / kernelSum);
     }
   }
 
   void Write(T const& input) final {
-    taps.Write(input);
-
-    while (resample_phase < 1.0) { 
-      T sample = {};
-
-      int x = int(std::round(resample_phase * s_lut_resolution));
-      
-      for (int n = 0; n < points; n += 4) {        
-        sample += taps.Peek(n + 0) * lut[x + 0 * s_lut_resolution];
-        sample += taps.Peek(n + 1) * lut[x + 1 * s_lut_resolution]; 
-        sample += taps.Peek(n + 2) * lut[x + 2 * s_lut_resolution]; 
-        sample += taps.Peek(n + 3) * lut[x + 3 * s_lut_resolution];
-        
-        x += 4 * s_lut_resolution;
-      }
+    /* Every sample is stored twice, so that the newest `points` samples
+     * are always contiguous in memory, oldest first.
+     */
+    history[history_pos] = input;
+    history[history_pos + points] = input;
+
+    if (++history_pos == points) {
+      history_pos = 0;
+    }
+
+    T const* window = &history[history_pos];
 
-      this->output->Write(sample);
+    while (resample_phase < 1.0) {
+      int phase = int(std::round(resample_phase * phases));
+
+      this->output->Write(Convolve(window, &lut[phase * points]));
 
       resample_phase += this->resample_phase_shift;
     }
 
-    taps.Read();
-
     resample_phase = resample_phase - 1.0;
   }
-  
+
 private:
-  static constexpr int s_lut_resolution = 512;
+  static auto Convolve(T const* window, float const* kernel) -> T {
+#if defined(SINC_AVX) || defined(SINC_SSE)
+    if constexpr (std::is_same_v<T, StereoSample<float>>) {
+      // Left and right samples are interleaved, so each kernel tap is used twice.
+      auto samples = reinterpret_cast<float const*>(window);
+
+#if defined(SINC_AVX)
+      __m256 acc = _mm256_setzero_ps();
+
+      for (int n = 0; n < points; n += 4) {
+        __m128 k = _mm_loadu_ps(&kernel[n]);
+        __m256 k2 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_unpacklo_ps(k, k)), _mm_unpackhi_ps(k, k), 1);
+
+        acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_loadu_ps(&samples[n * 2]), k2));
+      }
+
+      __m128 sum = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+#else
+      __m128 acc0 = _mm_setzero_ps();
+      __m128 acc1 = _mm_setzero_ps();
+
+      for (int n = 0; n < points; n += 4) {
+        __m128 k = _mm_loadu_ps(&kernel[n]);
+
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(&samples[n * 2 + 0]), _mm_unpacklo_ps(k, k)));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(&samples[n * 2 + 4]), _mm_unpackhi_ps(k, k)));
+      }
+
+      __m128 sum = _mm_add_ps(acc0, acc1);
+#endif
+
+      // (L0, R0, L1, R1) -> (L0 + L1, R0 + R1)
+      sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+
+      return { _mm_cvtss_f32(sum), _mm_cvtss_f32(_mm_shuffle_ps(sum, sum, 1)) };
+    }
+
+    if constexpr (std::is_same_v<T, float>) {
+      __m128 acc = _mm_setzero_ps();
+
+      for (int n = 0; n < points; n += 4) {
+        acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(&window[n]), _mm_loadu_ps(&kernel[n])));
+      }
+
+      acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+      acc = _mm_add_ss(acc, _mm_shuffle_ps(acc, acc, 1));
+
+      return _mm_cvtss_f32(acc);
+    }
+#endif
+
+    T sample = {};
+
+    for (int n = 0; n < points; n++) {
+      sample += window[n] * kernel[n];
+    }
+
+    return sample;
+  }
 
-  double lut[points * s_lut_resolution];
+  alignas(32) float lut[(phases + 1) * points];
+  double lut_cutoff = 0;
   float resample_phase = 0;
-  RingBuffer<T> taps { points };
+  int history_pos = 0;
+  T history[points * 2] {};
 };
 
-template <typename T, int points>
-using SincStereoResampler = SincResampler<StereoSample<T>, points>;
+template <typename T, int points, int phases = 512>
+using SincStereoResampler = SincResampler<StereoSample<T>, points, phases>;
 
 } // namespace common::dsp
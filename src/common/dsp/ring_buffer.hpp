@@ -7,6 +7,10 @@
 
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
 #include <memory>
 
 #include "stereo.hpp"
@@ -67,7 +71,117 @@ private:
   bool blocking;
 };
 
+/** Wait-free ring buffer for exactly one producer and one consumer thread.
+  * Write() may only be called by the producer, Peek(), PeekSpans(), Skip() and Read()
+  * only by the consumer. Available() may be called by both threads, for the producer
+  * it is an upper bound. The length is rounded up to a power of two.
+  * Like a blocking RingBuffer, values written to a full buffer are dropped.
+  */
+template <typename T>
+struct SPSCRingBuffer : Stream<T> {
+  SPSCRingBuffer(int length) {
+    while (capacity < size_t(length)) {
+      capacity *= 2;
+    }
+    data = std::make_unique<T[]>(capacity);
+    Reset();
+  }
+
+  auto Available() -> int {
+    return int(wr_ptr.load(std::memory_order_acquire) - rd_ptr.load(std::memory_order_acquire));
+  }
+
+  auto Capacity() -> int { return int(capacity); }
+
+  /// Must not be called while either thread accesses the buffer.
+  void Reset() {
+    rd_ptr = 0;
+    wr_ptr = 0;
+    rd_ptr_cached = 0;
+    wr_ptr_cached = 0;
+    for (size_t i = 0; i < capacity; i++) {
+      data[i] = {};
+    }
+  }
+
+  /// @param offset index relative to the oldest value, must be less than Available().
+  auto Peek(int offset) -> T const {
+    return data[(rd_ptr.load(std::memory_order_relaxed) + offset) & (capacity - 1)];
+  }
+
+  /// @returns the oldest value, or a default-constructed value if the buffer is empty.
+  auto Read() -> T {
+    auto rd = rd_ptr.load(std::memory_order_relaxed);
+
+    // Skip() may have moved the read index past the cached write index.
+    if (std::ptrdiff_t(wr_ptr_cached - rd) <= 0) {
+      wr_ptr_cached = wr_ptr.load(std::memory_order_acquire);
+      if (wr_ptr_cached == rd) {
+        return {};
+      }
+    }
+
+    T value = data[rd & (capacity - 1)];
+    rd_ptr.store(rd + 1, std::memory_order_release);
+    return value;
+  }
+
+  /// Contiguous run of values inside the buffer.
+  struct Span {
+    T const* data;
+    int length;
+  };
+
+  /** Gives direct access to the oldest values without consuming them.
+    * Wraparound splits them into two spans, otherwise the second one is empty.
+    * @param count number of values, must be at most Available().
+    */
+  auto PeekSpans(int count) -> std::array<Span, 2> {
+    auto rd = rd_ptr.load(std::memory_order_relaxed) & (capacity - 1);
+    auto first = std::min(size_t(count), capacity - rd);
+
+    return {{
+      { &data[rd], int(first) },
+      { &data[0], count - int(first) }
+    }};
+  }
+
+  /// Consumes the oldest values, `count` must be at most Available().
+  void Skip(int count) {
+    rd_ptr.store(rd_ptr.load(std::memory_order_relaxed) + count, std::memory_order_release);
+  }
+
+  void Write(T const& value) {
+    auto wr = wr_ptr.load(std::memory_order_relaxed);
+
+    if (wr - rd_ptr_cached == capacity) {
+      rd_ptr_cached = rd_ptr.load(std::memory_order_acquire);
+      if (wr - rd_ptr_cached == capacity) {
+        return;
+      }
+    }
+
+    data[wr & (capacity - 1)] = value;
+    wr_ptr.store(wr + 1, std::memory_order_release);
+  }
+
+private:
+  std::unique_ptr<T[]> data;
+  size_t capacity = 1;
+
+  /* Each index is written by one side only. The other side's index is cached,
+   * so that the shared cache lines are only read when the buffer seems empty or full.
+   */
+  alignas(64) std::atomic<size_t> rd_ptr;
+  size_t wr_ptr_cached;
+  alignas(64) std::atomic<size_t> wr_ptr;
+  size_t rd_ptr_cached;
+};
+
 template <typename T>
 using StereoRingBuffer = RingBuffer<StereoSample<T>>;
 
+template <typename T>
+using StereoSPSCRingBuffer = SPSCRingBuffer<StereoSample<T>>;
+
 } // namespace common::dsp
@@ -130,4 +130,18 @@ const std::map<std::string, GameInfo> g_game_db {
   { "ALUE", { Config::BackupType::EEPROM_4, GPIODeviceType::None, false } }   /* 0763 - Super Monkey Ball Jr. (USA) */
 };
 
+/*
+ * Games that poll a register which changes without a scheduler event,
+ * in a loop that passes the idle loop analysis. Entries have the form:
+ *   "XXXX", // Game title (Region)
+ *
+ * The list is empty on purpose: the known cases are caught at runtime.
+ * Reads of the timer counters, SRAM/FLASH and of GPIO or EEPROM through
+ * the ROM area mark the current loop iteration as unsafe to skip
+ * (see CPU::idle_loop_unsafe). Add a game here only if it breaks with
+ * idle loop skipping and works without it.
+ */
+const std::set<std::string> g_idle_loop_skip_blacklist {
+};
+
 } // namespace nba
@@ -9,6 +9,7 @@
 
 #include <emulator/config/config.hpp>
 #include <map>
+#include <set>
 
 namespace nba {
 
@@ -25,4 +26,7 @@ struct GameInfo {
 
 extern const std::map<std::string, GameInfo> g_game_db;
 
+/// Game codes of games for which idle loop skipping must stay disabled.
+extern const std::set<std::string> g_idle_loop_skip_blacklist;
+
 } // namespace nba
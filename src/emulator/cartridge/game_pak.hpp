@@ -72,6 +72,34 @@ struct GamePak {
     return rom;
   }
 
+  /** Get a host pointer to an aligned, power-of-two sized range of ROM.
+    * @returns nullptr if reads from the range may have side effects or
+    * are not plain ROM reads (GPIO, EEPROM, out-of-bounds).
+    */
+  auto GetROMPointer(u32 address, u32 size) -> u8* {
+    address &= 0x01FF'FFFF;
+
+    if (gpio && address <= 0xC8 && address + size > 0xC4) {
+      return nullptr;
+    }
+
+    if (backup_eeprom && ((address | (size - 1)) & eeprom_mask) == eeprom_mask) {
+      return nullptr;
+    }
+
+    if ((rom_mask & (size - 1)) != size - 1) {
+      return nullptr;
+    }
+
+    address &= rom_mask;
+
+    if (address + size > rom.size()) {
+      return nullptr;
+    }
+
+    return rom.data() + address;
+  }
+
   auto ALWAYS_INLINE ReadROM16(u32 address) -> u16 {
     address &= 0x01FF'FFFE;
 
@@ -21,6 +21,7 @@ struct Config {
   std::string bios_path = "bios.bin";
   
   bool skip_bios = false;
+  bool hle_bios = false;
   bool sync_to_audio = false;
   
   enum class BackupType {
@@ -35,7 +36,22 @@ struct Config {
   
   bool force_rtc = false;
 
+  struct CPU {
+    enum class Backend {
+      Interpreter,
+      CachedInterpreter,
+      JIT
+    } backend = Backend::Interpreter;
+    bool idle_loop_skip = false;
+  } cpu;
+
   struct Video {
+    /* Pixel format of the frames passed to the video device. */
+    enum class Format {
+      ARGB8888,
+      ABGR8888
+    } format = Format::ARGB8888;
+    bool threaded_renderer = false;
     bool fullscreen = false;
     int scale = 2;
     struct Shader {
@@ -52,9 +68,10 @@ struct Config {
       Sinc_64,
       Sinc_128,
       Sinc_256
-    } interpolation = Interpolation::Cosine;
+    } interpolation = Interpolation::Sinc_128;
     bool interpolate_fifo = true;
     bool m4a_xq_enable = false;
+    bool dynamic_rate_control = false;
   } audio;
   
   std::shared_ptr<AudioDevice> audio_dev = std::make_shared<NullAudioDevice>();
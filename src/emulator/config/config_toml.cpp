@@ -39,6 +39,7 @@ void config_toml_read(Config& config, std::string const& path) {
       auto general = general_result.unwrap();
       config.bios_path = toml::find_or<std::string>(general, "bios_path", "bios.bin");
       config.skip_bios = toml::find_or<toml::boolean>(general, "bios_skip", false);
+      config.hle_bios = toml::find_or<toml::boolean>(general, "bios_hle", false);
       config.sync_to_audio = toml::find_or<toml::boolean>(general, "sync_to_audio", true);
     }
   }
@@ -73,11 +74,53 @@ void config_toml_read(Config& config, std::string const& path) {
     }
   }
 
+  if (data.contains("cpu")) {
+    auto cpu_result = toml::expect<toml::value>(data.at("cpu"));
+
+    if (cpu_result.is_ok()) {
+      auto cpu = cpu_result.unwrap();
+      auto backend = toml::find_or<std::string>(cpu, "backend", "interpreter");
+
+      const std::map<std::string, Config::CPU::Backend> backends{
+        { "interpreter", Config::CPU::Backend::Interpreter       },
+        { "cached",      Config::CPU::Backend::CachedInterpreter },
+        { "jit",         Config::CPU::Backend::JIT               }
+      };
+
+      auto match = backends.find(backend);
+
+      if (match == backends.end()) {
+        LOG_WARN("CPU backend '{0}' is not valid, defaulting to interpreter.", backend);
+        config.cpu.backend = Config::CPU::Backend::Interpreter;
+      } else {
+        config.cpu.backend = match->second;
+      }
+      config.cpu.idle_loop_skip = toml::find_or<toml::boolean>(cpu, "idle_loop_skip", false);
+    }
+  }
+
   if (data.contains("video")) {
     auto video_result = toml::expect<toml::value>(data.at("video"));
 
     if (video_result.is_ok()) {
       auto video = video_result.unwrap();
+      auto format = toml::find_or<std::string>(video, "color_format", "argb8888");
+
+      const std::map<std::string, Config::Video::Format> formats{
+        { "argb8888", Config::Video::Format::ARGB8888 },
+        { "abgr8888", Config::Video::Format::ABGR8888 }
+      };
+
+      auto match = formats.find(format);
+
+      if (match == formats.end()) {
+        LOG_WARN("Color format '{0}' is not valid, defaulting to argb8888.", format);
+        config.video.format = Config::Video::Format::ARGB8888;
+      } else {
+        config.video.format = match->second;
+      }
+
+      config.video.threaded_renderer = toml::find_or<toml::boolean>(video, "threaded_renderer", false);
       config.video.fullscreen = toml::find_or<toml::boolean>(video, "fullscreen", false);
       config.video.scale = toml::find_or<int>(video, "scale", 2);
       config.video.shader.path_vs = toml::find_or<std::string>(video, "shader_vs", "");
@@ -90,7 +133,7 @@ void config_toml_read(Config& config, std::string const& path) {
 
     if (audio_result.is_ok()) {
       auto audio = audio_result.unwrap();
-      auto resampler = toml::find_or<std::string>(audio, "resampler", "cosine");
+      auto resampler = toml::find_or<std::string>(audio, "resampler", "sinc128");
 
       const std::map<std::string, Config::Audio::Interpolation> resamplers{
         { "cosine",  Config::Audio::Interpolation::Cosine   },
@@ -103,14 +146,15 @@ void config_toml_read(Config& config, std::string const& path) {
       auto match = resamplers.find(resampler);
 
       if (match == resamplers.end()) {
-        LOG_WARN("Resampler '{0}' is not valid, defaulting to cosine resampler.", resampler);
-        config.audio.interpolation = Config::Audio::Interpolation::Cosine;
+        LOG_WARN("Resampler '{0}' is not valid, defaulting to sinc128 resampler.", resampler);
+        config.audio.interpolation = Config::Audio::Interpolation::Sinc_128;
       } else {
         config.audio.interpolation = match->second;
       }
 
       config.audio.interpolate_fifo = toml::find_or<toml::boolean>(audio, "interpolate_fifo", true);
       config.audio.m4a_xq_enable = toml::find_or<toml::boolean>(audio, "m4a_xq_enable", false);
+      config.audio.dynamic_rate_control = toml::find_or<toml::boolean>(audio, "dynamic_rate_control", false);
     }
   }
 }
@@ -130,6 +174,7 @@ void config_toml_write(Config& config, std::string const& path) {
   // General
   data["general"]["bios_path"] = config.bios_path;
   data["general"]["bios_skip"] = config.skip_bios;
+  data["general"]["bios_hle"] = config.hle_bios;
   data["general"]["sync_to_audio"] = config.sync_to_audio;
 
   // Cartridge
@@ -146,7 +191,22 @@ void config_toml_write(Config& config, std::string const& path) {
   data["cartridge"]["save_type"] = save_type;
   data["cartridge"]["force_rtc"] = config.force_rtc;
 
+  // CPU
+  std::string backend;
+  switch (config.cpu.backend) {
+    case Config::CPU::Backend::Interpreter:       backend = "interpreter"; break;
+    case Config::CPU::Backend::CachedInterpreter: backend = "cached"; break;
+    case Config::CPU::Backend::JIT:               backend = "jit"; break;
+  }
+  data["cpu"]["backend"] = backend;
+  data["cpu"]["idle_loop_skip"] = config.cpu.idle_loop_skip;
+
   // Video
+  switch (config.video.format) {
+    case Config::Video::Format::ARGB8888: data["video"]["color_format"] = "argb8888"; break;
+    case Config::Video::Format::ABGR8888: data["video"]["color_format"] = "abgr8888"; break;
+  }
+  data["video"]["threaded_renderer"] = config.video.threaded_renderer;
   data["video"]["fullscreen"] = config.video.fullscreen;
   data["video"]["scale"] = config.video.scale;
   data["video"]["shader_vs"] = config.video.shader.path_vs;
@@ -164,6 +224,7 @@ void config_toml_write(Config& config, std::string const& path) {
   data["audio"]["resampler"] = resampler;
   data["audio"]["interpolate_fifo"] = config.audio.interpolate_fifo;
   data["audio"]["m4a_xq_enable"] = config.audio.m4a_xq_enable;
+  data["audio"]["dynamic_rate_control"] = config.audio.dynamic_rate_control;
 
   std::ofstream file{ path, std::ios::out };
   file << data;
@@ -7,28 +7,49 @@
 
 #pragma once
 
+#include <algorithm>
 #include <array>
 #include <common/compiler.hpp>
 #include <common/log.hpp>
+#include <common/punning.hpp>
+#include <memory>
 #include <emulator/core/scheduler.hpp>
 
+#include "jit/jit.hpp"
+#include "block_cache.hpp"
+#include "idle_loop.hpp"
 #include "memory.hpp"
 #include "state.hpp"
 
 namespace nba::core::arm {
 
+/** ARM7TDMI interpreter core.
+  * Bus is the memory policy which the core uses for every fetch, load and store.
+  * It must provide ReadByte/Half/Word, WriteByte/Half/Word and Idle.
+  * These are called directly, so that they can be inlined into the handlers.
+  * It must also provide HandleSWI, see SetSWIHook(), and GetCodePointer,
+  * which returns a host pointer to the memory at an address or nullptr
+  * if code at that address may not be cached, see RunBlock().
+  */
+template<typename Bus>
 struct ARM7TDMI {
   using Access = MemoryBase::Access;
+  using Block = BasicBlock<ARM7TDMI>;
+  using Cache = BlockCache<ARM7TDMI>;
 
-  ARM7TDMI(Scheduler& scheduler, MemoryBase* interface)
+  /* The scheduler may not be constructed yet when the bus owns it,
+   * so the owner must call Reset() before running the core.
+   */
+  ARM7TDMI(Scheduler& scheduler, Bus* interface)
       : scheduler(scheduler)
       , interface(interface) {
-    Reset();
   }
 
   auto IRQLine() -> bool& { return irq_line; }
 
   void Reset() {
+    scheduler.Register<&ARM7TDMI::OnLDMUsermodeConflictEnd>(EventClass::ARM_ldm_usermode_conflict, this);
+
     state.Reset();
     SwitchMode(state.cpsr.f.mode);
 
@@ -38,6 +59,12 @@ struct ARM7TDMI {
     irq_line = false;
     ldm_usermode_conflict = false;
     cpu_mode_is_invalid = false;
+    block_break = false;
+    block_cache.Reset();
+    jit_flush = false;
+    if (jit != nullptr) {
+      jit->Reset();
+    }
   }
 
   auto GetPrefetchedOpcode(int slot) -> u32 {
@@ -77,18 +104,119 @@ struct ARM7TDMI {
     }
   }
 
+  /** Executes instructions from the basic block which starts at the current
+    * program counter, until the block ends, control flow leaves the block,
+    * an unmasked IRQ becomes pending or the scheduler reaches the given timestamp.
+    * Instructions are decoded once when they are first executed and then
+    * dispatched from the block cache. Timing is identical to Run().
+    * If the block ends by branching to another block which is already cached,
+    * execution continues with that block.
+    * Code which Bus::GetCodePointer() declines is executed with Run().
+    * @returns whether the last block is an idle loop which has branched back to
+    *   its start without a scheduler event in between. Always false unless
+    *   idle loop detection is enabled.
+    */
+  bool RunBlock(u64 timestamp_limit) {
+    if (IRQLine()) SignalIRQ();
+
+    if (unlikely(jit_flush)) {
+      jit_flush = false;
+      jit->Reset();
+      block_cache.Reset();
+    }
+
+    block_break = false;
+    block_timestamp_limit = timestamp_limit;
+
+    auto block = GetBlock(true);
+
+    while (block != nullptr) {
+      bool idle;
+
+      block_timestamp_target = scheduler.GetTimestampTarget();
+
+      if (block->thumb) {
+        idle = RunBlock16(block);
+      } else {
+        idle = RunBlock32(block);
+      }
+
+      if (idle || IsIRQServable() || block_break || scheduler.GetTimestampNow() >= block_timestamp_limit) {
+        return idle;
+      }
+
+      block = GetNextBlock(block);
+    }
+
+    return false;
+  }
+
+  void SetIdleLoopDetection(bool enable) {
+    idle_loop_detection = enable;
+  }
+
+  /** When enabled, SWIs are first passed to Bus::HandleSWI(number), which
+    * returns whether it handled the SWI. Handled SWIs do not enter the
+    * exception vector. The handler may move r15 to the start of an
+    * instruction (for example the SWI itself), execution then resumes there.
+    */
+  void SetSWIHook(bool enable) {
+    swi_hook = enable;
+  }
+
+  /// Enables translation of hot basic blocks to native code.
+  /// @returns false if the JIT is not supported on this host.
+  bool SetJITEnable(bool enable, size_t code_buffer_size = JIT::kCodeBufferSize) {
+    block_cache.Reset();
+    jit_flush = false;
+
+    if (!enable) {
+      jit.reset();
+      return true;
+    }
+
+    if (!JIT::IsSupported()) {
+      return false;
+    }
+
+    if (jit == nullptr || jit->GetBufferSize() != code_buffer_size) {
+      jit = std::make_unique<JIT>(code_buffer_size);
+    } else {
+      jit->Reset();
+    }
+
+    if (!jit->IsValid()) {
+      jit.reset();
+      return false;
+    }
+    return true;
+  }
+
+  /// Drops cached basic blocks that overlap the written address.
+  void ALWAYS_INLINE InvalidateBlockCache(u32 address) {
+    if (unlikely(block_cache.Invalidate(address))) {
+      block_break = true;
+    }
+  }
+
+  /// Forces RunBlock() to return after the current instruction.
+  void BreakBlock() {
+    block_break = true;
+  }
+
   void SwitchMode(Mode new_mode) {
     auto old_bank = GetRegisterBankByMode(state.cpsr.f.mode);
     auto new_bank = GetRegisterBankByMode(new_mode);
 
     state.cpsr.f.mode = new_mode;
 
-    if (new_bank != BANK_NONE) {
+    if (new_bank != BANK_NONE && new_bank != BANK_INVALID) {
       p_spsr = &state.spsr[new_bank];
     } else {
       /* In system/user mode reading from SPSR returns the current CPSR value.
        * However writes to SPSR appear to do nothing.
        * We take care of this fact in the MSR implementation.
+       * Invalid modes have no SPSR either, see GetSPSR().
        */
       p_spsr = &state.cpsr;
     }
@@ -97,20 +225,29 @@ struct ARM7TDMI {
       return;
     }
 
+    // Invalid modes have no register bank, their banked registers are not accessible.
     if (old_bank == BANK_FIQ || new_bank == BANK_FIQ) {
-      for (int i = 0; i < 7; i++) {
-        state.bank[old_bank][i] = state.reg[8 + i];
+      if (old_bank != BANK_INVALID) {
+        for (int i = 0; i < 7; i++) {
+          state.bank[old_bank][i] = state.reg[8 + i];
+        }
       }
 
-      for (int i = 0; i < 7; i++) {
-        state.reg[8 + i] = state.bank[new_bank][i];
+      if (new_bank != BANK_INVALID) {
+        for (int i = 0; i < 7; i++) {
+          state.reg[8 + i] = state.bank[new_bank][i];
+        }
       }
     } else {
-      state.bank[old_bank][5] = state.r13;
-      state.bank[old_bank][6] = state.r14;
+      if (old_bank != BANK_INVALID) {
+        state.bank[old_bank][5] = state.r13;
+        state.bank[old_bank][6] = state.r14;
+      }
 
-      state.r13 = state.bank[new_bank][5];
-      state.r14 = state.bank[new_bank][6];
+      if (new_bank != BANK_INVALID) {
+        state.r13 = state.bank[new_bank][5];
+        state.r14 = state.bank[new_bank][6];
+      }
     }
 
     cpu_mode_is_invalid = new_bank == BANK_INVALID;
@@ -121,8 +258,12 @@ struct ARM7TDMI {
   typedef void (ARM7TDMI::*Handler16)(u16);
   typedef void (ARM7TDMI::*Handler32)(u32);
 
+  using BlockInstruction = typename Block::Instruction;
+  typedef void (ARM7TDMI::*BlockHandler)(BlockInstruction const&);
+
 private:
-  friend struct TableGen;
+  template<typename> friend struct TableGen;
+  friend struct JIT;
 
   auto GetReg(int id) -> u32 {
     u32 result = 0;
@@ -226,6 +367,246 @@ private:
     state.r15 += 8;
   }
 
+  /** Looks up the block at the current program counter.
+    * If it is not cached yet and create is set, a new block is created
+    * or the instruction is executed with Run() if the code may not be cached.
+    */
+  auto GetBlock(bool create) -> Block* {
+    bool thumb = state.cpsr.f.thumb;
+    u32 address = GetExecuteAddress();
+
+    auto block = block_cache.Get(address, thumb);
+
+    if (block == nullptr && create) {
+      if (interface->GetCodePointer(address) == nullptr) {
+        Run();
+        return nullptr;
+      }
+      block = block_cache.Create(address, thumb);
+    }
+    return block;
+  }
+
+  /// Looks up the block at the current program counter, which follows the given block.
+  auto GetNextBlock(Block* block) -> Block* {
+    auto next = block->next;
+
+    if (next != nullptr && block->next_epoch == block_cache.GetEpoch() &&
+        next->thumb == state.cpsr.f.thumb && next->address == GetExecuteAddress()) {
+      return next;
+    }
+
+    next = GetBlock(false);
+    block->next = next;
+    block->next_epoch = block_cache.GetEpoch();
+    return next;
+  }
+
+  /// @returns the address of the instruction in the execute stage of the pipeline.
+  auto GetExecuteAddress() -> u32 {
+    if (state.cpsr.f.thumb) {
+      return (state.r15 & ~1) - 4;
+    }
+    return (state.r15 & ~3) - 8;
+  }
+
+  bool RunBlock16(Block* block) {
+    u32 address = block->address;
+
+    state.r15 &= ~1;
+
+    if (block->compiled != nullptr && block->compiled(this)) {
+      return CheckIdleLoop(block);
+    }
+
+    for (auto& entry : block->code) {
+      if (!StepBlock16(entry)) {
+        return FinishBlock(block);
+      }
+    }
+
+    // Compiled code points to the instructions of the block, which therefore must not move.
+    if (block->compiled != nullptr) {
+      return FinishBlock(block);
+    }
+
+    // Decode the following instructions on their first execution.
+    int max_length = std::min(Block::kMaxLength, int(Cache::kPageSize - (address & (Cache::kPageSize - 1))) >> 1);
+
+    for (int i = block->code.size(); i < max_length; i++) {
+      u32 instruction = pipe.opcode[0];
+      u32 instruction_address = address + i * 2;
+
+      if (!IsCodeInMemory(instruction_address, u16(instruction))) {
+        Run();
+        break;
+      }
+
+      auto& entry = block->code.emplace_back();
+
+      DecodeBlockInstruction16(entry, instruction_address, instruction);
+      block_cache.MarkCode(instruction_address, instruction_address + 1);
+
+      if (!StepBlock16(entry)) {
+        break;
+      }
+    }
+
+    return FinishBlock(block);
+  }
+
+  bool RunBlock32(Block* block) {
+    u32 address = block->address;
+
+    state.r15 &= ~3;
+
+    if (block->compiled != nullptr && block->compiled(this)) {
+      return CheckIdleLoop(block);
+    }
+
+    for (auto& entry : block->code) {
+      if (!StepBlock32(entry)) {
+        return FinishBlock(block);
+      }
+    }
+
+    // Compiled code points to the instructions of the block, which therefore must not move.
+    if (block->compiled != nullptr) {
+      return FinishBlock(block);
+    }
+
+    int max_length = std::min(Block::kMaxLength, int(Cache::kPageSize - (address & (Cache::kPageSize - 1))) >> 2);
+
+    for (int i = block->code.size(); i < max_length; i++) {
+      u32 instruction = pipe.opcode[0];
+      u32 instruction_address = address + i * 4;
+
+      if (!IsCodeInMemory(instruction_address, instruction)) {
+        Run();
+        break;
+      }
+
+      auto& entry = block->code.emplace_back();
+
+      DecodeBlockInstruction32(entry, instruction_address, instruction);
+      block_cache.MarkCode(instruction_address, instruction_address + 3);
+
+      if (!StepBlock32(entry)) {
+        break;
+      }
+    }
+
+    return FinishBlock(block);
+  }
+
+  /** Blocks are validated by writes to the memory that they were decoded from.
+    * The pipeline however may hold an opcode which has been overwritten
+    * after it was fetched. That opcode is executed once but must not be cached.
+    */
+  template<typename T>
+  bool IsCodeInMemory(u32 address, T opcode) {
+    auto code = interface->GetCodePointer(address);
+
+    return code != nullptr && common::read<T>(code, 0) == opcode;
+  }
+
+  bool FinishBlock(Block* block) {
+    bool idle = CheckIdleLoop(block);
+    CompileBlockIfHot(block);
+    return idle;
+  }
+
+  /// Executes a single pre-decoded Thumb instruction.
+  /// @returns whether execution may continue with the next instruction of the block.
+  auto ALWAYS_INLINE StepBlock16(BlockInstruction const& entry) -> bool {
+    u32 r15 = state.r15;
+
+    Fetch16();
+    (this->*entry.handler)(entry);
+
+    return state.r15 == r15 + 2 && state.cpsr.f.thumb && CanContinueBlock();
+  }
+
+  /// Executes a single pre-decoded ARM instruction.
+  /// @returns whether execution may continue with the next instruction of the block.
+  auto ALWAYS_INLINE StepBlock32(BlockInstruction const& entry) -> bool {
+    u32 r15 = state.r15;
+
+    Fetch32();
+    if (CheckCondition(entry.condition)) {
+      (this->*entry.handler)(entry);
+    } else {
+      pipe.fetch_type = Access::Sequential;
+      state.r15 += 4;
+    }
+
+    return state.r15 == r15 + 4 && !state.cpsr.f.thumb && CanContinueBlock();
+  }
+
+  /// Moves the pipeline forward by fetching the Thumb opcode at r15.
+  void ALWAYS_INLINE Fetch16() {
+    pipe.opcode[0] = pipe.opcode[1];
+    code = true;
+    pipe.opcode[1] = ReadHalf(state.r15, pipe.fetch_type);
+    code = false;
+  }
+
+  /// Moves the pipeline forward by fetching the ARM opcode at r15.
+  void ALWAYS_INLINE Fetch32() {
+    pipe.opcode[0] = pipe.opcode[1];
+    code = true;
+    pipe.opcode[1] = ReadWord(state.r15, pipe.fetch_type);
+    code = false;
+  }
+
+  /// @returns whether the block may continue after the current instruction,
+  ///   provided that control flow did not leave it.
+  auto ALWAYS_INLINE CanContinueBlock() -> bool {
+    return !IsIRQServable() && !block_break && scheduler.GetTimestampNow() < block_timestamp_limit;
+  }
+
+  /// @returns whether the IRQ line is asserted and IRQs are not masked, see SignalIRQ().
+  auto ALWAYS_INLINE IsIRQServable() -> bool {
+    return IRQLine() && !state.cpsr.f.mask_irq;
+  }
+
+  bool CheckIdleLoop(Block* block) {
+    if (likely(!idle_loop_detection)) {
+      return false;
+    }
+
+    u32 loop_r15 = block->address + (block->thumb ? 4 : 8);
+
+    if (state.r15 != loop_r15 || state.cpsr.f.thumb != block->thumb ||
+        scheduler.GetTimestampNow() >= block_timestamp_target) {
+      return false;
+    }
+
+    if (block->idle_loop < 0) {
+      if (block->thumb) {
+        block->idle_loop = IdleLoop::Analyze16(*block);
+      } else {
+        block->idle_loop = IdleLoop::Analyze32(*block);
+      }
+    }
+
+    return block->idle_loop;
+  }
+
+  void CompileBlockIfHot(Block* block) {
+    if (jit == nullptr || ++block->hits != JIT::kHotThreshold) {
+      return;
+    }
+
+    if (!jit->Compile(this, block)) {
+      /* The code buffer is exhausted. The block is still in use by RunBlock(),
+       * so it returns now and the next call starts over with an empty cache.
+       */
+      jit_flush = true;
+      block_break = true;
+    }
+  }
+
   auto GetRegisterBankByMode(Mode mode) -> Bank {
     switch (mode) {
       case MODE_USR:
@@ -246,13 +627,18 @@ private:
     return BANK_INVALID;
   }
 
+  void OnLDMUsermodeConflictEnd(int cycles_late) {
+    ldm_usermode_conflict = false;
+  }
+
   #include "handlers/arithmetic.inl"
   #include "handlers/handler16.inl"
   #include "handlers/handler32.inl"
   #include "handlers/memory.inl"
+  #include "handlers/block.inl"
 
   Scheduler& scheduler;
-  MemoryBase* interface;
+  Bus* interface;
   StatusRegister* p_spsr;
   bool ldm_usermode_conflict;
   bool cpu_mode_is_invalid;
@@ -263,10 +649,20 @@ private:
   } pipe;
 
   bool irq_line;
+  bool block_break;
+  u64 block_timestamp_limit;
+  u64 block_timestamp_target;
+  bool idle_loop_detection = false;
+  bool swi_hook = false;
+  Cache block_cache;
+  std::unique_ptr<JIT> jit;
+  bool jit_flush = false; /* the code buffer is full, see CompileBlockIfHot() */
 
   static std::array<bool, 256> s_condition_lut;
   static std::array<Handler16, 1024> s_opcode_lut_16;
   static std::array<Handler32, 4096> s_opcode_lut_32;
+  static std::array<BlockHandler, 1024> s_block_lut_16;
+  static std::array<BlockHandler, 4096> s_block_lut_32;
 };
 
 } // namespace nba::core::arm
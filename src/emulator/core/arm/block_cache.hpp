@@ -0,0 +1,211 @@
+/*
+ * Copyright (C) 2021 fleroviux
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#pragma once
+
+#include <array>
+#include <common/compiler.hpp>
+#include <common/integer.hpp>
+#include <memory>
+#include <vector>
+
+#include "state.hpp"
+
+namespace nba::core::arm {
+
+/** A run of pre-decoded guest instructions which starts at a fixed
+  * address and instruction set (ARM or Thumb).
+  * Each instruction is stored as its handler, its raw opcode and
+  * the operands which are decoded once when the block is built.
+  * Hot blocks may additionally be translated to native code by the JIT.
+  */
+template<typename Core>
+struct BasicBlock {
+  static constexpr int kMaxLength = 64;
+
+  struct Instruction {
+    void (Core::*handler)(Instruction const&);
+    u32 opcode;
+    Condition condition;
+    u8 reg_dst;
+    u8 reg_op1;
+    s8 carry; /* carry out of an immediate operand, -1 if it leaves the carry flag unchanged */
+    u32 imm;  /* immediate operand, load address or branch target */
+  };
+
+  u32 address;
+  bool thumb;
+  u32 generation;
+  int hits = 0;
+  int idle_loop = -1; /* -1 if not analyzed yet, else whether this is an idle loop */
+  bool (*compiled)(Core*) = nullptr; /* returns false if it did not run, see JIT::Compile() */
+  std::vector<Instruction> code;
+
+  /* The block which followed this block when it last ran.
+   * Only valid while no blocks have been dropped since, see BlockCache::GetEpoch().
+   */
+  BasicBlock* next = nullptr;
+  u64 next_epoch = 0;
+};
+
+/** Stores basic blocks keyed by their start address.
+  * The guest address space is split into 4 KiB pages, blocks never
+  * cross a page boundary. For each page we track which 64-byte lines contain
+  * cached code, so that writes to these lines drop all blocks of that page.
+  * Blocks are dropped by incrementing the generation of the page,
+  * so a block is only valid if its generation matches that of its page.
+  */
+template<typename Core>
+struct BlockCache {
+  static constexpr int kPageShift = 12;
+  static constexpr int kPageSize = 1 << kPageShift;
+  static constexpr int kPageCount = 0x10000;
+  static constexpr int kLineShift = 6;
+
+  void Reset() {
+    for (auto& page : pages) {
+      page.reset();
+    }
+    epoch++;
+  }
+
+  /// @returns a counter which is incremented whenever blocks are dropped.
+  auto GetEpoch() const -> u64 {
+    return epoch;
+  }
+
+  auto Get(u32 address, bool thumb) -> BasicBlock<Core>* {
+    auto& page = pages[(address >> kPageShift) & (kPageCount - 1)];
+
+    if (page != nullptr) {
+      auto block = page->Find(address);
+
+      if (block != nullptr && block->generation == page->generation && block->thumb == thumb) {
+        return block;
+      }
+    }
+
+    return nullptr;
+  }
+
+  /// Creates an empty block or reuses the dropped block at the same address.
+  auto Create(u32 address, bool thumb) -> BasicBlock<Core>* {
+    auto& page = pages[(address >> kPageShift) & (kPageCount - 1)];
+
+    if (page == nullptr) {
+      page = std::make_unique<Page>();
+    }
+
+    auto block = page->Find(address);
+
+    if (block == nullptr) {
+      block = page->Insert(address);
+    }
+
+    block->thumb = thumb;
+    block->generation = page->generation;
+    block->hits = 0;
+    block->idle_loop = -1;
+    block->compiled = nullptr;
+    block->code.clear();
+    block->next = nullptr;
+    return block;
+  }
+
+  /// Marks the address range [address_lo, address_hi] as containing cached code.
+  void MarkCode(u32 address_lo, u32 address_hi) {
+    auto& page = pages[(address_lo >> kPageShift) & (kPageCount - 1)];
+
+    for (u32 line = address_lo >> kLineShift; line <= (address_hi >> kLineShift); line++) {
+      page->code_lines |= 1ULL << (line & 63);
+    }
+  }
+
+  /// Drops all blocks of a page if the address lies within a cached code line.
+  /// @returns whether any blocks have been invalidated.
+  auto ALWAYS_INLINE Invalidate(u32 address) -> bool {
+    auto& page = pages[(address >> kPageShift) & (kPageCount - 1)];
+
+    if (likely(page == nullptr) || likely(!(page->code_lines & (1ULL << ((address >> kLineShift) & 63))))) {
+      return false;
+    }
+
+    page->generation++;
+    page->code_lines = 0;
+    epoch++;
+    return true;
+  }
+
+private:
+  /** Open addressing hash table of the blocks which start in a page.
+    * It grows with the number of blocks, so that pages with little code stay small.
+    * Blocks are never removed, only dropped, which keeps pointers to them stable.
+    */
+  struct Page {
+    u32 generation = 0;
+    u64 code_lines = 0;
+    int count = 0;
+    std::vector<std::unique_ptr<BasicBlock<Core>>> slots = std::vector<std::unique_ptr<BasicBlock<Core>>>(8);
+
+    auto Find(u32 address) -> BasicBlock<Core>* {
+      u32 mask = slots.size() - 1;
+
+      for (u32 i = Hash(address) & mask;; i = (i + 1) & mask) {
+        auto block = slots[i].get();
+
+        if (block == nullptr || block->address == address) {
+          return block;
+        }
+      }
+    }
+
+    auto Insert(u32 address) -> BasicBlock<Core>* {
+      if ((count + 1) * 4 > int(slots.size()) * 3) {
+        Grow();
+      }
+
+      auto block = new BasicBlock<Core>();
+
+      block->address = address;
+      Place(std::unique_ptr<BasicBlock<Core>>{block});
+      count++;
+      return block;
+    }
+
+  private:
+    static auto Hash(u32 address) -> u32 {
+      return ((address >> 1) * 0x9E3779B1) >> 16;
+    }
+
+    void Place(std::unique_ptr<BasicBlock<Core>> block) {
+      u32 mask = slots.size() - 1;
+      u32 i = Hash(block->address) & mask;
+
+      while (slots[i] != nullptr) {
+        i = (i + 1) & mask;
+      }
+      slots[i] = std::move(block);
+    }
+
+    void Grow() {
+      auto old_slots = std::move(slots);
+
+      slots = std::vector<std::unique_ptr<BasicBlock<Core>>>(old_slots.size() * 2);
+
+      for (auto& block : old_slots) {
+        if (block != nullptr) {
+          Place(std::move(block));
+        }
+      }
+    }
+  };
+
+  std::array<std::unique_ptr<Page>, kPageCount> pages;
+  u64 epoch = 0;
+};
+
+} // namespace nba::core::arm
@@ -0,0 +1,146 @@
+/*
+ * Copyright (C) 2021 fleroviux
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+/* Handlers of pre-decoded instructions in a basic block, see RunBlock().
+ * Instructions whose operands are decoded once (immediates, literal pool
+ * addresses and branch targets) have their own handlers, all other
+ * instructions call their interpreter handler with the raw opcode.
+ */
+
+template <Handler16 handler>
+void Block_Thumb(BlockInstruction const& entry) {
+  (this->*handler)(entry.opcode);
+}
+
+template <Handler32 handler>
+void Block_ARM(BlockInstruction const& entry) {
+  (this->*handler)(entry.opcode);
+}
+
+template <int dst>
+void Block_Thumb_LoadStoreRelativePC(BlockInstruction const& entry) {
+  pipe.fetch_type = Access::Nonsequential;
+  state.r15 += 2;
+
+  state.reg[dst] = ReadWord(entry.imm, Access::Nonsequential);
+  interface->Idle();
+}
+
+template <int cond>
+void Block_Thumb_ConditionalBranch(BlockInstruction const& entry) {
+  if (CheckCondition(static_cast<Condition>(cond))) {
+    state.r15 = entry.imm;
+    ReloadPipeline16();
+  } else {
+    pipe.fetch_type = Access::Sequential;
+    state.r15 += 2;
+  }
+}
+
+void Block_Thumb_UnconditionalBranch(BlockInstruction const& entry) {
+  state.r15 = entry.imm;
+  ReloadPipeline16();
+}
+
+void Block_Thumb_LongBranchLinkPrefix(BlockInstruction const& entry) {
+  state.r14 = entry.imm;
+  pipe.fetch_type = Access::Sequential;
+  state.r15 += 2;
+}
+
+template <DataOp opcode, bool set_flags>
+void Block_ARM_DataProcessingImm(BlockInstruction const& entry) {
+  int carry = entry.carry >= 0 ? entry.carry : state.cpsr.f.c;
+
+  pipe.fetch_type = Access::Sequential;
+  DoDataProcessing<opcode, set_flags, true>(entry.reg_dst, GetReg(entry.reg_op1), entry.imm, carry);
+}
+
+template <bool pre, bool byte, bool writeback, bool load>
+void Block_ARM_SingleDataTransferImm(BlockInstruction const& entry) {
+  DoSingleDataTransfer<pre, byte, writeback, load>(entry.reg_dst, entry.reg_op1, GetReg(entry.reg_op1), entry.imm);
+}
+
+template <bool link>
+void Block_ARM_BranchAndLink(BlockInstruction const& entry) {
+  if (link) {
+    SetReg(14, state.r15 - 4);
+  }
+
+  state.r15 = entry.imm;
+  ReloadPipeline32();
+}
+
+/// Decodes a Thumb instruction at the given address into a block entry.
+void DecodeBlockInstruction16(BlockInstruction& entry, u32 address, u16 instruction) {
+  entry.handler = s_block_lut_16[instruction >> 6];
+  entry.opcode = instruction;
+  entry.condition = COND_AL;
+  entry.reg_dst = 0;
+  entry.reg_op1 = 0;
+  entry.carry = -1;
+  entry.imm = 0;
+
+  u32 r15 = address + 4;
+
+  if ((instruction & 0xF800) == 0x4800) {
+    // THUMB.6 PC-relative load
+    entry.imm = (r15 & ~2) + ((instruction & 0xFF) << 2);
+  } else if ((instruction & 0xF000) == 0xD000) {
+    // THUMB.16 Conditional branch
+    entry.imm = r15 + (s8(instruction & 0xFF) * 2);
+  } else if ((instruction & 0xF800) == 0xE000) {
+    // THUMB.18 Unconditional branch
+    entry.imm = r15 + (s32(u32(instruction) << 21) >> 20);
+  } else if ((instruction & 0xF800) == 0xF000) {
+    // THUMB.19 Long branch with link, first instruction
+    entry.imm = r15 + (s32(u32(instruction) << 21) >> 9);
+  }
+}
+
+/// Decodes an ARM instruction at the given address into a block entry.
+void DecodeBlockInstruction32(BlockInstruction& entry, u32 address, u32 instruction) {
+  int hash = ((instruction >> 16) & 0xFF0) |
+             ((instruction >>  4) & 0x00F);
+
+  entry.handler = s_block_lut_32[hash];
+  entry.opcode = instruction;
+  entry.condition = static_cast<Condition>(instruction >> 28);
+  entry.reg_dst = (instruction >> 12) & 0xF;
+  entry.reg_op1 = (instruction >> 16) & 0xF;
+  entry.carry = -1;
+  entry.imm = 0;
+
+  switch ((instruction >> 25) & 7) {
+    case 0b001: {
+      // ARM.8 Data processing, immediate operand
+      u32 value = instruction & 0xFF;
+      int shift = ((instruction >> 8) & 0xF) * 2;
+
+      if (shift != 0) {
+        entry.carry = (value >> (shift - 1)) & 1;
+        entry.imm = (value >> shift) | (value << (32 - shift));
+      } else {
+        entry.imm = value;
+      }
+      break;
+    }
+    case 0b010: {
+      // ARM.9 Single data transfer, immediate offset
+      entry.imm = instruction & 0xFFF;
+      if (~instruction & (1 << 23)) {
+        entry.imm = -entry.imm;
+      }
+      break;
+    }
+    case 0b101: {
+      // ARM.12 Branch
+      entry.imm = address + 8 + (s32(instruction << 8) >> 6);
+      break;
+    }
+  }
+}
@@ -562,6 +562,20 @@ void Thumb_ConditionalBranch(u16 instruction) {
 }
 
 void Thumb_SWI(u16 instruction) {
+  if (swi_hook) {
+    u32 r15 = state.r15;
+
+    if (interface->HandleSWI(instruction & 0xFF)) {
+      if (state.r15 == r15) {
+        pipe.fetch_type = Access::Sequential;
+        state.r15 += 2;
+      } else {
+        ReloadPipeline16();
+      }
+      return;
+    }
+  }
+
   // Save current program status register.
   state.spsr[BANK_SVC].v = state.cpsr.v;
 
@@ -609,4 +623,17 @@ void Thumb_LongBranchLink(u16 instruction) {
   }
 }
 
-void Thumb_Undefined(u16 instruction) { }
+void Thumb_Undefined(u16 instruction) {
+  // Save current program status register.
+  state.spsr[BANK_UND].v = state.cpsr.v;
+
+  // Enter UND mode and disable IRQs.
+  SwitchMode(MODE_UND);
+  state.cpsr.f.thumb = 0;
+  state.cpsr.f.mask_irq = 1;
+
+  // Save current program counter and jump to UND exception vector.
+  state.r14 = state.r15 - 2;
+  state.r15 = 0x04;
+  ReloadPipeline32();
+}
@@ -68,6 +68,15 @@ void ARM_DataProcessing(u32 instruction) {
     DoShift(shift_type, op2, shift, carry, shift_imm);
   }
 
+  DoDataProcessing<opcode, set_flags, immediate || shift_imm>(reg_dst, op1, op2, carry);
+}
+
+/* Executes a data processing operation on decoded operands.
+ * advance_r15 is false if the instruction has already incremented r15
+ * for its register specified shift.
+ */
+template <DataOp opcode, bool set_flags, bool advance_r15>
+void DoDataProcessing(int reg_dst, u32 op1, u32 op2, int carry) {
   auto& cpsr = state.cpsr;
   u32 result;
 
@@ -170,10 +179,10 @@ void ARM_DataProcessing(u32 instruction) {
       } else {
         ReloadPipeline32();
       }
-    } else if constexpr (immediate || shift_imm) {
+    } else if constexpr (advance_r15) {
       state.r15 += 4;
     }
-  } else if constexpr (immediate || shift_imm) {
+  } else if constexpr (advance_r15) {
     state.r15 += 4;
   }
 }
@@ -482,13 +491,19 @@ void ARM_SingleDataTransfer(u32 instruction) {
     DoShift(opcode, offset, amount, carry, true);
   }
 
-  pipe.fetch_type = Access::Nonsequential;
-  state.r15 += 4;
-
   if constexpr(!add) {
     offset = -offset;
   }
 
+  DoSingleDataTransfer<pre, byte, writeback, load>(dst, base, address, offset);
+}
+
+/// Executes a single data transfer with a decoded offset, which is negative for subtraction.
+template <bool pre, bool byte, bool writeback, bool load>
+void DoSingleDataTransfer(int dst, int base, u32 address, u32 offset) {
+  pipe.fetch_type = Access::Nonsequential;
+  state.r15 += 4;
+
   if constexpr (pre) {
     address += offset;
   }
@@ -625,9 +640,7 @@ void ARM_BlockDataTransfer(u32 instruction) {
        * register accesses will go to both the user bank and original bank.
        */
       ldm_usermode_conflict = true;
-      scheduler.Add(2, [this](int late) {
-        ldm_usermode_conflict = false;
-      });
+      scheduler.Add(2, EventClass::ARM_ldm_usermode_conflict);
     }
 
     if (transfer_pc) {
@@ -665,6 +678,20 @@ void ARM_Undefined(u32 instruction) {
 }
 
 void ARM_SWI(u32 instruction) {
+  if (swi_hook) {
+    u32 r15 = state.r15;
+
+    if (interface->HandleSWI((instruction >> 16) & 0xFF)) {
+      if (state.r15 == r15) {
+        pipe.fetch_type = Access::Sequential;
+        state.r15 += 4;
+      } else {
+        ReloadPipeline32();
+      }
+      return;
+    }
+  }
+
   // Save current program status register.
   state.spsr[BANK_SVC].v = state.cpsr.v;
 
@@ -73,3 +73,7 @@ void WriteHalf(u32 address, u16 value, Access access) {
 void WriteWord(u32 address, u32 value, Access access) {
   interface->WriteWord(address, value, access);
 }
+
+void Idle() {
+  interface->Idle();
+}
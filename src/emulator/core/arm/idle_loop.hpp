@@ -0,0 +1,323 @@
+/*
+ * Copyright (C) 2021 fleroviux
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#pragma once
+
+#include <common/integer.hpp>
+
+#include "state.hpp"
+
+namespace nba::core::arm {
+
+/** Detection of idle loops (busy-waits), i.e. short loops that only load
+  * from memory, compute and branch back to their start, like:
+  *
+  *   loop: ldrh r0, [r1]
+  *         cmp  r0, #160
+  *         bne  loop
+  *
+  * A loop is considered idle if no register (or flag) which the loop writes
+  * is read before it has been written in the same iteration.
+  * Then each iteration computes the same state from the same memory contents,
+  * and the loop cannot make progress until memory changes, which only
+  * happens on a scheduler event (or through an IRQ or DMA).
+  */
+struct IdleLoop {
+  static constexpr int kMaxLength = 16;
+
+  /// Checks whether a Thumb block which branched back to its start is an idle loop.
+  template<typename Block>
+  static bool Analyze16(Block const& block) {
+    return Analyze(block, 2, [](u32 opcode, u32 address) {
+      return Decode16(u16(opcode), address);
+    });
+  }
+
+  /// Checks whether an ARM block which branched back to its start is an idle loop.
+  template<typename Block>
+  static bool Analyze32(Block const& block) {
+    return Analyze(block, 4, [](u32 opcode, u32 address) {
+      return Decode32(opcode, address);
+    });
+  }
+
+private:
+  /* Bits 0 - 15 are the general purpose registers, followed by the flags. */
+  enum Resource : u32 {
+    kFlagN = 1 << 16,
+    kFlagZ = 1 << 17,
+    kFlagC = 1 << 18,
+    kFlagV = 1 << 19,
+    kFlagNZ = kFlagN | kFlagZ,
+    kFlagNZCV = kFlagN | kFlagZ | kFlagC | kFlagV
+  };
+
+  struct Info {
+    bool valid = false;
+    bool branch = false;
+    bool conditional = false;
+    u32 target = 0;
+    u32 reads = 0;
+    u32 writes = 0;
+  };
+
+  struct Liveness {
+    u32 live_in = 0;
+    u32 written = 0;
+
+    void Step(Info const& info) {
+      live_in |= info.reads & ~written;
+      written |= info.writes;
+    }
+
+    bool IsIdempotent() const {
+      return (live_in & written) == 0;
+    }
+  };
+
+  /* We do not know which of the branches to the block start was taken,
+   * so the loop must be idempotent at each of them.
+   */
+  template<typename Block, typename Decoder>
+  static bool Analyze(Block const& block, int opcode_size, Decoder decode) {
+    Liveness liveness;
+    bool loops = false;
+    int length = int(block.code.size());
+
+    for (int i = 0; i < length && i < kMaxLength; i++) {
+      auto info = decode(block.code[i].opcode, block.address + i * opcode_size);
+
+      if (!info.valid) {
+        return false;
+      }
+
+      liveness.Step(info);
+
+      if (info.branch) {
+        if (info.target == block.address) {
+          if (!liveness.IsIdempotent()) {
+            return false;
+          }
+          loops = true;
+        }
+        if (!info.conditional) {
+          return loops;
+        }
+      }
+    }
+
+    return loops && length <= kMaxLength;
+  }
+
+  static auto Reg(int reg) -> u32 {
+    return 1 << reg;
+  }
+
+  static auto ConditionReads(int condition) -> u32 {
+    switch (condition) {
+      case COND_EQ: case COND_NE: return kFlagZ;
+      case COND_CS: case COND_CC: return kFlagC;
+      case COND_MI: case COND_PL: return kFlagN;
+      case COND_VS: case COND_VC: return kFlagV;
+      case COND_HI: case COND_LS: return kFlagC | kFlagZ;
+      case COND_GE: case COND_LT: return kFlagN | kFlagV;
+      case COND_GT: case COND_LE: return kFlagN | kFlagZ | kFlagV;
+    }
+    return 0;
+  }
+
+  static auto Decode16(u16 opcode, u32 address) -> Info {
+    Info info;
+
+    info.valid = true;
+
+    if ((opcode & 0xF800) == 0x1800) {
+      // Add/subtract (register or 3-bit immediate)
+      info.reads = Reg((opcode >> 3) & 7);
+      if (~opcode & 0x0400) {
+        info.reads |= Reg((opcode >> 6) & 7);
+      }
+      info.writes = Reg(opcode & 7) | kFlagNZCV;
+    } else if ((opcode & 0xE000) == 0x0000) {
+      // Move shifted register. LSL #0 leaves the carry flag untouched.
+      info.reads = Reg((opcode >> 3) & 7);
+      info.writes = Reg(opcode & 7) | kFlagNZ;
+      if ((opcode & 0x1FC0) != 0) {
+        info.writes |= kFlagC;
+      }
+    } else if ((opcode & 0xE000) == 0x2000) {
+      // Move/compare/add/subtract 8-bit immediate
+      auto reg = Reg((opcode >> 8) & 7);
+      switch ((opcode >> 11) & 3) {
+        case 0: info.writes = reg | kFlagNZ; break;
+        case 1: info.reads = reg; info.writes = kFlagNZCV; break;
+        default: info.reads = reg; info.writes = reg | kFlagNZCV; break;
+      }
+    } else if ((opcode & 0xFC00) == 0x4000) {
+      // ALU operations
+      auto rd = Reg(opcode & 7);
+      auto rs = Reg((opcode >> 3) & 7);
+      switch ((opcode >> 6) & 15) {
+        case 0x0: case 0x1: case 0xC: case 0xE: info.reads = rd | rs; info.writes = rd | kFlagNZ; break;
+        case 0x2: case 0x3: case 0x4: case 0x7: info.reads = rd | rs | kFlagC; info.writes = rd | kFlagNZ | kFlagC; break;
+        case 0x5: case 0x6: info.reads = rd | rs | kFlagC; info.writes = rd | kFlagNZCV; break;
+        case 0x8: info.reads = rd | rs; info.writes = kFlagNZ; break;
+        case 0x9: info.reads = rs; info.writes = rd | kFlagNZCV; break;
+        case 0xA: case 0xB: info.reads = rd | rs; info.writes = kFlagNZCV; break;
+        case 0xD: info.reads = rd | rs; info.writes = rd | kFlagNZ | kFlagC; break;
+        case 0xF: info.reads = rs; info.writes = rd | kFlagNZ; break;
+      }
+    } else if ((opcode & 0xFC00) == 0x4400) {
+      // Hi register operations, BX is not supported.
+      int rd = (opcode & 7) | ((opcode >> 4) & 8);
+      auto rs = Reg((opcode >> 3) & 15);
+      switch ((opcode >> 8) & 3) {
+        case 0: info.reads = Reg(rd) | rs; info.writes = Reg(rd); break;
+        case 1: info.reads = Reg(rd) | rs; info.writes = kFlagNZCV; break;
+        case 2: info.reads = rs; info.writes = Reg(rd); break;
+        case 3: info.valid = false; break;
+      }
+      if (info.writes & Reg(15)) {
+        info.valid = false;
+      }
+    } else if ((opcode & 0xF800) == 0x4800) {
+      // PC-relative load
+      info.writes = Reg((opcode >> 8) & 7);
+    } else if ((opcode & 0xF200) == 0x5000) {
+      // Load/store with register offset, only loads are supported.
+      info.valid = opcode & 0x0800;
+      info.reads = Reg((opcode >> 3) & 7) | Reg((opcode >> 6) & 7);
+      info.writes = Reg(opcode & 7);
+    } else if ((opcode & 0xF200) == 0x5200) {
+      // Load/store sign-extended byte/halfword, STRH is not supported.
+      info.valid = (opcode & 0x0C00) != 0;
+      info.reads = Reg((opcode >> 3) & 7) | Reg((opcode >> 6) & 7);
+      info.writes = Reg(opcode & 7);
+    } else if ((opcode & 0xE000) == 0x6000 || (opcode & 0xF000) == 0x8000) {
+      // Load/store (half)word/byte with immediate offset
+      info.valid = opcode & 0x0800;
+      info.reads = Reg((opcode >> 3) & 7);
+      info.writes = Reg(opcode & 7);
+    } else if ((opcode & 0xF000) == 0x9000) {
+      // SP-relative load/store
+      info.valid = opcode & 0x0800;
+      info.reads = Reg(13);
+      info.writes = Reg((opcode >> 8) & 7);
+    } else if ((opcode & 0xF000) == 0xA000) {
+      // Load address
+      info.reads = (opcode & 0x0800) ? Reg(13) : 0;
+      info.writes = Reg((opcode >> 8) & 7);
+    } else if ((opcode & 0xF000) == 0xD000 && (opcode & 0x0E00) != 0x0E00) {
+      // Conditional branch
+      info.branch = true;
+      info.conditional = true;
+      info.reads = ConditionReads((opcode >> 8) & 15);
+      info.target = address + 4 + (s32(s8(opcode & 0xFF)) << 1);
+    } else if ((opcode & 0xF800) == 0xE000) {
+      // Unconditional branch
+      info.branch = true;
+      info.target = address + 4 + ((s32(u32(opcode) << 21) >> 21) << 1);
+    } else {
+      info.valid = false;
+    }
+
+    return info;
+  }
+
+  static auto Decode32(u32 opcode, u32 address) -> Info {
+    Info info;
+    int condition = opcode >> 28;
+
+    if (condition == COND_NV) {
+      return info;
+    }
+
+    info.valid = true;
+
+    if ((opcode & 0x0F000000) == 0x0A000000) {
+      // Branch, BL is not supported.
+      info.branch = true;
+      info.target = address + 8 + ((s32(opcode << 8) >> 8) << 2);
+    } else if ((opcode & 0x0E000090) == 0x00000090 && (opcode & 0x00000060) != 0) {
+      // Halfword and signed data transfer, pre-indexed loads without writeback only.
+      info.valid = (opcode & 0x01300000) == 0x01100000;
+      info.reads = Reg((opcode >> 16) & 15);
+      if (~opcode & 0x00400000) {
+        info.reads |= Reg(opcode & 15);
+      }
+      info.writes = Reg((opcode >> 12) & 15);
+    } else if ((opcode & 0x0C000000) == 0x00000000) {
+      // Data processing with an immediate or an immediate-shifted register.
+      // Register-shifted operands, multiplies, swaps and PSR transfers are not supported.
+      int op = (opcode >> 21) & 15;
+      bool set_flags = opcode & 0x00100000;
+      bool immediate = opcode & 0x02000000;
+
+      if ((!immediate && (opcode & 0x10)) || (!set_flags && op >= 8 && op <= 11)) {
+        info.valid = false;
+        return info;
+      }
+
+      if (op != 13 && op != 15) {
+        info.reads |= Reg((opcode >> 16) & 15);
+      }
+      if (!immediate) {
+        info.reads |= Reg(opcode & 15);
+        if ((opcode & 0x00000FE0) == 0x00000060) {
+          info.reads |= kFlagC; // RRX
+        }
+      }
+      if (op >= 5 && op <= 7) {
+        info.reads |= kFlagC; // ADC, SBC, RSC
+      }
+
+      if (op < 8 || op > 11) {
+        info.writes |= Reg((opcode >> 12) & 15);
+      }
+      if (set_flags) {
+        bool arithmetic = (op >= 2 && op <= 7) || op == 10 || op == 11;
+        if (arithmetic) {
+          info.writes |= kFlagNZCV;
+        } else {
+          info.writes |= kFlagNZ;
+          // The shifter carry is written unless the operand is not rotated or shifted (LSL #0).
+          if (immediate ? (opcode & 0x00000F00) != 0 : (opcode & 0x00000FF0) != 0) {
+            info.writes |= kFlagC;
+          }
+        }
+      }
+    } else if ((opcode & 0x0C000000) == 0x04000000) {
+      // Single data transfer, pre-indexed loads without writeback only.
+      info.valid = (opcode & 0x01300000) == 0x01100000 && (opcode & 0x02000010) != 0x02000010;
+      info.reads = Reg((opcode >> 16) & 15);
+      if (opcode & 0x02000000) {
+        info.reads |= Reg(opcode & 15);
+        if ((opcode & 0x00000FF0) == 0x00000060) {
+          info.reads |= kFlagC; // RRX
+        }
+      }
+      info.writes = Reg((opcode >> 12) & 15);
+    } else {
+      info.valid = false;
+    }
+
+    if (info.writes & Reg(15)) {
+      info.valid = false;
+    }
+
+    if (condition != COND_AL) {
+      info.conditional = true;
+      info.reads |= ConditionReads(condition);
+      // A conditional instruction may keep the previous values.
+      info.reads |= info.writes;
+    }
+
+    return info;
+  }
+};
+
+} // namespace nba::core::arm
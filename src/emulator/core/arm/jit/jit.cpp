@@ -0,0 +1,769 @@
+/*
+ * Copyright (C) 2021 fleroviux
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#include <common/log.hpp>
+
+#include "jit.hpp"
+
+#if defined(__x86_64__) && defined(__unix__)
+  #define NBA_JIT_X64_SYSV
+  #include <sys/mman.h>
+  #include <unistd.h>
+#endif
+
+namespace nba::core::arm {
+
+using X64 = X64Emitter;
+
+namespace {
+
+/* ARM data processing opcodes, the Thumb ALU opcodes use the same numbering
+ * except for NEG (TEQ), the shifts and MUL.
+ */
+enum DataOp {
+  AND = 0, EOR = 1, SUB = 2,  RSB = 3,  ADD = 4,  ADC = 5,  SBC = 6, RSC = 7,
+  TST = 8, TEQ = 9, CMP = 10, CMN = 11, ORR = 12, MOV = 13, BIC = 14, MVN = 15
+};
+
+} // namespace
+
+static constexpr u32 kNonsequential = u32(MemoryBase::Access::Nonsequential);
+static constexpr u32 kSequential = u32(MemoryBase::Access::Sequential);
+
+/* Upper bound of the code emitted per guest instruction and per block. */
+static constexpr size_t kMaxOperationSize = 256;
+static constexpr size_t kMaxBlockOverhead = 64;
+
+JIT::JIT(size_t buffer_size) : buffer_size(buffer_size) {
+#ifdef NBA_JIT_X64_SYSV
+  auto memory = mmap(nullptr, buffer_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+  if (memory == MAP_FAILED) {
+    LOG_ERROR("JIT: failed to allocate the code buffer.");
+  } else {
+    buffer = static_cast<u8*>(memory);
+    page_size = size_t(sysconf(_SC_PAGESIZE));
+  }
+#endif
+}
+
+JIT::~JIT() {
+#ifdef NBA_JIT_X64_SYSV
+  if (buffer != nullptr) {
+    munmap(buffer, buffer_size);
+  }
+#endif
+}
+
+auto JIT::IsSupported() -> bool {
+#ifdef NBA_JIT_X64_SYSV
+  return true;
+#else
+  return false;
+#endif
+}
+
+/* Code which was emitted before stays mapped, but is overwritten
+ * by the next blocks. Their pages are made writable when that happens.
+ */
+void JIT::Reset() {
+  offset = 0;
+}
+
+/* The emitted function is called with the core in rdi, which is kept in rbx.
+ * For each instruction the opcode is fetched, then the instruction is either
+ * executed natively or by calling its block handler.
+ * Before each instruction the function checks, like StepBlock16() and StepBlock32(),
+ * that the previous one did not leave the block and that the block may continue.
+ * Native instructions never leave the block unless they branch,
+ * so only the handlers need to check r15 and the Thumb bit.
+ */
+auto JIT::EmitBlock(Context const& context, u32 address, bool thumb) -> void* {
+#ifdef NBA_JIT_X64_SYSV
+  size_t capacity = kMaxBlockOverhead + operations.size() * kMaxOperationSize;
+
+  if (buffer == nullptr || offset + capacity > buffer_size) {
+    return nullptr;
+  }
+
+  size_t page_lo = offset & ~(page_size - 1);
+  size_t page_hi = (offset + capacity + page_size - 1) & ~(page_size - 1);
+
+  if (mprotect(buffer + page_lo, page_hi - page_lo, PROT_READ | PROT_WRITE) != 0) {
+    LOG_ERROR("JIT: failed to make the code buffer writable.");
+    return nullptr;
+  }
+
+  auto code = buffer + offset;
+  auto x64 = X64Emitter{code};
+  bool previous_native = false;
+
+  this->context = &context;
+  exits.clear();
+
+  x64.EnterBlock();
+
+  size_t bail_out[2] {};
+
+  if (!thumb) {
+    x64.CompareByteZero(context.ldm_usermode_conflict);
+    bail_out[0] = x64.JumpIf(X64::CC_NZ);
+    x64.CompareByteZero(context.cpu_mode_is_invalid);
+    bail_out[1] = x64.JumpIf(X64::CC_NZ);
+  }
+
+  for (size_t i = 0; i < operations.size(); i++) {
+    auto& op = operations[i];
+    bool check = i != 0 && previous_native;
+    size_t start = x64.GetSize();
+
+    if (check) {
+      x64.Call(context.check_and_fetch);
+      x64.TestResult();
+      exits.push_back(x64.JumpIf(X64::CC_Z));
+    } else {
+      x64.Call(context.fetch);
+    }
+
+    if (thumb) {
+      previous_native = EmitThumb(x64, op, address + i * 2);
+    } else {
+      previous_native = EmitARM(x64, op, address + i * 4);
+    }
+
+    if (!previous_native) {
+      x64.Rewind(start);
+      if (check) {
+        exits.pop_back();
+        x64.Call(context.can_continue);
+        x64.TestResult();
+        exits.push_back(x64.JumpIf(X64::CC_Z));
+      }
+      x64.MoveImm64(X64::ESI, op.entry);
+      x64.Call(context.step);
+      x64.TestResult();
+      exits.push_back(x64.JumpIf(X64::CC_Z));
+    }
+  }
+
+  for (auto label : exits) {
+    x64.Bind(label);
+  }
+  x64.LeaveBlock(1);
+
+  if (!thumb) {
+    x64.Bind(bail_out[0]);
+    x64.Bind(bail_out[1]);
+    x64.LeaveBlock(0);
+  }
+
+  offset += x64.GetSize();
+
+  if (mprotect(buffer + page_lo, page_hi - page_lo, PROT_READ | PROT_EXEC) != 0) {
+    LOG_ERROR("JIT: failed to make the code buffer executable.");
+    return nullptr;
+  }
+
+  return code;
+#else
+  return nullptr;
+#endif
+}
+
+auto JIT::EmitThumb(X64Emitter& x64, Operation const& op, u32 address) -> bool {
+  u32 instruction = op.opcode;
+  u32 r15 = address + 4;
+
+  auto advance = [&](u32 fetch_type) {
+    x64.StoreImm(context->fetch_type, fetch_type);
+    x64.StoreImm(RegOffset(15), r15 + 2);
+  };
+
+  int dst = instruction & 7;
+  int src = (instruction >> 3) & 7;
+
+  switch (instruction >> 12) {
+    case 0x0:
+    case 0x1: {
+      if ((instruction & 0x1800) != 0x1800) {
+        // THUMB.1 Move shifted register
+        int shift = (instruction >> 11) & 3;
+        int amount = (instruction >> 6) & 31;
+
+        if (shift != 0 && amount == 0) {
+          return false;
+        }
+
+        advance(kSequential);
+        x64.Load(X64::EAX, RegOffset(src));
+        if (amount == 0) {
+          x64.Store(RegOffset(dst), X64::EAX);
+          x64.Test(X64::EAX, X64::EAX);
+          EmitSetFlags(x64, Carry::Keep, false);
+        } else {
+          x64.ShiftImm(shift == 0 ? X64::SHL : (shift == 1 ? X64::SHR : X64::SAR), X64::EAX, amount);
+          x64.Store(RegOffset(dst), X64::EAX);
+          EmitSetFlags(x64, Carry::Flag, false);
+        }
+        return true;
+      }
+
+      // THUMB.2 Add/subtract
+      int field3 = (instruction >> 6) & 7;
+
+      advance(kSequential);
+      x64.Load(X64::EAX, RegOffset(src));
+      if (instruction & (1 << 10)) {
+        x64.MoveImm(X64::ECX, field3);
+      } else {
+        x64.Load(X64::ECX, RegOffset(field3));
+      }
+      EmitDataProcessing(x64, (instruction & (1 << 9)) ? SUB : ADD, true, dst, Carry::Keep);
+      return true;
+    }
+    case 0x2:
+    case 0x3: {
+      // THUMB.3 Move/compare/add/subtract immediate
+      static constexpr int kOpcodes[4] { MOV, CMP, ADD, SUB };
+
+      int opcode = kOpcodes[(instruction >> 11) & 3];
+      int reg = (instruction >> 8) & 7;
+
+      advance(kSequential);
+      x64.Load(X64::EAX, RegOffset(reg));
+      x64.MoveImm(X64::ECX, instruction & 0xFF);
+      EmitDataProcessing(x64, opcode, true, opcode == CMP ? -1 : reg, Carry::Keep);
+      return true;
+    }
+    case 0x4: {
+      if ((instruction & 0xFC00) == 0x4000) {
+        // THUMB.4 ALU operations, except for shifts by register and MUL
+        int opcode = (instruction >> 6) & 15;
+
+        switch (opcode) {
+          case 2: case 3: case 4: case 7: case 13: {
+            return false;
+          }
+          case 9: {
+            // NEG rD, rS
+            advance(kSequential);
+            x64.Load(X64::EAX, RegOffset(src));
+            x64.MoveImm(X64::ECX, 0);
+            EmitDataProcessing(x64, RSB, true, dst, Carry::Keep);
+            return true;
+          }
+        }
+
+        bool compare = opcode == TST || opcode == CMP || opcode == CMN;
+
+        advance(kSequential);
+        x64.Load(X64::EAX, RegOffset(dst));
+        x64.Load(X64::ECX, RegOffset(src));
+        EmitDataProcessing(x64, opcode, true, compare ? -1 : dst, Carry::Keep);
+        return true;
+      }
+
+      if ((instruction & 0xFC00) == 0x4400) {
+        // THUMB.5 Hi register operations, except for BX and writes to r15
+        int opcode = (instruction >> 8) & 3;
+
+        dst |= (instruction >> 4) & 8;
+        src |= (instruction >> 3) & 8;
+
+        if (opcode == 3 || (dst == 15 && opcode != 1)) {
+          return false;
+        }
+
+        advance(kSequential);
+        EmitReadReg(x64, X64::EAX, dst, r15);
+        EmitReadReg(x64, X64::ECX, src, r15);
+
+        switch (opcode) {
+          case 0: EmitDataProcessing(x64, ADD, false, dst, Carry::Keep); break;
+          case 1: EmitDataProcessing(x64, CMP, true, -1, Carry::Keep); break;
+          case 2: EmitDataProcessing(x64, MOV, false, dst, Carry::Keep); break;
+        }
+        return true;
+      }
+
+      // THUMB.6 PC-relative load
+      advance(kNonsequential);
+      x64.MoveImm(X64::ESI, op.imm);
+      EmitLoad(x64, LoadType::Word, (instruction >> 8) & 7);
+      return true;
+    }
+    case 0x5: {
+      // THUMB.7 Load/store with register offset
+      // THUMB.8 Load/store sign-extended byte/halfword
+      static constexpr int kTypes[2][4] {
+        { int(StoreType::Word), int(StoreType::Byte), int(LoadType::Word), int(LoadType::Byte) },
+        { int(StoreType::Half), int(LoadType::ByteSigned), int(LoadType::Half), int(LoadType::HalfSigned) }
+      };
+
+      int opcode = (instruction >> 10) & 3;
+      int type = kTypes[(instruction >> 9) & 1][opcode];
+
+      advance(kNonsequential);
+      x64.Load(X64::ESI, RegOffset(src));
+      x64.Load(X64::ECX, RegOffset((instruction >> 6) & 7));
+      x64.Op(X64::ADD, X64::ESI, X64::ECX);
+
+      if (opcode == 0) {
+        EmitStore(x64, StoreType(type), dst);
+      } else if (opcode == 1 && (~instruction & (1 << 9))) {
+        EmitStore(x64, StoreType::Byte, dst);
+      } else {
+        EmitLoad(x64, LoadType(type), dst);
+      }
+      return true;
+    }
+    case 0x6:
+    case 0x7: {
+      // THUMB.9 Load/store with immediate offset
+      bool byte = instruction & (1 << 12);
+      bool load = instruction & (1 << 11);
+      u32 imm = (instruction >> 6) & 31;
+
+      advance(kNonsequential);
+      x64.Load(X64::ESI, RegOffset(src));
+      x64.OpImm(X64::ADD, X64::ESI, byte ? imm : imm * 4);
+
+      if (load) {
+        EmitLoad(x64, byte ? LoadType::Byte : LoadType::Word, dst);
+      } else {
+        EmitStore(x64, byte ? StoreType::Byte : StoreType::Word, dst);
+      }
+      return true;
+    }
+    case 0x8: {
+      // THUMB.10 Load/store halfword
+      advance(kNonsequential);
+      x64.Load(X64::ESI, RegOffset(src));
+      x64.OpImm(X64::ADD, X64::ESI, ((instruction >> 6) & 31) * 2);
+
+      if (instruction & (1 << 11)) {
+        EmitLoad(x64, LoadType::Half, dst);
+      } else {
+        EmitStore(x64, StoreType::Half, dst);
+      }
+      return true;
+    }
+    case 0x9: {
+      // THUMB.11 SP-relative load/store
+      int reg = (instruction >> 8) & 7;
+
+      advance(kNonsequential);
+      x64.Load(X64::ESI, RegOffset(13));
+      x64.OpImm(X64::ADD, X64::ESI, (instruction & 0xFF) * 4);
+
+      if (instruction & (1 << 11)) {
+        EmitLoad(x64, LoadType::Word, reg);
+      } else {
+        EmitStore(x64, StoreType::Word, reg);
+      }
+      return true;
+    }
+    case 0xA: {
+      // THUMB.12 Load address
+      int reg = (instruction >> 8) & 7;
+      u32 imm = (instruction & 0xFF) * 4;
+
+      advance(kSequential);
+      if (instruction & (1 << 11)) {
+        x64.Load(X64::EAX, RegOffset(13));
+        x64.OpImm(X64::ADD, X64::EAX, imm);
+      } else {
+        x64.MoveImm(X64::EAX, (r15 & ~2) + imm);
+      }
+      x64.Store(RegOffset(reg), X64::EAX);
+      return true;
+    }
+    case 0xB: {
+      if ((instruction & 0xFF00) != 0xB000) {
+        return false;
+      }
+
+      // THUMB.13 Add offset to stack pointer
+      u32 imm = (instruction & 0x7F) * 4;
+
+      advance(kSequential);
+      x64.Load(X64::EAX, RegOffset(13));
+      x64.OpImm(X64::ADD, X64::EAX, (instruction & (1 << 7)) ? -imm : imm);
+      x64.Store(RegOffset(13), X64::EAX);
+      return true;
+    }
+    case 0xD: {
+      // THUMB.16 Conditional branch
+      int condition = (instruction >> 8) & 15;
+
+      if (condition >= COND_AL) {
+        return false;
+      }
+
+      auto not_taken = EmitCondition(x64, condition);
+      x64.StoreImm(RegOffset(15), op.imm);
+      EmitBranch(x64);
+      x64.Bind(not_taken);
+      advance(kSequential);
+      return true;
+    }
+    case 0xE: {
+      if (instruction & (1 << 11)) {
+        return false;
+      }
+
+      // THUMB.18 Unconditional branch
+      x64.StoreImm(RegOffset(15), op.imm);
+      EmitBranch(x64);
+      return true;
+    }
+    case 0xF: {
+      // THUMB.19 Long branch with link
+      if (~instruction & (1 << 11)) {
+        advance(kSequential);
+        x64.StoreImm(RegOffset(14), op.imm);
+      } else {
+        x64.Load(X64::EAX, RegOffset(14));
+        x64.OpImm(X64::ADD, X64::EAX, (instruction & 0x7FF) * 2);
+        x64.OpImm(X64::AND, X64::EAX, ~1);
+        x64.Store(RegOffset(15), X64::EAX);
+        x64.StoreImm(RegOffset(14), (r15 - 2) | 1);
+        EmitBranch(x64);
+      }
+      return true;
+    }
+  }
+
+  return false;
+}
+
+auto JIT::EmitARM(X64Emitter& x64, Operation const& op, u32 address) -> bool {
+  u32 instruction = op.opcode;
+  u32 r15 = address + 8;
+  int condition = instruction >> 28;
+  int reg_dst = (instruction >> 12) & 15;
+  int reg_op1 = (instruction >> 16) & 15;
+
+  // Check whether the instruction can be emitted, before anything is emitted.
+  switch ((instruction >> 25) & 7) {
+    case 0b000: {
+      // ARM.8 Data processing, register operand shifted by an immediate
+      int shift_type = (instruction >> 5) & 3;
+      int amount = (instruction >> 7) & 31;
+
+      if ((instruction & (1 << 4)) || (amount == 0 && shift_type != 0)) {
+        return false;
+      }
+    }
+    [[fallthrough]];
+    case 0b001: {
+      // ARM.8 Data processing, except for PSR transfers and writes to r15
+      int opcode = (instruction >> 21) & 15;
+      bool set_flags = instruction & (1 << 20);
+
+      if (reg_dst == 15 || (!set_flags && opcode >= TST && opcode <= CMN)) {
+        return false;
+      }
+      break;
+    }
+    case 0b010: {
+      // ARM.9 Single data transfer, immediate offset
+      bool pre = instruction & (1 << 24);
+      bool writeback = instruction & (1 << 21);
+
+      if (reg_dst == 15 || ((writeback || !pre) && reg_op1 == 15)) {
+        return false;
+      }
+      break;
+    }
+    case 0b101: {
+      // ARM.12 Branch
+      break;
+    }
+    default: {
+      return false;
+    }
+  }
+
+  size_t not_executed = 0;
+
+  if (condition != COND_AL) {
+    not_executed = EmitCondition(x64, condition);
+  }
+
+  switch ((instruction >> 25) & 7) {
+    case 0b000:
+    case 0b001: {
+      int opcode = (instruction >> 21) & 15;
+      bool set_flags = instruction & (1 << 20);
+      bool compare = opcode >= TST && opcode <= CMN;
+      auto carry = Carry::Keep;
+
+      x64.StoreImm(context->fetch_type, kSequential);
+      x64.StoreImm(RegOffset(15), r15 + 4);
+
+      if (instruction & (1 << 25)) {
+        x64.MoveImm(X64::ECX, op.imm);
+        if (op.carry >= 0) {
+          carry = op.carry ? Carry::Set : Carry::Clear;
+        }
+      } else {
+        static constexpr X64::Shift kShifts[4] { X64::SHL, X64::SHR, X64::SAR, X64::ROR };
+
+        int amount = (instruction >> 7) & 31;
+
+        EmitReadReg(x64, X64::ECX, instruction & 15, r15);
+        if (amount != 0) {
+          x64.ShiftImm(kShifts[(instruction >> 5) & 3], X64::ECX, amount);
+          x64.SetCC(X64::CC_C, X64::EDX);
+          carry = Carry::EDX;
+        }
+      }
+
+      if (opcode != MOV && opcode != MVN) {
+        EmitReadReg(x64, X64::EAX, reg_op1, r15);
+      }
+
+      EmitDataProcessing(x64, opcode, set_flags, compare ? -1 : reg_dst, carry);
+      break;
+    }
+    case 0b010: {
+      bool pre = instruction & (1 << 24);
+      bool byte = instruction & (1 << 22);
+      bool writeback = instruction & (1 << 21);
+      bool load = instruction & (1 << 20);
+
+      x64.StoreImm(context->fetch_type, kNonsequential);
+      x64.StoreImm(RegOffset(15), r15 + 4);
+
+      if (reg_op1 == 15) {
+        x64.MoveImm(X64::ESI, r15 + op.imm);
+      } else {
+        x64.Load(X64::ESI, RegOffset(reg_op1));
+        if (pre) {
+          x64.OpImm(X64::ADD, X64::ESI, op.imm);
+        }
+      }
+
+      if (load) {
+        x64.Call(context->load[int(byte ? LoadType::Byte : LoadType::Word)]);
+      } else {
+        x64.Load(X64::EDX, RegOffset(reg_dst));
+        x64.Call(context->store[int(byte ? StoreType::Byte : StoreType::Word)]);
+      }
+
+      if (writeback || !pre) {
+        x64.Load(X64::ECX, RegOffset(reg_op1));
+        x64.OpImm(X64::ADD, X64::ECX, op.imm);
+        x64.Store(RegOffset(reg_op1), X64::ECX);
+      }
+
+      if (load) {
+        x64.Store(RegOffset(reg_dst), X64::EAX);
+      }
+      break;
+    }
+    case 0b101: {
+      if (instruction & (1 << 24)) {
+        x64.StoreImm(RegOffset(14), r15 - 4);
+      }
+      x64.StoreImm(RegOffset(15), op.imm);
+      EmitBranch(x64);
+      break;
+    }
+  }
+
+  if (condition != COND_AL) {
+    auto executed = x64.Jump();
+
+    x64.Bind(not_executed);
+    x64.StoreImm(context->fetch_type, kSequential);
+    x64.StoreImm(RegOffset(15), r15 + 4);
+    x64.Bind(executed);
+  }
+
+  return true;
+}
+
+/* Expects the first operand in eax and the second operand in ecx. */
+void JIT::EmitDataProcessing(X64Emitter& x64, int opcode, bool set_flags, int reg_dst, Carry carry) {
+  enum { Logical, Addition, Subtraction } type = Logical;
+
+  switch (opcode) {
+    case AND:
+    case TST: x64.Op(X64::AND, X64::EAX, X64::ECX); break;
+    case EOR:
+    case TEQ: x64.Op(X64::XOR, X64::EAX, X64::ECX); break;
+    case ORR: x64.Op(X64::OR, X64::EAX, X64::ECX); break;
+    case BIC: {
+      x64.Not(X64::ECX);
+      x64.Op(X64::AND, X64::EAX, X64::ECX);
+      break;
+    }
+    case MOV:
+    case MVN: {
+      if (opcode == MVN) {
+        x64.Not(X64::ECX);
+      }
+      x64.Move(X64::EAX, X64::ECX);
+      if (set_flags) {
+        x64.Test(X64::EAX, X64::EAX);
+      }
+      break;
+    }
+    case ADD:
+    case CMN: {
+      x64.Op(X64::ADD, X64::EAX, X64::ECX);
+      type = Addition;
+      break;
+    }
+    case ADC: {
+      x64.BitTest(context->cpsr, 29);
+      x64.Op(X64::ADC, X64::EAX, X64::ECX);
+      type = Addition;
+      break;
+    }
+    case SUB:
+    case CMP: {
+      x64.Op(X64::SUB, X64::EAX, X64::ECX);
+      type = Subtraction;
+      break;
+    }
+    case SBC: {
+      x64.BitTest(context->cpsr, 29);
+      x64.ComplementCarry();
+      x64.Op(X64::SBB, X64::EAX, X64::ECX);
+      type = Subtraction;
+      break;
+    }
+    case RSB:
+    case RSC: {
+      if (opcode == RSC) {
+        x64.BitTest(context->cpsr, 29);
+        x64.ComplementCarry();
+        x64.Op(X64::SBB, X64::ECX, X64::EAX);
+      } else {
+        x64.Op(X64::SUB, X64::ECX, X64::EAX);
+      }
+      x64.Move(X64::EAX, X64::ECX);
+      type = Subtraction;
+      break;
+    }
+  }
+
+  // Neither mov nor the flag updates below modify the x86 flags until they are read.
+  if (reg_dst >= 0) {
+    x64.Store(RegOffset(reg_dst), X64::EAX);
+  }
+
+  if (set_flags) {
+    switch (type) {
+      case Logical: EmitSetFlags(x64, carry, false); break;
+      case Addition: EmitSetFlags(x64, Carry::Flag, true); break;
+      case Subtraction: EmitSetFlags(x64, Carry::NotFlag, true); break;
+    }
+  }
+}
+
+/* Expects the address in esi. */
+void JIT::EmitLoad(X64Emitter& x64, LoadType type, int reg_dst) {
+  x64.Call(context->load[int(type)]);
+  x64.Store(RegOffset(reg_dst), X64::EAX);
+}
+
+/* Expects the address in esi. */
+void JIT::EmitStore(X64Emitter& x64, StoreType type, int reg_src) {
+  x64.Load(X64::EDX, RegOffset(reg_src));
+  x64.Call(context->store[int(type)]);
+}
+
+/* Copies N and Z, and optionally C and V, from the x86 flags into the CPSR. */
+void JIT::EmitSetFlags(X64Emitter& x64, Carry carry, bool overflow) {
+  u32 mask = 0xC0000000;
+
+  x64.SetCC(X64::CC_S, X64::EAX);
+  x64.SetCC(X64::CC_Z, X64::ECX);
+  if (carry == Carry::Flag) {
+    x64.SetCC(X64::CC_C, X64::EDX);
+  }
+  if (carry == Carry::NotFlag) {
+    x64.SetCC(X64::CC_NC, X64::EDX);
+  }
+  if (overflow) {
+    x64.SetCC(X64::CC_O, X64::R8D);
+    mask |= 1 << 28;
+  }
+  if (carry != Carry::Keep) {
+    mask |= 1 << 29;
+  }
+
+  x64.Load(X64::ESI, context->cpsr);
+  x64.OpImm(X64::AND, X64::ESI, ~mask);
+
+  x64.ZeroExtend8(X64::EAX, X64::EAX);
+  x64.ShiftImm(X64::SHL, X64::EAX, 31);
+  x64.Op(X64::OR, X64::ESI, X64::EAX);
+
+  x64.ZeroExtend8(X64::ECX, X64::ECX);
+  x64.ShiftImm(X64::SHL, X64::ECX, 30);
+  x64.Op(X64::OR, X64::ESI, X64::ECX);
+
+  switch (carry) {
+    case Carry::Flag:
+    case Carry::NotFlag:
+    case Carry::EDX: {
+      x64.ZeroExtend8(X64::EDX, X64::EDX);
+      x64.ShiftImm(X64::SHL, X64::EDX, 29);
+      x64.Op(X64::OR, X64::ESI, X64::EDX);
+      break;
+    }
+    case Carry::Set: {
+      x64.OpImm(X64::OR, X64::ESI, 1 << 29);
+      break;
+    }
+    default: {
+      break;
+    }
+  }
+
+  if (overflow) {
+    x64.ZeroExtend8(X64::ECX, X64::R8D);
+    x64.ShiftImm(X64::SHL, X64::ECX, 28);
+    x64.Op(X64::OR, X64::ESI, X64::ECX);
+  }
+
+  x64.Store(context->cpsr, X64::ESI);
+}
+
+/* Looks up the condition in ARM7TDMI::s_condition_lut.
+ * @returns a label which is jumped to if the condition is false.
+ */
+auto JIT::EmitCondition(X64Emitter& x64, int condition) -> size_t {
+  x64.MoveImm64(X64::ECX, context->condition_lut);
+  x64.Load(X64::EAX, context->cpsr);
+  x64.ShiftImm(X64::SHR, X64::EAX, 28);
+  x64.LoadTableByte(condition << 4);
+  x64.Test(X64::EAX, X64::EAX);
+  return x64.JumpIf(X64::CC_Z);
+}
+
+/* Expects the branch target in r15. Reloads the pipeline and leaves the block. */
+void JIT::EmitBranch(X64Emitter& x64) {
+  x64.Call(context->reload);
+  exits.push_back(x64.Jump());
+}
+
+/* Reads a register, r15 is constant within the instruction. */
+void JIT::EmitReadReg(X64Emitter& x64, Reg reg, int id, u32 r15) {
+  if (id == 15) {
+    x64.MoveImm(reg, r15);
+  } else {
+    x64.Load(reg, RegOffset(id));
+  }
+}
+
+} // namespace nba::core::arm
@@ -0,0 +1,267 @@
+/*
+ * Copyright (C) 2021 fleroviux
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#pragma once
+
+#include <common/compiler.hpp>
+#include <common/integer.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "../block_cache.hpp"
+#include "../memory.hpp"
+#include "x64_emitter.hpp"
+
+namespace nba::core::arm {
+
+/** Translates hot basic blocks into native x86-64 code.
+  * Data processing, loads and stores with an immediate or simple register
+  * offset, and branches are emitted natively. Every other instruction is
+  * emitted as a call into its block handler.
+  * Opcode fetches and data accesses still go through the bus,
+  * so timing stays identical to the interpreter.
+  * The code buffer is writable only while a block is emitted into it.
+  */
+struct JIT {
+  static constexpr int kHotThreshold = 16;
+  static constexpr size_t kCodeBufferSize = 16 * 1024 * 1024;
+
+  JIT(size_t buffer_size = kCodeBufferSize);
+ ~JIT();
+
+  static auto IsSupported() -> bool;
+
+  auto IsValid() const -> bool { return buffer != nullptr; }
+
+  auto GetBufferSize() const -> size_t { return buffer_size; }
+
+  void Reset();
+
+  /** Translates a block into a function that runs it like RunBlock() would.
+    * Native ARM code accesses the registers directly, so the function returns
+    * false without running any instruction while banked registers
+    * must be accessed through ARM7TDMI::GetReg() and SetReg().
+    * @returns false if the code buffer is full.
+    */
+  template<typename Core>
+  auto Compile(Core* core, BasicBlock<Core>* block) -> bool {
+    if (block->code.empty()) {
+      return true;
+    }
+
+    auto base = reinterpret_cast<u8*>(core);
+    auto offset_of = [&](void const* member) {
+      return s32(reinterpret_cast<u8 const*>(member) - base);
+    };
+
+    Context context;
+
+    context.reg = offset_of(&core->state.reg[0]);
+    context.cpsr = offset_of(&core->state.cpsr.v);
+    context.fetch_type = offset_of(&core->pipe.fetch_type);
+    context.ldm_usermode_conflict = offset_of(&core->ldm_usermode_conflict);
+    context.cpu_mode_is_invalid = offset_of(&core->cpu_mode_is_invalid);
+    context.condition_lut = reinterpret_cast<uintptr_t>(core->s_condition_lut.data());
+    context.can_continue = reinterpret_cast<uintptr_t>(&JIT::CanContinue<Core>);
+
+    if (block->thumb) {
+      context.fetch = reinterpret_cast<uintptr_t>(&JIT::Fetch16<Core>);
+      context.check_and_fetch = reinterpret_cast<uintptr_t>(&JIT::CheckAndFetch16<Core>);
+      context.step = reinterpret_cast<uintptr_t>(&JIT::Step16<Core>);
+      context.reload = reinterpret_cast<uintptr_t>(&JIT::Reload16<Core>);
+    } else {
+      context.fetch = reinterpret_cast<uintptr_t>(&JIT::Fetch32<Core>);
+      context.check_and_fetch = reinterpret_cast<uintptr_t>(&JIT::CheckAndFetch32<Core>);
+      context.step = reinterpret_cast<uintptr_t>(&JIT::Step32<Core>);
+      context.reload = reinterpret_cast<uintptr_t>(&JIT::Reload32<Core>);
+    }
+
+    context.load[int(LoadType::Word)] = reinterpret_cast<uintptr_t>(&JIT::Load<Core, LoadType::Word>);
+    context.load[int(LoadType::Half)] = reinterpret_cast<uintptr_t>(&JIT::Load<Core, LoadType::Half>);
+    context.load[int(LoadType::Byte)] = reinterpret_cast<uintptr_t>(&JIT::Load<Core, LoadType::Byte>);
+    context.load[int(LoadType::HalfSigned)] = reinterpret_cast<uintptr_t>(&JIT::Load<Core, LoadType::HalfSigned>);
+    context.load[int(LoadType::ByteSigned)] = reinterpret_cast<uintptr_t>(&JIT::Load<Core, LoadType::ByteSigned>);
+    context.store[int(StoreType::Word)] = reinterpret_cast<uintptr_t>(&JIT::Store<Core, StoreType::Word>);
+    context.store[int(StoreType::Half)] = reinterpret_cast<uintptr_t>(&JIT::Store<Core, StoreType::Half>);
+    context.store[int(StoreType::Byte)] = reinterpret_cast<uintptr_t>(&JIT::Store<Core, StoreType::Byte>);
+
+    operations.clear();
+    for (auto& entry : block->code) {
+      operations.push_back({entry.opcode, entry.imm, entry.carry, reinterpret_cast<uintptr_t>(&entry)});
+    }
+
+    auto code = EmitBlock(context, block->address, block->thumb);
+
+    if (code == nullptr) {
+      return false;
+    }
+
+    block->compiled = reinterpret_cast<bool (*)(Core*)>(code);
+    return true;
+  }
+
+private:
+  using Reg = X64Emitter::Reg;
+
+  enum class LoadType {
+    Word,
+    Half,
+    Byte,
+    HalfSigned,
+    ByteSigned
+  };
+
+  enum class StoreType {
+    Word,
+    Half,
+    Byte
+  };
+
+  /// Location of the guest state relative to the core and the functions which the native code calls.
+  struct Context {
+    s32 reg;
+    s32 cpsr;
+    s32 fetch_type;
+    s32 ldm_usermode_conflict;
+    s32 cpu_mode_is_invalid;
+    uintptr_t condition_lut;
+    uintptr_t can_continue;
+    uintptr_t fetch;
+    uintptr_t check_and_fetch;
+    uintptr_t step;
+    uintptr_t reload;
+    uintptr_t load[5];
+    uintptr_t store[3];
+  };
+
+  /// A pre-decoded instruction of the block that is being translated.
+  struct Operation {
+    u32 opcode;
+    u32 imm;
+    int carry;
+    uintptr_t entry;
+  };
+
+  /// Where the carry flag comes from, when an instruction sets the flags.
+  enum class Carry {
+    Keep,     // unchanged
+    Clear,
+    Set,
+    Flag,     // x86 carry flag
+    NotFlag,  // inverted x86 carry flag (subtraction)
+    EDX       // dl, from the shifter
+  };
+
+  template<typename Core>
+  static auto CanContinue(Core* cpu) -> bool {
+    return cpu->CanContinueBlock();
+  }
+
+  template<typename Core>
+  static void Fetch16(Core* cpu) {
+    cpu->Fetch16();
+  }
+
+  template<typename Core>
+  static void Fetch32(Core* cpu) {
+    cpu->Fetch32();
+  }
+
+  template<typename Core>
+  static auto CheckAndFetch16(Core* cpu) -> bool {
+    if (!cpu->CanContinueBlock()) {
+      return false;
+    }
+    cpu->Fetch16();
+    return true;
+  }
+
+  template<typename Core>
+  static auto CheckAndFetch32(Core* cpu) -> bool {
+    if (!cpu->CanContinueBlock()) {
+      return false;
+    }
+    cpu->Fetch32();
+    return true;
+  }
+
+  template<typename Core>
+  static auto Step16(Core* cpu, typename BasicBlock<Core>::Instruction const* entry) -> bool {
+    return cpu->StepBlock16(*entry);
+  }
+
+  template<typename Core>
+  static auto Step32(Core* cpu, typename BasicBlock<Core>::Instruction const* entry) -> bool {
+    return cpu->StepBlock32(*entry) && !cpu->ldm_usermode_conflict && !cpu->cpu_mode_is_invalid;
+  }
+
+  template<typename Core>
+  static void Reload16(Core* cpu) {
+    cpu->ReloadPipeline16();
+  }
+
+  template<typename Core>
+  static void Reload32(Core* cpu) {
+    cpu->ReloadPipeline32();
+  }
+
+  template<typename Core, LoadType type>
+  static auto Load(Core* cpu, u32 address) -> u32 {
+    u32 value;
+
+    switch (type) {
+      case LoadType::Word: value = cpu->ReadWordRotate(address, MemoryBase::Access::Nonsequential); break;
+      case LoadType::Half: value = cpu->ReadHalfRotate(address, MemoryBase::Access::Nonsequential); break;
+      case LoadType::Byte: value = cpu->ReadByte(address, MemoryBase::Access::Nonsequential); break;
+      case LoadType::HalfSigned: value = cpu->ReadHalfSigned(address, MemoryBase::Access::Nonsequential); break;
+      case LoadType::ByteSigned: value = cpu->ReadByteSigned(address, MemoryBase::Access::Nonsequential); break;
+    }
+
+    cpu->Idle();
+    return value;
+  }
+
+  template<typename Core, StoreType type>
+  static void Store(Core* cpu, u32 address, u32 value) {
+    switch (type) {
+      case StoreType::Word: cpu->WriteWord(address, value, MemoryBase::Access::Nonsequential); break;
+      case StoreType::Half: cpu->WriteHalf(address, u16(value), MemoryBase::Access::Nonsequential); break;
+      case StoreType::Byte: cpu->WriteByte(address, u8(value), MemoryBase::Access::Nonsequential); break;
+    }
+  }
+
+  /// Emits the function for the operations of a block.
+  /// @returns pointer to the emitted function or nullptr if the code buffer is full.
+  auto EmitBlock(Context const& context, u32 address, bool thumb) -> void*;
+
+  auto EmitThumb(X64Emitter& x64, Operation const& op, u32 address) -> bool;
+  auto EmitARM(X64Emitter& x64, Operation const& op, u32 address) -> bool;
+  void EmitDataProcessing(X64Emitter& x64, int opcode, bool set_flags, int reg_dst, Carry carry);
+  void EmitLoad(X64Emitter& x64, LoadType type, int reg_dst);
+  void EmitStore(X64Emitter& x64, StoreType type, int reg_src);
+  void EmitSetFlags(X64Emitter& x64, Carry carry, bool overflow);
+  auto EmitCondition(X64Emitter& x64, int condition) -> size_t;
+  void EmitBranch(X64Emitter& x64);
+  void EmitReadReg(X64Emitter& x64, Reg reg, int id, u32 r15);
+
+  auto RegOffset(int id) const -> s32 {
+    return context->reg + id * s32(sizeof(u32));
+  }
+
+  u8* buffer = nullptr;
+  size_t buffer_size;
+  size_t offset = 0;
+  size_t page_size = 4096;
+  std::vector<Operation> operations;
+
+  /* State of the block that is being emitted. */
+  Context const* context = nullptr;
+  std::vector<size_t> exits;
+};
+
+} // namespace nba::core::arm
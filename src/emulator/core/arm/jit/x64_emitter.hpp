@@ -0,0 +1,275 @@
+/*
+ * Copyright (C) 2021 fleroviux
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#pragma once
+
+#include <common/integer.hpp>
+#include <cstddef>
+#include <cstdint>
+
+namespace nba::core::arm {
+
+/** Minimal x86-64 assembler for the JIT.
+  * Guest state is addressed relative to rbx, which holds the core pointer.
+  * Only 32-bit operations and the few addressing modes used by the JIT are provided.
+  */
+struct X64Emitter {
+  enum Reg {
+    EAX = 0, ECX = 1, EDX = 2, EBX = 3, ESP = 4, EBP = 5, ESI = 6, EDI = 7,
+    R8D = 8
+  };
+
+  enum Condition {
+    CC_O  = 0x0,
+    CC_C  = 0x2,
+    CC_NC = 0x3,
+    CC_Z  = 0x4,
+    CC_NZ = 0x5,
+    CC_S  = 0x8
+  };
+
+  /// Opcodes of the "op r/m32, r32" form, the /digit of the immediate form is (opcode >> 3).
+  enum ALU {
+    ADD = 0x01,
+    OR  = 0x09,
+    ADC = 0x11,
+    SBB = 0x19,
+    AND = 0x21,
+    SUB = 0x29,
+    XOR = 0x31,
+    CMP = 0x39
+  };
+
+  enum Shift {
+    ROR = 1,
+    SHL = 4,
+    SHR = 5,
+    SAR = 7
+  };
+
+  X64Emitter(u8* code) : code(code) {}
+
+  auto GetSize() const -> size_t { return size; }
+
+  /// Discards the code emitted after the given size.
+  void Rewind(size_t new_size) { size = new_size; }
+
+  /// mov reg, [rbx + disp]
+  void Load(Reg reg, s32 disp) {
+    Rex(reg, EAX);
+    Emit8(0x8B);
+    EmitBaseDisp(reg, disp);
+  }
+
+  /// mov [rbx + disp], reg
+  void Store(s32 disp, Reg reg) {
+    Rex(reg, EAX);
+    Emit8(0x89);
+    EmitBaseDisp(reg, disp);
+  }
+
+  /// mov dword [rbx + disp], imm
+  void StoreImm(s32 disp, u32 imm) {
+    Emit8(0xC7);
+    EmitBaseDisp(EAX, disp);
+    Emit32(imm);
+  }
+
+  /// cmp byte [rbx + disp], 0
+  void CompareByteZero(s32 disp) {
+    Emit8(0x80);
+    EmitBaseDisp(Reg(7), disp);
+    Emit8(0);
+  }
+
+  /// bt dword [rbx + disp], bit
+  void BitTest(s32 disp, int bit) {
+    Emit8(0x0F);
+    Emit8(0xBA);
+    EmitBaseDisp(Reg(4), disp);
+    Emit8(bit);
+  }
+
+  /// mov reg, imm
+  void MoveImm(Reg reg, u32 imm) {
+    Rex(EAX, reg);
+    Emit8(0xB8 + (reg & 7));
+    Emit32(imm);
+  }
+
+  /// mov reg64, imm64
+  void MoveImm64(Reg reg, u64 imm) {
+    Emit8(0x48 | (reg >> 3));
+    Emit8(0xB8 + (reg & 7));
+    Emit64(imm);
+  }
+
+  /// mov dst, src
+  void Move(Reg dst, Reg src) {
+    Rex(src, dst);
+    Emit8(0x89);
+    Emit8(0xC0 | ((src & 7) << 3) | (dst & 7));
+  }
+
+  /// op dst, src
+  void Op(ALU op, Reg dst, Reg src) {
+    Rex(src, dst);
+    Emit8(op);
+    Emit8(0xC0 | ((src & 7) << 3) | (dst & 7));
+  }
+
+  /// op dst, imm
+  void OpImm(ALU op, Reg dst, u32 imm) {
+    Rex(EAX, dst);
+    Emit8(0x81);
+    Emit8(0xC0 | ((op >> 3) << 3) | (dst & 7));
+    Emit32(imm);
+  }
+
+  /// test dst, src
+  void Test(Reg dst, Reg src) {
+    Rex(src, dst);
+    Emit8(0x85);
+    Emit8(0xC0 | ((src & 7) << 3) | (dst & 7));
+  }
+
+  /// test al, al
+  void TestResult() {
+    Emit8(0x84);
+    Emit8(0xC0);
+  }
+
+  /// not reg
+  void Not(Reg reg) {
+    Rex(EAX, reg);
+    Emit8(0xF7);
+    Emit8(0xD0 | (reg & 7));
+  }
+
+  /// shift reg, amount
+  void ShiftImm(Shift shift, Reg reg, int amount) {
+    Rex(EAX, reg);
+    Emit8(0xC1);
+    Emit8(0xC0 | (shift << 3) | (reg & 7));
+    Emit8(amount);
+  }
+
+  /// setcc reg8
+  void SetCC(Condition condition, Reg reg) {
+    Emit8(0x40 | (reg >> 3));
+    Emit8(0x0F);
+    Emit8(0x90 | condition);
+    Emit8(0xC0 | (reg & 7));
+  }
+
+  /// movzx dst, src8
+  void ZeroExtend8(Reg dst, Reg src) {
+    Emit8(0x40 | ((dst >> 3) << 2) | (src >> 3));
+    Emit8(0x0F);
+    Emit8(0xB6);
+    Emit8(0xC0 | ((dst & 7) << 3) | (src & 7));
+  }
+
+  /// movzx eax, byte [rcx + rax + disp]
+  void LoadTableByte(s32 disp) {
+    Emit8(0x0F);
+    Emit8(0xB6);
+    Emit8(0x84);
+    Emit8(0x01);
+    Emit32(disp);
+  }
+
+  /// cmc
+  void ComplementCarry() {
+    Emit8(0xF5);
+  }
+
+  /// mov rdi, rbx; mov rax, function; call rax
+  void Call(uintptr_t function) {
+    Emit8(0x48);
+    Emit8(0x89);
+    Emit8(0xDF);
+    MoveImm64(EAX, function);
+    Emit8(0xFF);
+    Emit8(0xD0);
+  }
+
+  /// jcc rel32 to a label which is bound later.
+  /// @returns the label.
+  auto JumpIf(Condition condition) -> size_t {
+    Emit8(0x0F);
+    Emit8(0x80 | condition);
+    Emit32(0);
+    return size;
+  }
+
+  /// jmp rel32 to a label which is bound later.
+  /// @returns the label.
+  auto Jump() -> size_t {
+    Emit8(0xE9);
+    Emit32(0);
+    return size;
+  }
+
+  /// push rbx; mov rbx, rdi
+  void EnterBlock() {
+    Emit8(0x53);
+    Emit8(0x48);
+    Emit8(0x89);
+    Emit8(0xFB);
+  }
+
+  /// mov eax, result; pop rbx; ret
+  void LeaveBlock(u32 result) {
+    MoveImm(EAX, result);
+    Emit8(0x5B);
+    Emit8(0xC3);
+  }
+
+  /// Makes the jump that returned the label continue at the current position.
+  void Bind(size_t label) {
+    u32 rel = u32(size - label);
+
+    for (int i = 0; i < 4; i++) {
+      code[label - 4 + i] = u8(rel >> (i * 8));
+    }
+  }
+
+  void Emit8(u8 value) {
+    code[size++] = value;
+  }
+
+  void Emit32(u32 value) {
+    for (int i = 0; i < 4; i++) {
+      Emit8(u8(value >> (i * 8)));
+    }
+  }
+
+  void Emit64(u64 value) {
+    Emit32(u32(value));
+    Emit32(u32(value >> 32));
+  }
+
+private:
+  /// Emits the REX prefix for the ModRM reg and r/m fields, if it is needed.
+  void Rex(Reg reg, Reg rm) {
+    if (reg >= 8 || rm >= 8) {
+      Emit8(0x40 | ((reg >> 3) << 2) | (rm >> 3));
+    }
+  }
+
+  /// ModRM and displacement of [rbx + disp32]
+  void EmitBaseDisp(Reg reg, s32 disp) {
+    Emit8(0x80 | ((reg & 7) << 3) | EBX);
+    Emit32(u32(disp));
+  }
+
+  u8* code;
+  size_t size = 0;
+};
+
+} // namespace nba::core::arm
@@ -11,6 +11,10 @@
 
 namespace nba::core::arm {
 
+/** Virtual bus interface.
+  * The emulator core binds ARM7TDMI directly to CPU, this interface only
+  * serves as an adapter for standalone use, i.e. ARM7TDMI<MemoryBase> in tests.
+  */
 struct MemoryBase {
   enum class Access {
     Nonsequential = 0,
@@ -28,6 +32,12 @@ struct MemoryBase {
   virtual void WriteWord(u32 address, u32 value, Access access) = 0;
 
   virtual void Idle() = 0;
+
+  /// See ARM7TDMI::SetSWIHook(), SWIs are not handled by default.
+  virtual bool HandleSWI(int number) { return false; }
+
+  /// See ARM7TDMI::RunBlock(), code is not cached by default.
+  virtual auto GetCodePointer(u32 address) -> u8 const* { return nullptr; }
 };
 
 } // namespace nba::core::arm
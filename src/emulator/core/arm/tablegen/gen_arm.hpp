@@ -25,11 +25,11 @@ static constexpr auto GenerateHandlerARM() -> Handler32 {
         const bool use_spsr = instruction & (1 << 22);
         const bool to_status = instruction & (1 << 21);
 
-        return &ARM7TDMI::ARM_StatusTransfer<true, use_spsr, to_status>;
+        return &ARM7TDMI::template ARM_StatusTransfer<true, use_spsr, to_status>;
       } else {
         const int field4 = (instruction >> 4) & 0xF;
 
-        return &ARM7TDMI::ARM_DataProcessing<true, static_cast<ARM7TDMI::DataOp>(opcode), set_flags, field4>;
+        return &ARM7TDMI::template ARM_DataProcessing<true, static_cast<typename ARM7TDMI::DataOp>(opcode), set_flags, field4>;
       }
     } else if ((opcode & 0xFF000F0) == 0x1200010) {
       // ARM.3 Branch and exchange
@@ -44,15 +44,15 @@ static constexpr auto GenerateHandlerARM() -> Handler32 {
       if (opcode & (1 << 23)) {
         const bool sign_extend = instruction & (1 << 22);
 
-        return &ARM7TDMI::ARM_MultiplyLong<sign_extend, accumulate, set_flags>;
+        return &ARM7TDMI::template ARM_MultiplyLong<sign_extend, accumulate, set_flags>;
       } else {
-        return &ARM7TDMI::ARM_Multiply<accumulate, set_flags>;
+        return &ARM7TDMI::template ARM_Multiply<accumulate, set_flags>;
       }
     } else if ((opcode & 0x10000F0) == 0x1000090) {
       // ARM.4 Single data swap
       const bool byte = instruction & (1 << 22);
 
-      return &ARM7TDMI::ARM_SingleDataSwap<byte>;
+      return &ARM7TDMI::template ARM_SingleDataSwap<byte>;
     } else if ((opcode & 0xF0) == 0xB0 ||
       (opcode & 0xD0) == 0xD0) {
       // ARM.5 Halfword data transfer, register offset
@@ -61,7 +61,7 @@ static constexpr auto GenerateHandlerARM() -> Handler32 {
       const bool immediate = instruction & (1 << 22);
       const int opcode = (instruction >> 5) & 3;
 
-      return &ARM7TDMI::ARM_HalfwordSignedTransfer<pre, add, immediate, wb, load, opcode>;
+      return &ARM7TDMI::template ARM_HalfwordSignedTransfer<pre, add, immediate, wb, load, opcode>;
     } else {
       // ARM.8 Data processing and PSR transfer
       const bool set_flags = instruction & (1 << 20);
@@ -71,11 +71,11 @@ static constexpr auto GenerateHandlerARM() -> Handler32 {
         const bool use_spsr = instruction & (1 << 22);
         const bool to_status = instruction & (1 << 21);
 
-        return &ARM7TDMI::ARM_StatusTransfer<false, use_spsr, to_status>;
+        return &ARM7TDMI::template ARM_StatusTransfer<false, use_spsr, to_status>;
       } else {
         const int field4 = (instruction >> 4) & 0xF;
 
-        return &ARM7TDMI::ARM_DataProcessing<false, static_cast<ARM7TDMI::DataOp>(opcode), set_flags, field4>;
+        return &ARM7TDMI::template ARM_DataProcessing<false, static_cast<typename ARM7TDMI::DataOp>(opcode), set_flags, field4>;
       }
     }
     break;
@@ -87,17 +87,17 @@ static constexpr auto GenerateHandlerARM() -> Handler32 {
       const bool immediate = ~instruction & (1 << 25);
       const bool byte = instruction & (1 << 22);
 
-      return &ARM7TDMI::ARM_SingleDataTransfer<immediate, pre, add, byte, wb, load>;
+      return &ARM7TDMI::template ARM_SingleDataTransfer<immediate, pre, add, byte, wb, load>;
     }
     break;
   case 0b10:
     // ARM.11 Block data transfer, ARM.12 Branch
     if (opcode & (1 << 25)) {
-      return &ARM7TDMI::ARM_BranchAndLink<(opcode >> 24) & 1>;
+      return &ARM7TDMI::template ARM_BranchAndLink<(opcode >> 24) & 1>;
     } else {
       const bool user_mode = instruction & (1 << 22);
 
-      return &ARM7TDMI::ARM_BlockDataTransfer<pre, add, user_mode, wb, load>;
+      return &ARM7TDMI::template ARM_BlockDataTransfer<pre, add, user_mode, wb, load>;
     }
     break;
   case 0b11:
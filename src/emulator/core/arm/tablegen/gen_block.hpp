@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2021 fleroviux
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+template <u16 instruction>
+static constexpr auto GenerateBlockHandlerThumb() -> BlockHandler {
+  // THUMB.6 PC-relative load
+  if ((instruction & 0xF800) == 0x4800) {
+    const auto rD = (instruction >> 8) & 7;
+
+    return &ARM7TDMI::template Block_Thumb_LoadStoreRelativePC<rD>;
+  }
+
+  // THUMB.16 Conditional Branch
+  if ((instruction & 0xF000) == 0xD000 && (instruction & 0xFF00) != 0xDF00) {
+    const auto condition = (instruction >> 8) & 0xF;
+
+    return &ARM7TDMI::template Block_Thumb_ConditionalBranch<condition>;
+  }
+
+  // THUMB.18 Unconditional Branch
+  if ((instruction & 0xF800) == 0xE000) {
+    return &ARM7TDMI::Block_Thumb_UnconditionalBranch;
+  }
+
+  // THUMB.19 Long branch with link, first instruction
+  if ((instruction & 0xF800) == 0xF000) {
+    return &ARM7TDMI::Block_Thumb_LongBranchLinkPrefix;
+  }
+
+  return &ARM7TDMI::template Block_Thumb<GenerateHandlerThumb<instruction>()>;
+}
+
+template <u32 instruction>
+static constexpr auto GenerateBlockHandlerARM() -> BlockHandler {
+  const bool pre = instruction & (1 << 24);
+  const bool wb = instruction & (1 << 21);
+  const bool load = instruction & (1 << 20);
+
+  switch ((instruction >> 25) & 7) {
+  case 0b001: {
+    // ARM.8 Data processing, immediate operand (but not PSR transfer)
+    const bool set_flags = instruction & (1 << 20);
+    const int  opcode = (instruction >> 21) & 0xF;
+
+    if (set_flags || opcode < 0b1000 || opcode > 0b1011) {
+      return &ARM7TDMI::template Block_ARM_DataProcessingImm<static_cast<typename ARM7TDMI::DataOp>(opcode), set_flags>;
+    }
+    break;
+  }
+  case 0b010: {
+    // ARM.9 Single data transfer, immediate offset
+    const bool byte = instruction & (1 << 22);
+
+    return &ARM7TDMI::template Block_ARM_SingleDataTransferImm<pre, byte, wb, load>;
+  }
+  case 0b101: {
+    // ARM.12 Branch
+    return &ARM7TDMI::template Block_ARM_BranchAndLink<pre>;
+  }
+  }
+
+  return &ARM7TDMI::template Block_ARM<GenerateHandlerARM<instruction>()>;
+}
@@ -12,7 +12,7 @@ static constexpr auto GenerateHandlerThumb() -> Handler16 {
     const auto opcode = (instruction >> 11) & 3;
     const auto offset5 = (instruction >> 6) & 0x1F;
 
-    return &ARM7TDMI::Thumb_MoveShiftedRegister<opcode, offset5>;
+    return &ARM7TDMI::template Thumb_MoveShiftedRegister<opcode, offset5>;
   }
 
   // THUMB.2 Add/subtract
@@ -21,7 +21,7 @@ static constexpr auto GenerateHandlerThumb() -> Handler16 {
     const bool subtract = (instruction >> 9) & 1;
     const auto field3 = (instruction >> 6) & 7;
 
-    return &ARM7TDMI::Thumb_AddSub<immediate, subtract, field3>;
+    return &ARM7TDMI::template Thumb_AddSub<immediate, subtract, field3>;
   }
 
   // THUMB.3 Move/compare/add/subtract immediate
@@ -29,14 +29,14 @@ static constexpr auto GenerateHandlerThumb() -> Handler16 {
     const auto opcode = (instruction >> 11) & 3;
     const auto rD = (instruction >> 8) & 7;
 
-    return &ARM7TDMI::Thumb_Op3<opcode, rD>;
+    return &ARM7TDMI::template Thumb_Op3<opcode, rD>;
   }
 
   // THUMB.4 ALU operations
   if ((instruction & 0xFC00) == 0x4000) {
     const auto opcode = (instruction >> 6) & 0xF;
 
-    return &ARM7TDMI::Thumb_ALU<opcode>;
+    return &ARM7TDMI::template Thumb_ALU<opcode>;
   }
 
   // THUMB.5 Hi register operations/branch exchange
@@ -45,14 +45,14 @@ static constexpr auto GenerateHandlerThumb() -> Handler16 {
     const bool high1 = (instruction >> 7) & 1;
     const bool high2 = (instruction >> 6) & 1;
 
-    return &ARM7TDMI::Thumb_HighRegisterOps_BX<opcode, high1, high2>;
+    return &ARM7TDMI::template Thumb_HighRegisterOps_BX<opcode, high1, high2>;
   }
 
   // THUMB.6 PC-relative load
   if ((instruction & 0xF800) == 0x4800) {
     const auto rD = (instruction >> 8) & 7;
 
-    return &ARM7TDMI::Thumb_LoadStoreRelativePC<rD>;
+    return &ARM7TDMI::template Thumb_LoadStoreRelativePC<rD>;
   }
 
   // THUMB.7 Load/store with register offset
@@ -60,7 +60,7 @@ static constexpr auto GenerateHandlerThumb() -> Handler16 {
     const auto opcode = (instruction >> 10) & 3;
     const auto rO = (instruction >> 6) & 7;
 
-    return &ARM7TDMI::Thumb_LoadStoreOffsetReg<opcode, rO>;
+    return &ARM7TDMI::template Thumb_LoadStoreOffsetReg<opcode, rO>;
   }
 
   // THUMB.8 Load/store sign-extended byte/halfword
@@ -68,7 +68,7 @@ static constexpr auto GenerateHandlerThumb() -> Handler16 {
     const auto opcode = (instruction >> 10) & 3;
     const auto rO = (instruction >> 6) & 7;
 
-    return &ARM7TDMI::Thumb_LoadStoreSigned<opcode, rO>;
+    return &ARM7TDMI::template Thumb_LoadStoreSigned<opcode, rO>;
   }
 
   // THUMB.9 Load store with immediate offset
@@ -76,7 +76,7 @@ static constexpr auto GenerateHandlerThumb() -> Handler16 {
     const auto opcode = (instruction >> 11) & 3;
     const auto offset5 = (instruction >> 6) & 0x1F;
 
-    return &ARM7TDMI::Thumb_LoadStoreOffsetImm<opcode, offset5>;
+    return &ARM7TDMI::template Thumb_LoadStoreOffsetImm<opcode, offset5>;
   }
 
   // THUMB.10 Load/store halfword
@@ -84,7 +84,7 @@ static constexpr auto GenerateHandlerThumb() -> Handler16 {
     const bool load = (instruction >> 11) & 1;
     const auto offset5 = (instruction >> 6) & 0x1F;
 
-    return &ARM7TDMI::Thumb_LoadStoreHword<load, offset5>;
+    return &ARM7TDMI::template Thumb_LoadStoreHword<load, offset5>;
   }
 
   // THUMB.11 SP-relative load/store
@@ -92,7 +92,7 @@ static constexpr auto GenerateHandlerThumb() -> Handler16 {
     const bool load = (instruction >> 11) & 1;
     const auto rD = (instruction >> 8) & 7;
 
-    return &ARM7TDMI::Thumb_LoadStoreRelativeToSP<load, rD>;
+    return &ARM7TDMI::template Thumb_LoadStoreRelativeToSP<load, rD>;
   }
 
   // THUMB.12 Load address
@@ -100,14 +100,14 @@ static constexpr auto GenerateHandlerThumb() -> Handler16 {
     const bool use_r13 = (instruction >> 11) & 1;
     const auto rD = (instruction >> 8) & 7;
 
-    return &ARM7TDMI::Thumb_LoadAddress<use_r13, rD>;
+    return &ARM7TDMI::template Thumb_LoadAddress<use_r13, rD>;
   }
 
   // THUMB.13 Add offset to stack pointer
   if ((instruction & 0xFF00) == 0xB000) {
     const bool subtract = (instruction >> 7) & 1;
 
-    return &ARM7TDMI::Thumb_AddOffsetToSP<subtract>;
+    return &ARM7TDMI::template Thumb_AddOffsetToSP<subtract>;
   }
 
   // THUMB.14 push/pop registers
@@ -115,7 +115,7 @@ static constexpr auto GenerateHandlerThumb() -> Handler16 {
     const bool load = (instruction >> 11) & 1;
     const bool pc_lr = (instruction >> 8) & 1;
 
-    return &ARM7TDMI::Thumb_PushPop<load, pc_lr>;
+    return &ARM7TDMI::template Thumb_PushPop<load, pc_lr>;
   }
 
   // THUMB.15 Multiple load/store
@@ -123,14 +123,14 @@ static constexpr auto GenerateHandlerThumb() -> Handler16 {
     const bool load = (instruction >> 11) & 1;
     const auto rB = (instruction >> 8) & 7;
 
-    return &ARM7TDMI::Thumb_LoadStoreMultiple<load, rB>;
+    return &ARM7TDMI::template Thumb_LoadStoreMultiple<load, rB>;
   }
 
   // THUMB.16 Conditional Branch
   if ((instruction & 0xFF00) < 0xDF00) {
     const auto condition = (instruction >> 8) & 0xF;
 
-    return &ARM7TDMI::Thumb_ConditionalBranch<condition>;
+    return &ARM7TDMI::template Thumb_ConditionalBranch<condition>;
   }
 
   // THUMB.17 Software Interrupt
@@ -147,7 +147,7 @@ static constexpr auto GenerateHandlerThumb() -> Handler16 {
   if ((instruction & 0xF000) == 0xF000) {
     const auto opcode = (instruction >> 11) & 1;
 
-    return &ARM7TDMI::Thumb_LongBranchLink<opcode>;
+    return &ARM7TDMI::template Thumb_LongBranchLink<opcode>;
   }
 
   return &ARM7TDMI::Thumb_Undefined;
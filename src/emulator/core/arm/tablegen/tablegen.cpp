@@ -6,20 +6,24 @@
  */
 
 #include <common/static_for.hpp>
+#include <emulator/core/cpu.hpp>
 
 #include "../arm7tdmi.hpp"
 
 namespace nba::core::arm {
 
-using Handler16 = ARM7TDMI::Handler16;
-using Handler32 = ARM7TDMI::Handler32;
-
 /** A helper class used to generate lookup tables for
   * the interpreter at compiletime.
   * The motivation is to separate the code used for generation from
   * the interpreter class and its header itself.
   */
+template<typename Bus>
 struct TableGen {
+  using ARM7TDMI = arm::ARM7TDMI<Bus>;
+  using Handler16 = typename ARM7TDMI::Handler16;
+  using Handler32 = typename ARM7TDMI::Handler32;
+  using BlockHandler = typename ARM7TDMI::BlockHandler;
+
   #ifdef __clang__
   #pragma clang diagnostic push
   #pragma clang diagnostic ignored "-Weverything"
@@ -27,6 +31,7 @@ struct TableGen {
 
   #include "gen_arm.hpp"
   #include "gen_thumb.hpp"
+  #include "gen_block.hpp"
 
   #ifdef __clang__
   #pragma clang diagnostic pop
@@ -52,6 +57,26 @@ struct TableGen {
     return lut;
   }
 
+  static constexpr auto GenerateBlockTableThumb() -> std::array<BlockHandler, 1024> {
+    std::array<BlockHandler, 1024> lut{};
+
+    common::static_for<std::size_t, 0, 1024>([&](auto i) {
+      lut[i] = GenerateBlockHandlerThumb<i << 6>();
+    });
+    return lut;
+  }
+
+  static constexpr auto GenerateBlockTableARM() -> std::array<BlockHandler, 4096> {
+    std::array<BlockHandler, 4096> lut{};
+
+    common::static_for<std::size_t, 0, 4096>([&](auto i) {
+      lut[i] = GenerateBlockHandlerARM<
+        ((i & 0xFF0) << 16) |
+        ((i & 0xF) << 4)>();
+    });
+    return lut;
+  }
+
   static constexpr auto GenerateConditionTable() -> std::array<bool, 256> {
     std::array<bool, 256> lut{};
     
@@ -83,8 +108,37 @@ struct TableGen {
   }
 };
 
-std::array<Handler16, 1024> ARM7TDMI::s_opcode_lut_16 = TableGen::GenerateTableThumb();
-std::array<Handler32, 4096> ARM7TDMI::s_opcode_lut_32 = TableGen::GenerateTableARM();
-std::array<bool, 256> ARM7TDMI::s_condition_lut = TableGen::GenerateConditionTable();
+template<typename Bus>
+std::array<typename ARM7TDMI<Bus>::Handler16, 1024> ARM7TDMI<Bus>::s_opcode_lut_16 = TableGen<Bus>::GenerateTableThumb();
+
+template<typename Bus>
+std::array<typename ARM7TDMI<Bus>::Handler32, 4096> ARM7TDMI<Bus>::s_opcode_lut_32 = TableGen<Bus>::GenerateTableARM();
+
+template<typename Bus>
+std::array<bool, 256> ARM7TDMI<Bus>::s_condition_lut = TableGen<Bus>::GenerateConditionTable();
+
+template<typename Bus>
+std::array<typename ARM7TDMI<Bus>::BlockHandler, 1024> ARM7TDMI<Bus>::s_block_lut_16 = TableGen<Bus>::GenerateBlockTableThumb();
+
+template<typename Bus>
+std::array<typename ARM7TDMI<Bus>::BlockHandler, 4096> ARM7TDMI<Bus>::s_block_lut_32 = TableGen<Bus>::GenerateBlockTableARM();
+
+/* The tables are only instantiated for the memory policies in use.
+ * Instantiate them here for any other policy, e.g. a MemoryBase test bus.
+ */
+template std::array<ARM7TDMI<CPU>::Handler16, 1024> ARM7TDMI<CPU>::s_opcode_lut_16;
+template std::array<ARM7TDMI<CPU>::Handler32, 4096> ARM7TDMI<CPU>::s_opcode_lut_32;
+template std::array<bool, 256> ARM7TDMI<CPU>::s_condition_lut;
+template std::array<ARM7TDMI<CPU>::BlockHandler, 1024> ARM7TDMI<CPU>::s_block_lut_16;
+template std::array<ARM7TDMI<CPU>::BlockHandler, 4096> ARM7TDMI<CPU>::s_block_lut_32;
+
+template std::array<ARM7TDMI<MemoryBase>::Handler16, 1024> ARM7TDMI<MemoryBase>::s_opcode_lut_16;
+template std::array<ARM7TDMI<MemoryBase>::Handler32, 4096> ARM7TDMI<MemoryBase>::s_opcode_lut_32;
+template std::array<bool, 256> ARM7TDMI<MemoryBase>::s_condition_lut;
+template std::array<ARM7TDMI<MemoryBase>::BlockHandler, 1024> ARM7TDMI<MemoryBase>::s_block_lut_16;
+template std::array<ARM7TDMI<MemoryBase>::BlockHandler, 4096> ARM7TDMI<MemoryBase>::s_block_lut_32;
+
+// Instantiate the whole adapter, so that it keeps compiling along with the CPU bus.
+template struct ARM7TDMI<MemoryBase>;
 
 } // namespace nba::core::arm
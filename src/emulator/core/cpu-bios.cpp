@@ -0,0 +1,502 @@
+/*
+ * Copyright (C) 2021 fleroviux
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#include <cmath>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include "cpu.hpp"
+#include "cpu-mmio.hpp"
+
+namespace nba::core {
+
+/* High-level emulation of the BIOS software interrupts.
+ * Memory is accessed through the regular bus, so that wait states are
+ * charged as usual. On top of that each call is charged a rough estimate
+ * of the cycles the BIOS would spend on dispatch and computation.
+ */
+
+/* Approximate overhead of the BIOS SWI dispatcher (entry and return). */
+static constexpr int kSWIDispatchCycles = 40;
+
+/* Open bus value of the BIOS after returning from a SWI. */
+static constexpr u32 kBIOSLatchAfterSWI = 0xE3A02004;
+
+void CPU::LoadBIOSStub() {
+  static constexpr std::pair<u32, u32> kStub[] {
+    { 0x0000, 0xE3A0F302 }, // mov pc, #0x08000000
+    { 0x0004, 0xE1B0F00E }, // movs pc, lr
+    { 0x0008, 0xE1B0F00E }, // movs pc, lr
+    { 0x000C, 0xE25EF004 }, // subs pc, lr, #4
+    { 0x0010, 0xE25EF008 }, // subs pc, lr, #8
+    { 0x0018, 0xEA000042 }, // b 0x128
+    { 0x001C, 0xE25EF004 }, // subs pc, lr, #4
+    { 0x0128, 0xE92D500F }, // stmfd sp!, {r0-r3, r12, lr}
+    { 0x012C, 0xE3A00301 }, // mov r0, #0x04000000
+    { 0x0130, 0xE28FE000 }, // add lr, pc, #0
+    { 0x0134, 0xE510F004 }, // ldr pc, [r0, #-4]
+    { 0x0138, 0xE8BD500F }, // ldmfd sp!, {r0-r3, r12, lr}
+    { 0x013C, 0xE25EF004 }  // subs pc, lr, #4
+  };
+
+  std::memset(memory.bios, 0, sizeof(memory.bios));
+
+  for (auto [address, opcode] : kStub) {
+    common::write<u32>(memory.bios, address, opcode);
+  }
+
+  memory.bios_stub = true;
+}
+
+bool CPU::HandleSWI(int number) {
+  auto& r = state.reg;
+
+  switch (number) {
+    case 0x01: {
+      // RegisterRamReset, only needed without a BIOS image.
+      if (!memory.bios_stub) {
+        return false;
+      }
+      SWIRegisterRamReset(r[0]);
+      break;
+    }
+    case 0x02: {
+      // Halt
+      Write<u8>(HALTCNT, 0x00, Access::Nonsequential);
+      break;
+    }
+    case 0x03: {
+      // Stop
+      Write<u8>(HALTCNT, 0x80, Access::Nonsequential);
+      break;
+    }
+    case 0x04: {
+      // IntrWait
+      if (!SWIIntrWait(r[0] != 0, r[1])) {
+        return true;
+      }
+      break;
+    }
+    case 0x05: {
+      // VBlankIntrWait
+      r[0] = 1;
+      r[1] = 1;
+      if (!SWIIntrWait(true, 1)) {
+        return true;
+      }
+      break;
+    }
+    case 0x06: {
+      // Div
+      SWIDiv(r[0], r[1]);
+      break;
+    }
+    case 0x07: {
+      // DivArm
+      SWIDiv(r[1], r[0]);
+      break;
+    }
+    case 0x08: {
+      // Sqrt
+      r[0] = u16(std::sqrt(double(r[0])));
+      Tick(60);
+      break;
+    }
+    case 0x09: {
+      // ArcTan
+      r[0] = SWIArcTan(s32(r[0]));
+      Tick(50);
+      break;
+    }
+    case 0x0A: {
+      // ArcTan2
+      r[0] = SWIArcTan2(s32(r[0]), s32(r[1]));
+      Tick(80);
+      break;
+    }
+    case 0x0B: {
+      // CpuSet
+      SWICpuSet(r[0], r[1], r[2]);
+      break;
+    }
+    case 0x0C: {
+      // CpuFastSet
+      SWICpuFastSet(r[0], r[1], r[2]);
+      break;
+    }
+    case 0x0E: {
+      // BgAffineSet
+      SWIBgAffineSet(r[0], r[1], r[2]);
+      break;
+    }
+    case 0x0F: {
+      // ObjAffineSet
+      SWIObjAffineSet(r[0], r[1], r[2], r[3]);
+      break;
+    }
+    case 0x11:
+    case 0x12: {
+      // LZ77UnCompWram / LZ77UnCompVram
+      SWIDecompress(r[0], r[1], number == 0x12, &CPU::SWIDecodeLZ77);
+      break;
+    }
+    case 0x13: {
+      // HuffUnComp
+      SWIHuffUnComp(r[0], r[1]);
+      break;
+    }
+    case 0x14:
+    case 0x15: {
+      // RLUnCompWram / RLUnCompVram
+      SWIDecompress(r[0], r[1], number == 0x15, &CPU::SWIDecodeRL);
+      break;
+    }
+    default: {
+      if (memory.bios_stub) {
+        LOG_WARN("SWI 0x{0:02X} is not implemented without a BIOS image.", number);
+      }
+      return false;
+    }
+  }
+
+  Tick(kSWIDispatchCycles);
+  memory.bios_latch = kBIOSLatchAfterSWI;
+  return true;
+}
+
+void CPU::SWIRegisterRamReset(u32 flags) {
+  auto clear = [this](u32 address, u32 size) {
+    for (u32 i = 0; i < size; i += 4) {
+      Write<u32>(address + i, 0, i == 0 ? Access::Nonsequential : Access::Sequential);
+    }
+  };
+
+  if (flags & 0x01) clear(0x02000000, 0x40000);
+  // The last 0x200 bytes of IWRAM hold the stack and the BIOS variables.
+  if (flags & 0x02) clear(0x03000000, 0x7E00);
+  if (flags & 0x04) clear(0x05000000, 0x400);
+  if (flags & 0x08) clear(0x06000000, 0x18000);
+  if (flags & 0x10) clear(0x07000000, 0x400);
+  if (flags & 0xE0) {
+    LOG_WARN("RegisterRamReset: resetting I/O registers is not implemented.");
+  }
+}
+
+/* Returns false while the CPU must keep waiting. In that case the SWI
+ * instruction is repeated once an IRQ has been serviced.
+ */
+bool CPU::SWIIntrWait(bool discard_old_flags, u16 flags) {
+  // IRQ flags are acknowledged by the game's IRQ handler in the BIOS variables.
+  constexpr u32 kIntrFlags = 0x03007FF8;
+
+  Write<u16>(IME, 1, Access::Nonsequential);
+
+  if (discard_old_flags && !swi_intr_wait_retry) {
+    Write<u16>(kIntrFlags, Read<u16>(kIntrFlags, Access::Nonsequential) & ~flags, Access::Nonsequential);
+  }
+
+  u16 intr_flags = Read<u16>(kIntrFlags, Access::Nonsequential);
+
+  if (intr_flags & flags) {
+    Write<u16>(kIntrFlags, intr_flags & ~flags, Access::Nonsequential);
+    swi_intr_wait_retry = false;
+    return true;
+  }
+
+  Write<u8>(HALTCNT, 0x00, Access::Nonsequential);
+  swi_intr_wait_retry = true;
+  state.r15 -= state.cpsr.f.thumb ? 4 : 8;
+  return false;
+}
+
+void CPU::SWIDiv(s32 numerator, s32 denominator) {
+  auto& r = state.reg;
+
+  if (denominator == 0) {
+    // The BIOS never returns from a division by zero, return a sane result instead.
+    LOG_WARN("SWI Div: division by zero.");
+    r[0] = numerator < 0 ? -1 : 1;
+    r[1] = numerator;
+    r[3] = 1;
+  } else if (numerator == INT32_MIN && denominator == -1) {
+    r[0] = 0x80000000;
+    r[1] = 0;
+    r[3] = 0x80000000;
+  } else {
+    s32 quotient = numerator / denominator;
+    r[0] = quotient;
+    r[1] = numerator % denominator;
+    r[3] = quotient < 0 ? -quotient : quotient;
+  }
+
+  Tick(100);
+}
+
+/* Same polynomial approximation as the BIOS, the tangent is in 1.14 fixed-point. */
+auto CPU::SWIArcTan(s32 tan) -> u16 {
+  s32 a = -((tan * tan) >> 14);
+  s32 b = ((0xA9 * a) >> 14) + 0x390;
+  b = ((b * a) >> 14) + 0x91C;
+  b = ((b * a) >> 14) + 0xFB6;
+  b = ((b * a) >> 14) + 0x16AA;
+  b = ((b * a) >> 14) + 0x2081;
+  b = ((b * a) >> 14) + 0x3651;
+  b = ((b * a) >> 14) + 0xA2F9;
+  return u16((tan * b) >> 16);
+}
+
+auto CPU::SWIArcTan2(s32 x, s32 y) -> u16 {
+  // The BIOS shifts the dividend left by 14 bits, which may overflow.
+  auto fixed = [](s32 value) { return s32(u32(value) << 14); };
+
+  if (y == 0) return x >= 0 ? 0x0000 : 0x8000;
+  if (x == 0) return y >= 0 ? 0x4000 : 0xC000;
+
+  if (y >= 0) {
+    if (x >= 0) {
+      if (x >= y) return SWIArcTan(fixed(y) / x);
+    } else if (-x >= y) {
+      return SWIArcTan(fixed(y) / x) + 0x8000;
+    }
+    return 0x4000 - SWIArcTan(fixed(x) / y);
+  } else {
+    if (x <= 0) {
+      if (-x > -y) return SWIArcTan(fixed(y) / x) + 0x8000;
+    } else if (x >= -y) {
+      return SWIArcTan(fixed(y) / x);
+    }
+    return 0xC000 - SWIArcTan(fixed(x) / y);
+  }
+}
+
+void CPU::SWICpuSet(u32 src, u32 dst, u32 control) {
+  // The BIOS refuses to read from its own memory.
+  if ((src & 0x0E000000) == 0) {
+    return;
+  }
+
+  int count = control & 0x1FFFFF;
+  bool fill = control & (1 << 24);
+  auto access = Access::Nonsequential;
+
+  if (control & (1 << 26)) {
+    src &= ~3;
+    dst &= ~3;
+    for (int i = 0; i < count; i++) {
+      Write<u32>(dst, Read<u32>(src, access), access);
+      access = Access::Sequential;
+      if (!fill) src += 4;
+      dst += 4;
+    }
+  } else {
+    src &= ~1;
+    dst &= ~1;
+    for (int i = 0; i < count; i++) {
+      Write<u16>(dst, Read<u16>(src, access), access);
+      access = Access::Sequential;
+      if (!fill) src += 2;
+      dst += 2;
+    }
+  }
+}
+
+void CPU::SWICpuFastSet(u32 src, u32 dst, u32 control) {
+  if ((src & 0x0E000000) == 0) {
+    return;
+  }
+
+  // The BIOS transfers blocks of eight words.
+  int count = ((control & 0x1FFFFF) + 7) & ~7;
+  bool fill = control & (1 << 24);
+  auto access = Access::Nonsequential;
+
+  src &= ~3;
+  dst &= ~3;
+
+  u32 value = fill ? Read<u32>(src, access) : 0;
+
+  for (int i = 0; i < count; i++) {
+    if (!fill) value = Read<u32>(src + i * 4, access);
+    Write<u32>(dst + i * 4, value, access);
+    access = Access::Sequential;
+  }
+}
+
+void CPU::SWIBgAffineSet(u32 src, u32 dst, int count) {
+  for (int i = 0; i < count; i++) {
+    double ox = s32(Read<u32>(src +  0, Access::Nonsequential)) / 256.0;
+    double oy = s32(Read<u32>(src +  4, Access::Sequential)) / 256.0;
+    double cx = s16(Read<u16>(src +  8, Access::Sequential));
+    double cy = s16(Read<u16>(src + 10, Access::Sequential));
+    double sx = s16(Read<u16>(src + 12, Access::Sequential)) / 256.0;
+    double sy = s16(Read<u16>(src + 14, Access::Sequential)) / 256.0;
+    double theta = (Read<u16>(src + 16, Access::Sequential) >> 8) / 128.0 * M_PI;
+
+    double pa =  std::cos(theta) * sx;
+    double pb = -std::sin(theta) * sx;
+    double pc =  std::sin(theta) * sy;
+    double pd =  std::cos(theta) * sy;
+    double x = ox - (pa * cx + pb * cy);
+    double y = oy - (pc * cx + pd * cy);
+
+    Write<u16>(dst +  0, u16(s16(pa * 256)), Access::Nonsequential);
+    Write<u16>(dst +  2, u16(s16(pb * 256)), Access::Sequential);
+    Write<u16>(dst +  4, u16(s16(pc * 256)), Access::Sequential);
+    Write<u16>(dst +  6, u16(s16(pd * 256)), Access::Sequential);
+    Write<u32>(dst +  8, u32(s32(x * 256)), Access::Sequential);
+    Write<u32>(dst + 12, u32(s32(y * 256)), Access::Sequential);
+
+    src += 20;
+    dst += 16;
+    Tick(60);
+  }
+}
+
+void CPU::SWIObjAffineSet(u32 src, u32 dst, int count, int stride) {
+  for (int i = 0; i < count; i++) {
+    double sx = s16(Read<u16>(src + 0, Access::Nonsequential)) / 256.0;
+    double sy = s16(Read<u16>(src + 2, Access::Sequential)) / 256.0;
+    double theta = (Read<u16>(src + 4, Access::Sequential) >> 8) / 128.0 * M_PI;
+
+    double pa =  std::cos(theta) * sx;
+    double pb = -std::sin(theta) * sx;
+    double pc =  std::sin(theta) * sy;
+    double pd =  std::cos(theta) * sy;
+
+    Write<u16>(dst + stride * 0, u16(s16(pa * 256)), Access::Nonsequential);
+    Write<u16>(dst + stride * 1, u16(s16(pb * 256)), Access::Nonsequential);
+    Write<u16>(dst + stride * 2, u16(s16(pc * 256)), Access::Nonsequential);
+    Write<u16>(dst + stride * 3, u16(s16(pd * 256)), Access::Nonsequential);
+
+    src += 8;
+    dst += stride * 4;
+    Tick(40);
+  }
+}
+
+/* Decompresses into a temporary buffer which is then written out in units
+ * of bytes (WRAM variants) or halfwords (VRAM variants).
+ */
+void CPU::SWIDecompress(u32 src, u32 dst, bool vram, void (CPU::*decode)(u32, size_t, std::vector<u8>&)) {
+  if ((src & 0x0E000000) == 0) {
+    return;
+  }
+
+  size_t size = Read<u32>(src, Access::Nonsequential) >> 8;
+  std::vector<u8> output;
+
+  output.reserve(size);
+  (this->*decode)(src + 4, size, output);
+  output.resize(size);
+
+  auto access = Access::Nonsequential;
+
+  if (vram) {
+    output.resize((output.size() + 1) & ~1);
+    for (size_t i = 0; i < output.size(); i += 2) {
+      Write<u16>(dst + i, output[i] | (output[i + 1] << 8), access);
+      access = Access::Sequential;
+    }
+  } else {
+    for (size_t i = 0; i < output.size(); i++) {
+      Write<u8>(dst + i, output[i], access);
+      access = Access::Sequential;
+    }
+  }
+}
+
+void CPU::SWIDecodeLZ77(u32 src, size_t size, std::vector<u8>& output) {
+  while (output.size() < size) {
+    u8 flags = Read<u8>(src++, Access::Sequential);
+
+    for (int i = 0; i < 8 && output.size() < size; i++) {
+      if (flags & (0x80 >> i)) {
+        u8 byte0 = Read<u8>(src++, Access::Sequential);
+        u8 byte1 = Read<u8>(src++, Access::Sequential);
+        size_t length = (byte0 >> 4) + 3;
+        size_t disp = (((byte0 & 0xF) << 8) | byte1) + 1;
+
+        for (size_t j = 0; j < length; j++) {
+          output.push_back(disp <= output.size() ? output[output.size() - disp] : 0);
+        }
+      } else {
+        output.push_back(Read<u8>(src++, Access::Sequential));
+      }
+    }
+  }
+}
+
+void CPU::SWIDecodeRL(u32 src, size_t size, std::vector<u8>& output) {
+  while (output.size() < size) {
+    u8 flag = Read<u8>(src++, Access::Sequential);
+
+    if (flag & 0x80) {
+      u8 byte = Read<u8>(src++, Access::Sequential);
+      output.insert(output.end(), (flag & 0x7F) + 3, byte);
+    } else {
+      for (int i = 0; i <= (flag & 0x7F); i++) {
+        output.push_back(Read<u8>(src++, Access::Sequential));
+      }
+    }
+  }
+}
+
+void CPU::SWIHuffUnComp(u32 src, u32 dst) {
+  if ((src & 0x0E000000) == 0) {
+    return;
+  }
+
+  u32 header = Read<u32>(src, Access::Nonsequential);
+  int bits = header & 15;
+  s32 size = header >> 8;
+
+  if (bits != 4 && bits != 8) {
+    LOG_WARN("SWI HuffUnComp: unsupported data size of {0} bits.", bits);
+    return;
+  }
+
+  u32 tree = src + 4;
+  u32 root = tree + 1;
+  u32 stream = tree + (Read<u8>(tree, Access::Sequential) + 1) * 2;
+
+  u32 node_address = root;
+  u8  node = Read<u8>(root, Access::Sequential);
+  u32 output = 0;
+  int output_bits = 0;
+
+  while (size > 0) {
+    u32 word = Read<u32>(stream, Access::Sequential);
+    stream += 4;
+
+    for (int i = 31; i >= 0 && size > 0; i--) {
+      int bit = (word >> i) & 1;
+      bool leaf = node & (0x80 >> bit);
+
+      node_address = (node_address & ~1) + (node & 0x3F) * 2 + 2 + bit;
+      node = Read<u8>(node_address, Access::Sequential);
+
+      if (leaf) {
+        output |= (node & ((1 << bits) - 1)) << output_bits;
+        output_bits += bits;
+
+        if (output_bits == 32) {
+          Write<u32>(dst, output, Access::Sequential);
+          dst += 4;
+          size -= 4;
+          output = 0;
+          output_bits = 0;
+        }
+
+        node_address = root;
+        node = Read<u8>(root, Access::Sequential);
+      }
+    }
+  }
+}
+
+} // namespace nba::core
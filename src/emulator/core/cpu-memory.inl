@@ -23,6 +23,57 @@ inline u32 CPU::ReadBIOS(u32 address) {
   return memory.bios_latch >> shift;
 }
 
+template<typename T>
+inline auto CPU::ReadMMIO(u32 address) -> T {
+  // Only the first 1 KiB of the I/O page is decoded.
+  if (unlikely(address & 0x00FFFC00)) {
+    return T(ReadUnused(address));
+  }
+
+  auto& reg = mmio_table[(address & 0x3FF) >> 1];
+
+  if constexpr (std::is_same_v<T, u32>) {
+    if (reg.read32 != nullptr) {
+      return reg.read32(*this, address);
+    }
+    return reg.read(*this, address) |
+          (u32(mmio_table[((address & 0x3FF) >> 1) + 1].read(*this, address + 2)) << 16);
+  }
+
+  if constexpr (std::is_same_v<T, u16>) {
+    return reg.read(*this, address);
+  }
+
+  return u8(reg.read(*this, address & ~1) >> ((address & 1) * 8));
+}
+
+template<typename T>
+inline void CPU::WriteMMIO(u32 address, T value) {
+  if (unlikely(address & 0x00FFFC00)) {
+    return;
+  }
+
+  auto& reg = mmio_table[(address & 0x3FF) >> 1];
+
+  if constexpr (std::is_same_v<T, u32>) {
+    if (reg.write32 != nullptr) {
+      reg.write32(*this, address, value);
+    } else {
+      reg.write(*this, address, u16(value), 0xFFFF);
+      mmio_table[((address & 0x3FF) >> 1) + 1].write(*this, address + 2, u16(value >> 16), 0xFFFF);
+    }
+  }
+
+  if constexpr (std::is_same_v<T, u16>) {
+    reg.write(*this, address, value, 0xFFFF);
+  }
+
+  if constexpr (std::is_same_v<T, u8>) {
+    int shift = (address & 1) * 8;
+    reg.write(*this, address & ~1, u16(value << shift), u16(0xFF << shift));
+  }
+}
+
 inline u32 CPU::ReadUnused(u32 address) {
   u32 result = 0;
 
@@ -72,8 +123,54 @@ inline u32 CPU::ReadUnused(u32 address) {
   return result >> ((address & 3) * 8);
 }
 
+/* Code may be cached if it cannot change (BIOS and ROM) or if every write
+ * to it invalidates the block cache. Writes invalidate the canonical address,
+ * so code in EWRAM and IWRAM is only cached when run from that address.
+ */
+inline auto CPU::GetCodePointer(u32 address) -> u8 const* {
+  switch (address >> 24) {
+    case 0x00: {
+      return address < 0x4000 ? &memory.bios[address] : nullptr;
+    }
+    case 0x02: {
+      return address < 0x02040000 ? &memory.wram[address & 0x3FFFF] : nullptr;
+    }
+    case 0x03: {
+      return address < 0x03008000 ? &memory.iram[address & 0x7FFF] : nullptr;
+    }
+    case 0x08 ... 0x0D: {
+      auto rom = game_pak.GetROMPointer(address & ~3, 4);
+
+      return rom != nullptr ? rom + (address & 3) : nullptr;
+    }
+  }
+
+  return nullptr;
+}
+
 template<typename T>
 auto CPU::Read(u32 address, Access access) -> T {
+  if (likely(address < 0x10000000)) {
+    auto& entry = page_table[address >> kPageShift];
+
+    if (likely(entry.read != nullptr)) {
+      address &= ~(sizeof(T) - 1);
+
+      if ((address & 0x1FFFF) == 0) {
+        access = Access::Nonsequential;
+      }
+
+      int cycles = entry.cycles[std::is_same_v<T, u32>][int(access)];
+
+      if (entry.rom) {
+        PrefetchStepROM(address, cycles);
+      } else {
+        PrefetchStepRAM(cycles);
+      }
+      return common::read<T>(entry.read, address & kPageMask);
+    }
+  }
+
   int cycles;
   int page = address >> 24;
 
@@ -106,17 +203,7 @@ auto CPU::Read(u32 address, Access access) -> T {
     }
     case 0x04: {
       PrefetchStepRAM(cycles);
-      if constexpr (std::is_same_v<T, u32>) {
-        return (ReadMMIO(address + 0) <<  0) |
-               (ReadMMIO(address + 1) <<  8) |
-               (ReadMMIO(address + 2) << 16) |
-               (ReadMMIO(address + 3) << 24);
-      }
-      if constexpr (std::is_same_v<T, u16>) {
-        return (ReadMMIO(address + 0) << 0) |
-               (ReadMMIO(address + 1) << 8);
-      }
-      return ReadMMIO(address);
+      return ReadMMIO<T>(address);
     }
     case 0x05: {
       PrefetchStepRAM(cycles);
@@ -132,6 +219,8 @@ auto CPU::Read(u32 address, Access access) -> T {
     }
     case 0x08 ... 0x0D: {
       PrefetchStepROM(address, cycles);
+      // GPIO and EEPROM reads end up here.
+      idle_loop_unsafe |= !code;
       if constexpr (std::is_same_v<T,  u8>) {
         return game_pak.ReadROM16(address) >> ((address & 1) << 3);
       }
@@ -145,6 +234,7 @@ auto CPU::Read(u32 address, Access access) -> T {
     }
     case 0x0E ... 0x0F: {
       PrefetchStepROM(address, cycles);
+      idle_loop_unsafe = true;
       u32 value = game_pak.ReadSRAM(address);
       if (std::is_same_v<T, u16>) value *= 0x0101;
       if (std::is_same_v<T, u32>) value *= 0x01010101;
@@ -161,6 +251,23 @@ auto CPU::Read(u32 address, Access access) -> T {
 
 template<typename T>
 void CPU::Write(u32 address, T value, Access access) {
+  if (likely(address < 0x10000000)) {
+    auto& entry = page_table[address >> kPageShift];
+
+    if (likely(entry.write != nullptr)) {
+      address &= ~(sizeof(T) - 1);
+
+      if ((address & 0x1FFFF) == 0) {
+        access = Access::Nonsequential;
+      }
+
+      PrefetchStepRAM(entry.cycles[std::is_same_v<T, u32>][int(access)]);
+      common::write<T>(entry.write, address & kPageMask, value);
+      InvalidateBlockCache(entry.canonical | (address & kPageMask));
+      return;
+    }
+  }
+
   int cycles;
   int page = address >> 24;
 
@@ -182,25 +289,18 @@ void CPU::Write(u32 address, T value, Access access) {
     case 0x02: {
       PrefetchStepRAM(cycles);
       common::write<T>(memory.wram, address & 0x3FFFF, value);
+      InvalidateBlockCache(0x02000000 | (address & 0x3FFFF));
       break;
     }
     case 0x03: {
       PrefetchStepRAM(cycles);
       common::write<T>(memory.iram, address & 0x7FFF,  value);
+      InvalidateBlockCache(0x03000000 | (address & 0x7FFF));
       break;
     }
     case 0x04: {
       PrefetchStepRAM(cycles);
-      if constexpr (std::is_same_v<T, u32>) {
-        WriteMMIO16(address + 0, value & 0xFFFF);
-        WriteMMIO16(address + 2, value >> 16);
-      }
-      if constexpr (std::is_same_v<T, u16>) {
-        WriteMMIO16(address, value);
-      }
-      if constexpr (std::is_same_v<T, u8>) {
-        WriteMMIO(address, value & 0xFF);
-      }
+      WriteMMIO<T>(address, value);
       break;
     }
     case 0x05: {
@@ -235,6 +335,7 @@ void CPU::Write(u32 address, T value, Access access) {
     }
     case 0x0E ... 0x0F: {
       PrefetchStepROM(address, cycles);
+      idle_loop_unsafe = true;
         
       if constexpr (std::is_same_v<T, u32>) value >>= (address & 3) << 3;
       if constexpr (std::is_same_v<T, u16>) value >>= (address & 1) << 3;
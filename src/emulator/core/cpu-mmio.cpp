@@ -10,587 +10,462 @@
 
 namespace nba::core {
 
+/* Helpers for registers which are exposed by their owner as
+ * a sequence of bytes (Read(offset) / Write(offset, value)).
+ */
+template<typename Register>
+static auto ReadBytes16(Register& reg, int offset) -> u16 {
+  return reg.Read(offset) | (reg.Read(offset + 1) << 8);
+}
 
-auto CPU::ReadMMIO(u32 address) -> u8 {
-  auto& apu_io = apu.mmio;
-  auto& ppu_io = ppu.mmio;
-
-  switch (address) {
-    /* PPU */
-    case DISPCNT+0:  return ppu_io.dispcnt.Read(0);
-    case DISPCNT+1:  return ppu_io.dispcnt.Read(1);
-    case DISPSTAT+0: return ppu_io.dispstat.Read(0);
-    case DISPSTAT+1: return ppu_io.dispstat.Read(1);
-    case VCOUNT+0:   return ppu_io.vcount & 0xFF;
-    case VCOUNT+1:   return 0;
-    case BG0CNT+0:   return ppu_io.bgcnt[0].Read(0);
-    case BG0CNT+1:   return ppu_io.bgcnt[0].Read(1);
-    case BG1CNT+0:   return ppu_io.bgcnt[1].Read(0);
-    case BG1CNT+1:   return ppu_io.bgcnt[1].Read(1);
-    case BG2CNT+0:   return ppu_io.bgcnt[2].Read(0);
-    case BG2CNT+1:   return ppu_io.bgcnt[2].Read(1);
-    case BG3CNT+0:   return ppu_io.bgcnt[3].Read(0);
-    case BG3CNT+1:   return ppu_io.bgcnt[3].Read(1);
-    case WININ+0:    return ppu_io.winin.Read(0);
-    case WININ+1:    return ppu_io.winin.Read(1);
-    case WINOUT+0:   return ppu_io.winout.Read(0);
-    case WINOUT+1:   return ppu_io.winout.Read(1);
-    case BLDCNT+0:   return ppu_io.bldcnt.Read(0);
-    case BLDCNT+1:   return ppu_io.bldcnt.Read(1);
-    case BLDALPHA+0: return ppu_io.eva;
-    case BLDALPHA+1: return ppu_io.evb;
-
-    /* DMAs 0-3 */
-    case DMA0CNT_L:
-    case DMA0CNT_L+1: return 0;
-    case DMA0CNT_H:   return dma.Read(0, 10);
-    case DMA0CNT_H+1: return dma.Read(0, 11);
-    case DMA1CNT_L:
-    case DMA1CNT_L+1: return 0;
-    case DMA1CNT_H:   return dma.Read(1, 10);
-    case DMA1CNT_H+1: return dma.Read(1, 11);
-    case DMA2CNT_L:
-    case DMA2CNT_L+1: return 0;
-    case DMA2CNT_H:   return dma.Read(2, 10);
-    case DMA2CNT_H+1: return dma.Read(2, 11);
-    case DMA3CNT_L:
-    case DMA3CNT_L+1: return 0;
-    case DMA3CNT_H:   return dma.Read(3, 10);
-    case DMA3CNT_H+1: return dma.Read(3, 11);
-
-    /* SOUND */
-    case SOUND1CNT_L:   return apu_io.psg1.Read(0);
-    case SOUND1CNT_L+1: return apu_io.psg1.Read(1);
-    case SOUND1CNT_H:   return apu_io.psg1.Read(2);
-    case SOUND1CNT_H+1: return apu_io.psg1.Read(3);
-    case SOUND1CNT_X:   return apu_io.psg1.Read(4);
-    case SOUND1CNT_X+1: return apu_io.psg1.Read(5);
-    case SOUND1CNT_X+2:
-    case SOUND1CNT_X+3: return 0;
-    case SOUND2CNT_L:   return apu_io.psg2.Read(2);
-    case SOUND2CNT_L+1: return apu_io.psg2.Read(3);
-    case SOUND2CNT_H:   return apu_io.psg2.Read(4);
-    case SOUND2CNT_H+1: return apu_io.psg2.Read(5);
-    case SOUND2CNT_H+2:
-    case SOUND2CNT_H+3: return 0;
-    case SOUND3CNT_L:   return apu_io.psg3.Read(0);
-    case SOUND3CNT_L+1: return apu_io.psg3.Read(1);
-    case SOUND3CNT_H:   return apu_io.psg3.Read(2);
-    case SOUND3CNT_H+1: return apu_io.psg3.Read(3);
-    case SOUND3CNT_X:   return apu_io.psg3.Read(4);
-    case SOUND3CNT_X+1: return apu_io.psg3.Read(5);
-    case SOUND3CNT_X+2:
-    case SOUND3CNT_X+3: return 0;
-    case SOUND4CNT_L:   return apu_io.psg4.Read(0);
-    case SOUND4CNT_L+1: return apu_io.psg4.Read(1);
-    case SOUND4CNT_L+2:
-    case SOUND4CNT_L+3: return 0;
-    case SOUND4CNT_H:   return apu_io.psg4.Read(4);
-    case SOUND4CNT_H+1: return apu_io.psg4.Read(5);
-    case SOUND4CNT_H+2:
-    case SOUND4CNT_H+3: return 0;
-    case WAVE_RAM + 0:
-    case WAVE_RAM + 1:
-    case WAVE_RAM + 2:
-    case WAVE_RAM + 3:
-    case WAVE_RAM + 4:
-    case WAVE_RAM + 5:
-    case WAVE_RAM + 6:
-    case WAVE_RAM + 7:
-    case WAVE_RAM + 8:
-    case WAVE_RAM + 9:
-    case WAVE_RAM + 10:
-    case WAVE_RAM + 11:
-    case WAVE_RAM + 12:
-    case WAVE_RAM + 13:
-    case WAVE_RAM + 14:
-    case WAVE_RAM + 15: {
-      return apu_io.psg3.ReadSample(address & 0xF);
-    }
-    case SOUNDCNT_L:   return apu_io.soundcnt.Read(0);
-    case SOUNDCNT_L+1: return apu_io.soundcnt.Read(1);
-    case SOUNDCNT_H:   return apu_io.soundcnt.Read(2);
-    case SOUNDCNT_H+1: return apu_io.soundcnt.Read(3);
-    case SOUNDCNT_X:   return apu_io.soundcnt.Read(4);
-    case SOUNDCNT_X+1:
-    case SOUNDCNT_X+2:
-    case SOUNDCNT_X+3: return 0;
-    case SOUNDBIAS:   return apu_io.bias.Read(0);
-    case SOUNDBIAS+1: return apu_io.bias.Read(1);
-    case SOUNDBIAS+2:
-    case SOUNDBIAS+3: return 0;
-
-    /* Timers 0-3 */
-    case TM0CNT_L:   return timer.Read(0, 0);
-    case TM0CNT_L+1: return timer.Read(0, 1);
-    case TM0CNT_H:   return timer.Read(0, 2);
-    case TM0CNT_H+1: return 0;
-    case TM1CNT_L:   return timer.Read(1, 0);
-    case TM1CNT_L+1: return timer.Read(1, 1);
-    case TM1CNT_H:   return timer.Read(1, 2);
-    case TM1CNT_H+1: return 0;
-    case TM2CNT_L:   return timer.Read(2, 0);
-    case TM2CNT_L+1: return timer.Read(2, 1);
-    case TM2CNT_H:   return timer.Read(2, 2);
-    case TM2CNT_H+1: return 0;
-    case TM3CNT_L:   return timer.Read(3, 0);
-    case TM3CNT_L+1: return timer.Read(3, 1);
-    case TM3CNT_H:   return timer.Read(3, 2);
-    case TM3CNT_H+1: return 0;
-
-    /* Serial Communication (1, 2) */
-    case SIOMULTI0 | 0:
-    case SIOMULTI0 | 1:
-    case SIOMULTI1 | 0:
-    case SIOMULTI1 | 1:
-    case SIOMULTI2 | 0:
-    case SIOMULTI2 | 1:
-    case SIOMULTI3 | 0:
-    case SIOMULTI3 | 1:
-    case SIOCNT | 0:
-    case SIOCNT | 1:
-    case SIOMLT_SEND | 0:
-    case SIOMLT_SEND | 1:
-    case RCNT | 0:
-    case RCNT | 1:
-    case RCNT | 2:
-    case RCNT | 3:
-    case JOYCNT | 0:
-    case JOYCNT | 1:
-    case JOYCNT | 2:
-    case JOYCNT | 3:
-    case JOY_RECV | 0:
-    case JOY_RECV | 1:
-    case JOY_RECV | 2:
-    case JOY_RECV | 3:
-    case JOY_TRANS | 0:
-    case JOY_TRANS | 1:
-    case JOY_TRANS | 2:
-    case JOY_TRANS | 3:
-    case JOYSTAT | 0:
-    case JOYSTAT | 1:
-    case JOYSTAT | 2:
-    case JOYSTAT | 3:
-      return serial_bus.Read(address);
-
-    case KEYINPUT+0: {
-      return mmio.keyinput & 0x00FF;
-    }
-    case KEYINPUT+1: {
-      return (mmio.keyinput & 0xFF00) >> 8;
-    }
+template<typename Register>
+static void WriteBytes16(Register& reg, int offset, u16 value, u16 mask) {
+  if (mask & 0x00FF) reg.Write(offset + 0, u8(value));
+  if (mask & 0xFF00) reg.Write(offset + 1, u8(value >> 8));
+}
 
-    case KEYCNT: {
-      return mmio.keycnt.input_mask & 0x00FF;
-    }
-    case KEYCNT+1: {
-      return ((mmio.keycnt.input_mask >> 8) & 3) |
-             (mmio.keycnt.interrupt << 6) |
-             (mmio.keycnt.and_mode << 7);
-    }
+void CPU::SetupMMIOTable() {
+  using ReadFn = u16 (*)(CPU&, u32);
+  using WriteFn = void (*)(CPU&, u32, u16, u16);
 
-    /* Interrupt Control */
-    case IE+0:  return irq.Read(0);
-    case IE+1:  return irq.Read(1);
-    case IF+0:  return irq.Read(2);
-    case IF+1:  return irq.Read(3);
-    case IME+0: return irq.Read(4);
-    case IME+1:
-    case IME+2:
-    case IME+3: return 0;
-
-    /* Waitstates */
-    case WAITCNT+0: {
-      return mmio.waitcnt.sram |
-             (mmio.waitcnt.ws0_n << 2) |
-             (mmio.waitcnt.ws0_s << 4) |
-             (mmio.waitcnt.ws1_n << 5) |
-             (mmio.waitcnt.ws1_s << 7);
-    }
-    case WAITCNT+1: {
-      return mmio.waitcnt.ws2_n |
-             (mmio.waitcnt.ws2_s << 2) |
-             (mmio.waitcnt.phi << 3) |
-             (mmio.waitcnt.prefetch << 6);
-    }
-    case WAITCNT+2:
-    case WAITCNT+3: return 0;
-    case POSTFLG: return mmio.postflg;
+  ReadFn read_unused = [](CPU& cpu, u32 address) -> u16 {
+    return cpu.ReadUnused(address);
+  };
+
+  ReadFn read_zero = [](CPU&, u32) -> u16 {
+    return 0;
+  };
+
+  WriteFn write_ignore = [](CPU&, u32, u16, u16) {};
+
+  for (auto& reg : mmio_table) {
+    reg = { read_unused, write_ignore, nullptr, nullptr };
   }
 
-  return ReadUnused(address);
-}
+  auto map = [this](u32 address, ReadFn read, WriteFn write) {
+    auto& reg = mmio_table[(address & 0x3FF) >> 1];
+    reg.read  = read;
+    reg.write = write;
+  };
 
-void CPU::WriteMMIO(u32 address, u8 value) {
-  auto& apu_io = apu.mmio;
-  auto& ppu_io = ppu.mmio;
-
-  switch (address) {
-    /* PPU */
-    case DISPCNT+0:  ppu_io.dispcnt.Write(0, value); break;
-    case DISPCNT+1:  ppu_io.dispcnt.Write(1, value); break;
-    case DISPSTAT+0: ppu_io.dispstat.Write(0, value); break;
-    case DISPSTAT+1: ppu_io.dispstat.Write(1, value); break;
-    case BG0CNT+0:   ppu_io.bgcnt[0].Write(0, value); break;
-    case BG0CNT+1:   ppu_io.bgcnt[0].Write(1, value); break;
-    case BG1CNT+0:   ppu_io.bgcnt[1].Write(0, value); break;
-    case BG1CNT+1:   ppu_io.bgcnt[1].Write(1, value); break;
-    case BG2CNT+0:   ppu_io.bgcnt[2].Write(0, value); break;
-    case BG2CNT+1:   ppu_io.bgcnt[2].Write(1, value); break;
-    case BG3CNT+0:   ppu_io.bgcnt[3].Write(0, value); break;
-    case BG3CNT+1:   ppu_io.bgcnt[3].Write(1, value); break;
-    case BG0HOFS+0:
-      ppu_io.bghofs[0] &= 0xFF00;
-      ppu_io.bghofs[0] |= value;
-      break;
-    case BG0HOFS+1:
-      ppu_io.bghofs[0] &= 0x00FF;
-      ppu_io.bghofs[0] |= (value & 1) << 8;
-      break;
-    case BG0VOFS+0:
-      ppu_io.bgvofs[0] &= 0xFF00;
-      ppu_io.bgvofs[0] |= value;
-      break;
-    case BG0VOFS+1:
-      ppu_io.bgvofs[0] &= 0x00FF;
-      ppu_io.bgvofs[0] |= (value & 1) << 8;
-      break;
-    case BG1HOFS+0:
-      ppu_io.bghofs[1] &= 0xFF00;
-      ppu_io.bghofs[1] |= value;
-      break;
-    case BG1HOFS+1:
-      ppu_io.bghofs[1] &= 0x00FF;
-      ppu_io.bghofs[1] |= (value & 1) << 8;
-      break;
-    case BG1VOFS+0:
-      ppu_io.bgvofs[1] &= 0xFF00;
-      ppu_io.bgvofs[1] |= value;
-      break;
-    case BG1VOFS+1:
-      ppu_io.bgvofs[1] &= 0x00FF;
-      ppu_io.bgvofs[1] |= (value & 1) << 8;
-      break;
-    case BG2HOFS+0:
-      ppu_io.bghofs[2] &= 0xFF00;
-      ppu_io.bghofs[2] |= value;
-      break;
-    case BG2HOFS+1:
-      ppu_io.bghofs[2] &= 0x00FF;
-      ppu_io.bghofs[2] |= (value & 1) << 8;
-      break;
-    case BG2VOFS+0:
-      ppu_io.bgvofs[2] &= 0xFF00;
-      ppu_io.bgvofs[2] |= value;
-      break;
-    case BG2VOFS+1:
-      ppu_io.bgvofs[2] &= 0x00FF;
-      ppu_io.bgvofs[2] |= (value & 1) << 8;
-      break;
-    case BG3HOFS+0:
-      ppu_io.bghofs[3] &= 0xFF00;
-      ppu_io.bghofs[3] |= value;
-      break;
-    case BG3HOFS+1:
-      ppu_io.bghofs[3] &= 0x00FF;
-      ppu_io.bghofs[3] |= (value & 1) << 8;
-      break;
-    case BG3VOFS+0:
-      ppu_io.bgvofs[3] &= 0xFF00;
-      ppu_io.bgvofs[3] |= value;
-      break;
-    case BG3VOFS+1:
-      ppu_io.bgvofs[3] &= 0x00FF;
-      ppu_io.bgvofs[3] |= (value & 1) << 8;
-      break;
-
-    case BG2PA:   ppu_io.bgpa[0] = (ppu_io.bgpa[0] & 0xFF00) | (value << 0); break;
-    case BG2PA+1: ppu_io.bgpa[0] = (ppu_io.bgpa[0] & 0x00FF) | (value << 8); break;
-    case BG2PB:   ppu_io.bgpb[0] = (ppu_io.bgpb[0] & 0xFF00) | (value << 0); break;
-    case BG2PB+1: ppu_io.bgpb[0] = (ppu_io.bgpb[0] & 0x00FF) | (value << 8); break;
-    case BG2PC:   ppu_io.bgpc[0] = (ppu_io.bgpc[0] & 0xFF00) | (value << 0); break;
-    case BG2PC+1: ppu_io.bgpc[0] = (ppu_io.bgpc[0] & 0x00FF) | (value << 8); break;
-    case BG2PD:   ppu_io.bgpd[0] = (ppu_io.bgpd[0] & 0xFF00) | (value << 0); break;
-    case BG2PD+1: ppu_io.bgpd[0] = (ppu_io.bgpd[0] & 0x00FF) | (value << 8); break;
-    case BG2X:    ppu_io.bgx[0].Write(0, value); break;
-    case BG2X+1:  ppu_io.bgx[0].Write(1, value); break;
-    case BG2X+2:  ppu_io.bgx[0].Write(2, value); break;
-    case BG2X+3:  ppu_io.bgx[0].Write(3, value); break;
-    case BG2Y:    ppu_io.bgy[0].Write(0, value); break;
-    case BG2Y+1:  ppu_io.bgy[0].Write(1, value); break;
-    case BG2Y+2:  ppu_io.bgy[0].Write(2, value); break;
-    case BG2Y+3:  ppu_io.bgy[0].Write(3, value); break;
-    case BG3PA:   ppu_io.bgpa[1] = (ppu_io.bgpa[1] & 0xFF00) | (value << 0); break;
-    case BG3PA+1: ppu_io.bgpa[1] = (ppu_io.bgpa[1] & 0x00FF) | (value << 8); break;
-    case BG3PB:   ppu_io.bgpb[1] = (ppu_io.bgpb[1] & 0xFF00) | (value << 0); break;
-    case BG3PB+1: ppu_io.bgpb[1] = (ppu_io.bgpb[1] & 0x00FF) | (value << 8); break;
-    case BG3PC:   ppu_io.bgpc[1] = (ppu_io.bgpc[1] & 0xFF00) | (value << 0); break;
-    case BG3PC+1: ppu_io.bgpc[1] = (ppu_io.bgpc[1] & 0x00FF) | (value << 8); break;
-    case BG3PD:   ppu_io.bgpd[1] = (ppu_io.bgpd[1] & 0xFF00) | (value << 0); break;
-    case BG3PD+1: ppu_io.bgpd[1] = (ppu_io.bgpd[1] & 0x00FF) | (value << 8); break;
-    case BG3X:    ppu_io.bgx[1].Write(0, value); break;
-    case BG3X+1:  ppu_io.bgx[1].Write(1, value); break;
-    case BG3X+2:  ppu_io.bgx[1].Write(2, value); break;
-    case BG3X+3:  ppu_io.bgx[1].Write(3, value); break;
-    case BG3Y:    ppu_io.bgy[1].Write(0, value); break;
-    case BG3Y+1:  ppu_io.bgy[1].Write(1, value); break;
-    case BG3Y+2:  ppu_io.bgy[1].Write(2, value); break;
-    case BG3Y+3:  ppu_io.bgy[1].Write(3, value); break;
-
-    case WIN0H+0: ppu_io.winh[0].Write(0, value); break;
-    case WIN0H+1: ppu_io.winh[0].Write(1, value); break;
-    case WIN1H+0: ppu_io.winh[1].Write(0, value); break;
-    case WIN1H+1: ppu_io.winh[1].Write(1, value); break;
-    case WIN0V+0: ppu_io.winv[0].Write(0, value); break;
-    case WIN0V+1: ppu_io.winv[0].Write(1, value); break;
-    case WIN1V+0: ppu_io.winv[1].Write(0, value); break;
-    case WIN1V+1: ppu_io.winv[1].Write(1, value); break;
-    case WININ+0: ppu_io.winin.Write(0, value); break;
-    case WININ+1: ppu_io.winin.Write(1, value); break;
-    case WINOUT+0: ppu_io.winout.Write(0, value); break;
-    case WINOUT+1: ppu_io.winout.Write(1, value); break;
-    case MOSAIC+0: ppu_io.mosaic.Write(0, value); break;
-    case MOSAIC+1: ppu_io.mosaic.Write(1, value); break;
-    case BLDCNT+0: ppu_io.bldcnt.Write(0, value); break;
-    case BLDCNT+1: ppu_io.bldcnt.Write(1, value); break;
-    case BLDALPHA+0: ppu_io.eva = value & 0x1F; break;
-    case BLDALPHA+1: ppu_io.evb = value & 0x1F; break;
-    case BLDY: ppu_io.evy = value & 0x1F; break;
-
-    /* DMAs 0-3 */
-    case DMA0SAD:     dma.Write(0, 0, value); break;
-    case DMA0SAD+1:   dma.Write(0, 1, value); break;
-    case DMA0SAD+2:   dma.Write(0, 2, value); break;
-    case DMA0SAD+3:   dma.Write(0, 3, value); break;
-    case DMA0DAD:     dma.Write(0, 4, value); break;
-    case DMA0DAD+1:   dma.Write(0, 5, value); break;
-    case DMA0DAD+2:   dma.Write(0, 6, value); break;
-    case DMA0DAD+3:   dma.Write(0, 7, value); break;
-    case DMA0CNT_L:   dma.Write(0, 8, value); break;
-    case DMA0CNT_L+1: dma.Write(0, 9, value); break;
-    case DMA0CNT_H:   dma.Write(0, 10, value); break;
-    case DMA0CNT_H+1: dma.Write(0, 11, value); break;
-    case DMA1SAD:     dma.Write(1, 0, value); break;
-    case DMA1SAD+1:   dma.Write(1, 1, value); break;
-    case DMA1SAD+2:   dma.Write(1, 2, value); break;
-    case DMA1SAD+3:   dma.Write(1, 3, value); break;
-    case DMA1DAD:     dma.Write(1, 4, value); break;
-    case DMA1DAD+1:   dma.Write(1, 5, value); break;
-    case DMA1DAD+2:   dma.Write(1, 6, value); break;
-    case DMA1DAD+3:   dma.Write(1, 7, value); break;
-    case DMA1CNT_L:   dma.Write(1, 8, value); break;
-    case DMA1CNT_L+1: dma.Write(1, 9, value); break;
-    case DMA1CNT_H:   dma.Write(1, 10, value); break;
-    case DMA1CNT_H+1: dma.Write(1, 11, value); break;
-    case DMA2SAD:     dma.Write(2, 0, value); break;
-    case DMA2SAD+1:   dma.Write(2, 1, value); break;
-    case DMA2SAD+2:   dma.Write(2, 2, value); break;
-    case DMA2SAD+3:   dma.Write(2, 3, value); break;
-    case DMA2DAD:     dma.Write(2, 4, value); break;
-    case DMA2DAD+1:   dma.Write(2, 5, value); break;
-    case DMA2DAD+2:   dma.Write(2, 6, value); break;
-    case DMA2DAD+3:   dma.Write(2, 7, value); break;
-    case DMA2CNT_L:   dma.Write(2, 8, value); break;
-    case DMA2CNT_L+1: dma.Write(2, 9, value); break;
-    case DMA2CNT_H:   dma.Write(2, 10, value); break;
-    case DMA2CNT_H+1: dma.Write(2, 11, value); break;
-    case DMA3SAD:     dma.Write(3, 0, value); break;
-    case DMA3SAD+1:   dma.Write(3, 1, value); break;
-    case DMA3SAD+2:   dma.Write(3, 2, value); break;
-    case DMA3SAD+3:   dma.Write(3, 3, value); break;
-    case DMA3DAD:     dma.Write(3, 4, value); break;
-    case DMA3DAD+1:   dma.Write(3, 5, value); break;
-    case DMA3DAD+2:   dma.Write(3, 6, value); break;
-    case DMA3DAD+3:   dma.Write(3, 7, value); break;
-    case DMA3CNT_L:   dma.Write(3, 8, value); break;
-    case DMA3CNT_L+1: dma.Write(3, 9, value); break;
-    case DMA3CNT_H:   dma.Write(3, 10, value); break;
-    case DMA3CNT_H+1: dma.Write(3, 11, value); break;
-
-    /* SOUND */
-    case SOUND1CNT_L:   apu_io.psg1.Write(0, value); break;
-    case SOUND1CNT_L+1: apu_io.psg1.Write(1, value); break;
-    case SOUND1CNT_H:   apu_io.psg1.Write(2, value); break;
-    case SOUND1CNT_H+1: apu_io.psg1.Write(3, value); break;
-    case SOUND1CNT_X:   apu_io.psg1.Write(4, value); break;
-    case SOUND1CNT_X+1: apu_io.psg1.Write(5, value); break;
-    case SOUND2CNT_L:   apu_io.psg2.Write(2, value); break;
-    case SOUND2CNT_L+1: apu_io.psg2.Write(3, value); break;
-    case SOUND2CNT_H:   apu_io.psg2.Write(4, value); break;
-    case SOUND2CNT_H+1: apu_io.psg2.Write(5, value); break;
-    case SOUND3CNT_L:   apu_io.psg3.Write(0, value); break;
-    case SOUND3CNT_L+1: apu_io.psg3.Write(1, value); break;
-    case SOUND3CNT_H:   apu_io.psg3.Write(2, value); break;
-    case SOUND3CNT_H+1: apu_io.psg3.Write(3, value); break;
-    case SOUND3CNT_X:   apu_io.psg3.Write(4, value); break;
-    case SOUND3CNT_X+1: apu_io.psg3.Write(5, value); break;
-    case SOUND4CNT_L:   apu_io.psg4.Write(0, value); break;
-    case SOUND4CNT_L+1: apu_io.psg4.Write(1, value); break;
-    case SOUND4CNT_H:   apu_io.psg4.Write(4, value); break;
-    case SOUND4CNT_H+1: apu_io.psg4.Write(5, value); break;
-    case WAVE_RAM+0:
-    case WAVE_RAM+1:
-    case WAVE_RAM+2:
-    case WAVE_RAM+3:
-    case WAVE_RAM+4:
-    case WAVE_RAM+5:
-    case WAVE_RAM+6:
-    case WAVE_RAM+7:
-    case WAVE_RAM+8:
-    case WAVE_RAM+9:
-    case WAVE_RAM+10:
-    case WAVE_RAM+11:
-    case WAVE_RAM+12:
-    case WAVE_RAM+13:
-    case WAVE_RAM+14:
-    case WAVE_RAM+15: {
-      apu_io.psg3.WriteSample(address & 0xF, value);
-      break;
-    }
-    case FIFO_A:
-    case FIFO_A+1:
-    case FIFO_A+2:
-    case FIFO_A+3: apu_io.fifo[0].Write(value); break;
-    case FIFO_B:
-    case FIFO_B+1:
-    case FIFO_B+2:
-    case FIFO_B+3: apu_io.fifo[1].Write(value); break;
-    case SOUNDCNT_L:   apu_io.soundcnt.Write(0, value); break;
-    case SOUNDCNT_L+1: apu_io.soundcnt.Write(1, value); break;
-    case SOUNDCNT_H:   apu_io.soundcnt.Write(2, value); break;
-    case SOUNDCNT_H+1: apu_io.soundcnt.Write(3, value); break;
-    case SOUNDCNT_X:   apu_io.soundcnt.Write(4, value); break;
-    case SOUNDBIAS:    apu_io.bias.Write(0, value); break;
-    case SOUNDBIAS+1:  apu_io.bias.Write(1, value); break;
-
-    /* Timers 0-3 */
-    case TM0CNT_L:   timer.Write(0, 0, value); break;
-    case TM0CNT_L+1: timer.Write(0, 1, value); break;
-    case TM0CNT_H:   timer.Write(0, 2, value); break;
-    case TM1CNT_L:   timer.Write(1, 0, value); break;
-    case TM1CNT_L+1: timer.Write(1, 1, value); break;
-    case TM1CNT_H:   timer.Write(1, 2, value); break;
-    case TM2CNT_L:   timer.Write(2, 0, value); break;
-    case TM2CNT_L+1: timer.Write(2, 1, value); break;
-    case TM2CNT_H:   timer.Write(2, 2, value); break;
-    case TM3CNT_L:   timer.Write(3, 0, value); break;
-    case TM3CNT_L+1: timer.Write(3, 1, value); break;
-    case TM3CNT_H:   timer.Write(3, 2, value); break;
-
-    /* Serial Communication (1, 2) */
-    case SIOMULTI0 | 0:
-    case SIOMULTI0 | 1:
-    case SIOMULTI1 | 0:
-    case SIOMULTI1 | 1:
-    case SIOMULTI2 | 0:
-    case SIOMULTI2 | 1:
-    case SIOMULTI3 | 0:
-    case SIOMULTI3 | 1:
-    case SIOCNT | 0:
-    case SIOCNT | 1:
-    case SIOMLT_SEND | 0:
-    case SIOMLT_SEND | 1:
-    case RCNT | 0:
-    case RCNT | 1:
-    case RCNT | 2:
-    case RCNT | 3:
-    case JOYCNT | 0:
-    case JOYCNT | 1:
-    case JOYCNT | 2:
-    case JOYCNT | 3:
-    case JOY_RECV | 0:
-    case JOY_RECV | 1:
-    case JOY_RECV | 2:
-    case JOY_RECV | 3:
-    case JOY_TRANS | 0:
-    case JOY_TRANS | 1:
-    case JOY_TRANS | 2:
-    case JOY_TRANS | 3:
-    case JOYSTAT | 0:
-    case JOYSTAT | 1:
-    case JOYSTAT | 2:
-    case JOYSTAT | 3: {
-      serial_bus.Write(address, value);
-      break;
-    }
+  /* PPU */
+  map(DISPCNT,
+    [](CPU& cpu, u32) -> u16 { return ReadBytes16(cpu.ppu.mmio.dispcnt, 0); },
+    [](CPU& cpu, u32, u16 value, u16 mask) { WriteBytes16(cpu.ppu.mmio.dispcnt, 0, value, mask); });
+  map(DISPSTAT,
+    [](CPU& cpu, u32) -> u16 { return ReadBytes16(cpu.ppu.mmio.dispstat, 0); },
+    [](CPU& cpu, u32, u16 value, u16 mask) { WriteBytes16(cpu.ppu.mmio.dispstat, 0, value, mask); });
+  map(VCOUNT,
+    [](CPU& cpu, u32) -> u16 { return cpu.ppu.mmio.vcount & 0xFF; },
+    write_ignore);
 
-    case KEYCNT: {
-      mmio.keycnt.input_mask &= 0xFF00;
-      mmio.keycnt.input_mask |= value;
-      CheckKeypadInterrupt();
-      break;
-    }
-    case KEYCNT+1: {
-      mmio.keycnt.input_mask &= 0x00FF;
-      mmio.keycnt.input_mask |= (value & 3) << 8;
-      mmio.keycnt.interrupt = value & 64;
-      mmio.keycnt.and_mode = value & 128;
-      CheckKeypadInterrupt();
-      break;
-    }
+  for (u32 address = BG0CNT; address <= BG3CNT; address += 2) {
+    map(address,
+      [](CPU& cpu, u32 address) -> u16 {
+        return ReadBytes16(cpu.ppu.mmio.bgcnt[(address >> 1) & 3], 0);
+      },
+      [](CPU& cpu, u32 address, u16 value, u16 mask) {
+        WriteBytes16(cpu.ppu.mmio.bgcnt[(address >> 1) & 3], 0, value, mask);
+      });
+  }
+
+  /* BGxHOFS and BGxVOFS are 9-bit and write-only. */
+  for (int id = 0; id < 4; id++) {
+    map(BG0HOFS + id * 4, read_unused, [](CPU& cpu, u32 address, u16 value, u16 mask) {
+      auto& hofs = cpu.ppu.mmio.bghofs[(address >> 2) & 3];
+      hofs = ((hofs & ~mask) | (value & mask)) & 0x1FF;
+    });
+    map(BG0VOFS + id * 4, read_unused, [](CPU& cpu, u32 address, u16 value, u16 mask) {
+      auto& vofs = cpu.ppu.mmio.bgvofs[(address >> 2) & 3];
+      vofs = ((vofs & ~mask) | (value & mask)) & 0x1FF;
+    });
+  }
+
+  for (int id = 0; id < 2; id++) {
+    u32 base = BG2PA + id * 0x10;
+
+    map(base + 0, read_unused, [](CPU& cpu, u32 address, u16 value, u16 mask) {
+      auto& pa = cpu.ppu.mmio.bgpa[(address >> 4) & 1];
+      pa = (pa & ~mask) | (value & mask);
+    });
+    map(base + 2, read_unused, [](CPU& cpu, u32 address, u16 value, u16 mask) {
+      auto& pb = cpu.ppu.mmio.bgpb[(address >> 4) & 1];
+      pb = (pb & ~mask) | (value & mask);
+    });
+    map(base + 4, read_unused, [](CPU& cpu, u32 address, u16 value, u16 mask) {
+      auto& pc = cpu.ppu.mmio.bgpc[(address >> 4) & 1];
+      pc = (pc & ~mask) | (value & mask);
+    });
+    map(base + 6, read_unused, [](CPU& cpu, u32 address, u16 value, u16 mask) {
+      auto& pd = cpu.ppu.mmio.bgpd[(address >> 4) & 1];
+      pd = (pd & ~mask) | (value & mask);
+    });
 
-    /* Interrupt Control */
-    case IE+0: irq.Write(0, value); break;
-    case IE+1: irq.Write(1, value); break;
-    case IF+0: irq.Write(2, value); break;
-    case IF+1: irq.Write(3, value); break;
-    case IME:  irq.Write(4, value); break;
-
-    /* Waitstates */
-    case WAITCNT+0: {
-      mmio.waitcnt.sram  = (value >> 0) & 3;
-      mmio.waitcnt.ws0_n = (value >> 2) & 3;
-      mmio.waitcnt.ws0_s = (value >> 4) & 1;
-      mmio.waitcnt.ws1_n = (value >> 5) & 3;
-      mmio.waitcnt.ws1_s = (value >> 7) & 1;
-      UpdateMemoryDelayTable();
-      break;
+    /* BGxX and BGxY: 28-bit reference points, written as four bytes. */
+    for (u32 address = base + 8; address < base + 16; address += 2) {
+      map(address, read_unused, [](CPU& cpu, u32 address, u16 value, u16 mask) {
+        auto& ppu_io = cpu.ppu.mmio;
+        auto& ref = (address & 4) ? ppu_io.bgy[(address >> 4) & 1] : ppu_io.bgx[(address >> 4) & 1];
+        WriteBytes16(ref, address & 2, value, mask);
+      });
     }
-    case WAITCNT+1: {
-      mmio.waitcnt.ws2_n = (value >> 0) & 3;
-      mmio.waitcnt.ws2_s = (value >> 2) & 1;
-      mmio.waitcnt.phi = (value >> 3) & 3;
-      mmio.waitcnt.prefetch = (value >> 6) & 1;
-      mmio.waitcnt.cgb = (value >> 7) & 1;
-      UpdateMemoryDelayTable();
-      break;
+
+    for (u32 address = base + 8; address < base + 16; address += 4) {
+      mmio_table[(address & 0x3FF) >> 1].write32 = [](CPU& cpu, u32 address, u32 value) {
+        auto& ppu_io = cpu.ppu.mmio;
+        auto& ref = (address & 4) ? ppu_io.bgy[(address >> 4) & 1] : ppu_io.bgx[(address >> 4) & 1];
+        ref.Write(0, u8(value >>  0));
+        ref.Write(1, u8(value >>  8));
+        ref.Write(2, u8(value >> 16));
+        ref.Write(3, u8(value >> 24));
+      };
     }
+  }
+
+  map(WIN0H, read_unused, [](CPU& cpu, u32, u16 value, u16 mask) { WriteBytes16(cpu.ppu.mmio.winh[0], 0, value, mask); });
+  map(WIN1H, read_unused, [](CPU& cpu, u32, u16 value, u16 mask) { WriteBytes16(cpu.ppu.mmio.winh[1], 0, value, mask); });
+  map(WIN0V, read_unused, [](CPU& cpu, u32, u16 value, u16 mask) { WriteBytes16(cpu.ppu.mmio.winv[0], 0, value, mask); });
+  map(WIN1V, read_unused, [](CPU& cpu, u32, u16 value, u16 mask) { WriteBytes16(cpu.ppu.mmio.winv[1], 0, value, mask); });
+  map(WININ,
+    [](CPU& cpu, u32) -> u16 { return ReadBytes16(cpu.ppu.mmio.winin, 0); },
+    [](CPU& cpu, u32, u16 value, u16 mask) { WriteBytes16(cpu.ppu.mmio.winin, 0, value, mask); });
+  map(WINOUT,
+    [](CPU& cpu, u32) -> u16 { return ReadBytes16(cpu.ppu.mmio.winout, 0); },
+    [](CPU& cpu, u32, u16 value, u16 mask) { WriteBytes16(cpu.ppu.mmio.winout, 0, value, mask); });
+  map(MOSAIC, read_unused, [](CPU& cpu, u32, u16 value, u16 mask) { WriteBytes16(cpu.ppu.mmio.mosaic, 0, value, mask); });
+  map(BLDCNT,
+    [](CPU& cpu, u32) -> u16 { return ReadBytes16(cpu.ppu.mmio.bldcnt, 0); },
+    [](CPU& cpu, u32, u16 value, u16 mask) { WriteBytes16(cpu.ppu.mmio.bldcnt, 0, value, mask); });
+  map(BLDALPHA,
+    [](CPU& cpu, u32) -> u16 {
+      return cpu.ppu.mmio.eva | (cpu.ppu.mmio.evb << 8);
+    },
+    [](CPU& cpu, u32, u16 value, u16 mask) {
+      if (mask & 0x00FF) cpu.ppu.mmio.eva = value & 0x1F;
+      if (mask & 0xFF00) cpu.ppu.mmio.evb = (value >> 8) & 0x1F;
+    });
+  map(BLDY, read_unused, [](CPU& cpu, u32, u16 value, u16 mask) {
+    if (mask & 0x00FF) cpu.ppu.mmio.evy = value & 0x1F;
+  });
+
+  /* SOUND */
+  map(SOUND1CNT_L,
+    [](CPU& cpu, u32) -> u16 { return ReadBytes16(cpu.apu.mmio.psg1, 0); },
+    [](CPU& cpu, u32, u16 value, u16 mask) {
+      cpu.apu.RunMixer();
+      WriteBytes16(cpu.apu.mmio.psg1, 0, value, mask);
+    });
+  map(SOUND1CNT_H,
+    [](CPU& cpu, u32) -> u16 { return ReadBytes16(cpu.apu.mmio.psg1, 2); },
+    [](CPU& cpu, u32, u16 value, u16 mask) {
+      cpu.apu.RunMixer();
+      WriteBytes16(cpu.apu.mmio.psg1, 2, value, mask);
+    });
+  map(SOUND1CNT_X,
+    [](CPU& cpu, u32) -> u16 { return ReadBytes16(cpu.apu.mmio.psg1, 4); },
+    [](CPU& cpu, u32, u16 value, u16 mask) {
+      cpu.apu.RunMixer();
+      WriteBytes16(cpu.apu.mmio.psg1, 4, value, mask);
+    });
+  map(SOUND1CNT_X + 2, read_zero, write_ignore);
+  map(SOUND2CNT_L,
+    [](CPU& cpu, u32) -> u16 { return ReadBytes16(cpu.apu.mmio.psg2, 2); },
+    [](CPU& cpu, u32, u16 value, u16 mask) {
+      cpu.apu.RunMixer();
+      WriteBytes16(cpu.apu.mmio.psg2, 2, value, mask);
+    });
+  map(SOUND2CNT_H,
+    [](CPU& cpu, u32) -> u16 { return ReadBytes16(cpu.apu.mmio.psg2, 4); },
+    [](CPU& cpu, u32, u16 value, u16 mask) {
+      cpu.apu.RunMixer();
+      WriteBytes16(cpu.apu.mmio.psg2, 4, value, mask);
+    });
+  map(SOUND2CNT_H + 2, read_zero, write_ignore);
+  map(SOUND3CNT_L,
+    [](CPU& cpu, u32) -> u16 { return ReadBytes16(cpu.apu.mmio.psg3, 0); },
+    [](CPU& cpu, u32, u16 value, u16 mask) {
+      cpu.apu.RunMixer();
+      WriteBytes16(cpu.apu.mmio.psg3, 0, value, mask);
+    });
+  map(SOUND3CNT_H,
+    [](CPU& cpu, u32) -> u16 { return ReadBytes16(cpu.apu.mmio.psg3, 2); },
+    [](CPU& cpu, u32, u16 value, u16 mask) {
+      cpu.apu.RunMixer();
+      WriteBytes16(cpu.apu.mmio.psg3, 2, value, mask);
+    });
+  map(SOUND3CNT_X,
+    [](CPU& cpu, u32) -> u16 { return ReadBytes16(cpu.apu.mmio.psg3, 4); },
+    [](CPU& cpu, u32, u16 value, u16 mask) {
+      cpu.apu.RunMixer();
+      WriteBytes16(cpu.apu.mmio.psg3, 4, value, mask);
+    });
+  map(SOUND3CNT_X + 2, read_zero, write_ignore);
+  map(SOUND4CNT_L,
+    [](CPU& cpu, u32) -> u16 { return ReadBytes16(cpu.apu.mmio.psg4, 0); },
+    [](CPU& cpu, u32, u16 value, u16 mask) {
+      cpu.apu.RunMixer();
+      WriteBytes16(cpu.apu.mmio.psg4, 0, value, mask);
+    });
+  map(SOUND4CNT_L + 2, read_zero, write_ignore);
+  map(SOUND4CNT_H,
+    [](CPU& cpu, u32) -> u16 { return ReadBytes16(cpu.apu.mmio.psg4, 4); },
+    [](CPU& cpu, u32, u16 value, u16 mask) {
+      cpu.apu.RunMixer();
+      WriteBytes16(cpu.apu.mmio.psg4, 4, value, mask);
+    });
+  map(SOUND4CNT_H + 2, read_zero, write_ignore);
+  map(SOUNDCNT_L,
+    [](CPU& cpu, u32) -> u16 { return ReadBytes16(cpu.apu.mmio.soundcnt, 0); },
+    [](CPU& cpu, u32, u16 value, u16 mask) {
+      cpu.apu.RunMixer();
+      WriteBytes16(cpu.apu.mmio.soundcnt, 0, value, mask);
+    });
+  map(SOUNDCNT_H,
+    [](CPU& cpu, u32) -> u16 { return ReadBytes16(cpu.apu.mmio.soundcnt, 2); },
+    [](CPU& cpu, u32, u16 value, u16 mask) {
+      cpu.apu.RunMixer();
+      WriteBytes16(cpu.apu.mmio.soundcnt, 2, value, mask);
+    });
+  map(SOUNDCNT_X,
+    [](CPU& cpu, u32) -> u16 { return cpu.apu.mmio.soundcnt.Read(4); },
+    [](CPU& cpu, u32, u16 value, u16 mask) {
+      cpu.apu.RunMixer();
+      if (mask & 0x00FF) cpu.apu.mmio.soundcnt.Write(4, u8(value));
+    });
+  map(SOUNDCNT_X + 2, read_zero, write_ignore);
+  map(SOUNDBIAS,
+    [](CPU& cpu, u32) -> u16 { return ReadBytes16(cpu.apu.mmio.bias, 0); },
+    [](CPU& cpu, u32, u16 value, u16 mask) {
+      cpu.apu.RunMixer();
+      WriteBytes16(cpu.apu.mmio.bias, 0, value, mask);
+    });
+  map(SOUNDBIAS + 2, read_zero, write_ignore);
+
+  for (u32 address = WAVE_RAM; address < WAVE_RAM + 16; address += 2) {
+    map(address,
+      [](CPU& cpu, u32 address) -> u16 {
+        auto& psg3 = cpu.apu.mmio.psg3;
+        return psg3.ReadSample((address & 0xF) + 0) |
+              (psg3.ReadSample((address & 0xF) + 1) << 8);
+      },
+      [](CPU& cpu, u32 address, u16 value, u16 mask) {
+        auto& psg3 = cpu.apu.mmio.psg3;
+        if (mask & 0x00FF) psg3.WriteSample((address & 0xF) + 0, u8(value));
+        if (mask & 0xFF00) psg3.WriteSample((address & 0xF) + 1, u8(value >> 8));
+      });
+  }
+
+  for (u32 address = FIFO_A; address < FIFO_B + 4; address += 2) {
+    map(address, read_unused, [](CPU& cpu, u32 address, u16 value, u16 mask) {
+      auto& fifo = cpu.apu.mmio.fifo[(address >> 2) & 1];
+      if (mask & 0x00FF) fifo.Write(s8(value));
+      if (mask & 0xFF00) fifo.Write(s8(value >> 8));
+    });
+  }
+
+  for (u32 address = FIFO_A; address <= FIFO_B; address += 4) {
+    mmio_table[(address & 0x3FF) >> 1].write32 = [](CPU& cpu, u32 address, u32 value) {
+      auto& fifo = cpu.apu.mmio.fifo[(address >> 2) & 1];
+      fifo.Write(s8(value >>  0));
+      fifo.Write(s8(value >>  8));
+      fifo.Write(s8(value >> 16));
+      fifo.Write(s8(value >> 24));
+    };
+  }
+
+  /* DMAs 0-3 */
+  for (u32 address = DMA0SAD; address <= DMA3CNT_H; address += 2) {
+    map(address,
+      [](CPU& cpu, u32 address) -> u16 {
+        int offset = (address & 0xFF) - 0xB0;
+        int id = offset / 12;
+
+        offset %= 12;
+
+        // SAD and DAD are write-only, CNT_L reads zero.
+        if (offset < 8) {
+          return cpu.ReadUnused(address);
+        }
+        return cpu.dma.Read(id, offset + 0) |
+              (cpu.dma.Read(id, offset + 1) << 8);
+      },
+      [](CPU& cpu, u32 address, u16 value, u16 mask) {
+        int offset = (address & 0xFF) - 0xB0;
+        int id = offset / 12;
+
+        offset %= 12;
+        if (mask & 0x00FF) cpu.dma.Write(id, offset + 0, u8(value));
+        if (mask & 0xFF00) cpu.dma.Write(id, offset + 1, u8(value >> 8));
+      });
+  }
 
-    case HALTCNT: {
-      if (value & 0x80) {
-        mmio.haltcnt = HaltControl::STOP;
-      } else {
-        mmio.haltcnt = HaltControl::HALT;
+  for (u32 address = DMA0SAD; address <= DMA3CNT_L; address += 4) {
+    mmio_table[(address & 0x3FF) >> 1].write32 = [](CPU& cpu, u32 address, u32 value) {
+      int offset = (address & 0xFF) - 0xB0;
+      int id = offset / 12;
+
+      offset %= 12;
+      for (int i = 0; i < 4; i++) {
+        cpu.dma.Write(id, offset + i, u8(value >> (i * 8)));
       }
-      break;
-    }
+    };
+  }
 
-    case POSTFLG: {
-      mmio.postflg = value & 1;
-      break;
-    }
+  /* Timers 0-3 */
+  for (int id = 0; id < 4; id++) {
+    u32 address = TM0CNT_L + id * 4;
+
+    map(address + 0,
+      [](CPU& cpu, u32 address) -> u16 {
+        int id = (address >> 2) & 3;
+        // The counter advances without scheduler events.
+        cpu.idle_loop_unsafe = true;
+        return cpu.timer.Read(id, 0) | (cpu.timer.Read(id, 1) << 8);
+      },
+      [](CPU& cpu, u32 address, u16 value, u16 mask) {
+        int id = (address >> 2) & 3;
+        if (mask & 0x00FF) cpu.timer.Write(id, 0, u8(value));
+        if (mask & 0xFF00) cpu.timer.Write(id, 1, u8(value >> 8));
+      });
+    map(address + 2,
+      [](CPU& cpu, u32 address) -> u16 {
+        return cpu.timer.Read((address >> 2) & 3, 2);
+      },
+      [](CPU& cpu, u32 address, u16 value, u16 mask) {
+        if (mask & 0x00FF) cpu.timer.Write((address >> 2) & 3, 2, u8(value));
+      });
+
+    auto& reg = mmio_table[(address & 0x3FF) >> 1];
+
+    reg.read32 = [](CPU& cpu, u32 address) -> u32 {
+      int id = (address >> 2) & 3;
+      cpu.idle_loop_unsafe = true;
+      return (cpu.timer.Read(id, 0) <<  0) |
+             (cpu.timer.Read(id, 1) <<  8) |
+             (cpu.timer.Read(id, 2) << 16);
+    };
+    reg.write32 = [](CPU& cpu, u32 address, u32 value) {
+      int id = (address >> 2) & 3;
+      cpu.timer.Write(id, 0, u8(value >>  0));
+      cpu.timer.Write(id, 1, u8(value >>  8));
+      cpu.timer.Write(id, 2, u8(value >> 16));
+    };
   }
-}
 
-void CPU::WriteMMIO16(u32 address, u16 value) {
-  switch (address) {
-    /* KEYCNT special-case:
-     * Do not invoke CheckKeypadInterrupt() twice for a single 16-bit write.
-     * See https://github.com/fleroviux/NanoBoyAdvance/issues/152 for details.
-     */
-    case KEYCNT: {
-      mmio.keycnt.input_mask = value & 0x3FF;
-      mmio.keycnt.interrupt = value & 0x4000;
-      mmio.keycnt.and_mode = value & 0x8000;
-      CheckKeypadInterrupt();
-      break;
-    }
-    default: {
-      WriteMMIO(address + 0, (value >> 0) & 0xFF);
-      WriteMMIO(address + 1, (value >> 8) & 0xFF);
-      break;
-    }
+  /* Serial Communication (1, 2) */
+  static constexpr u32 kSerialRegisters[] {
+    SIOMULTI0, SIOMULTI1, SIOMULTI2, SIOMULTI3, SIOCNT, SIOMLT_SEND,
+    RCNT, RCNT + 2, JOYCNT, JOYCNT + 2,
+    JOY_RECV, JOY_RECV + 2, JOY_TRANS, JOY_TRANS + 2, JOYSTAT, JOYSTAT + 2
+  };
+
+  for (auto address : kSerialRegisters) {
+    map(address,
+      [](CPU& cpu, u32 address) -> u16 {
+        return cpu.serial_bus.Read(address + 0) |
+              (cpu.serial_bus.Read(address + 1) << 8);
+      },
+      [](CPU& cpu, u32 address, u16 value, u16 mask) {
+        if (mask & 0x00FF) cpu.serial_bus.Write(address + 0, u8(value));
+        if (mask & 0xFF00) cpu.serial_bus.Write(address + 1, u8(value >> 8));
+      });
   }
+
+  /* Keypad */
+  map(KEYINPUT,
+    [](CPU& cpu, u32) -> u16 { return cpu.mmio.keyinput; },
+    write_ignore);
+  map(KEYCNT,
+    [](CPU& cpu, u32) -> u16 {
+      auto& keycnt = cpu.mmio.keycnt;
+      return (keycnt.input_mask & 0x3FF) |
+             (keycnt.interrupt << 14) |
+             (keycnt.and_mode << 15);
+    },
+    [](CPU& cpu, u32, u16 value, u16 mask) {
+      auto& keycnt = cpu.mmio.keycnt;
+
+      /* Do not invoke CheckKeypadInterrupt() twice for a single 16-bit write.
+       * See https://github.com/fleroviux/NanoBoyAdvance/issues/152 for details.
+       */
+      if (mask & 0x00FF) {
+        keycnt.input_mask = (keycnt.input_mask & 0xFF00) | (value & 0xFF);
+        if (mask == 0x00FF) cpu.CheckKeypadInterrupt();
+      }
+      if (mask & 0xFF00) {
+        keycnt.input_mask = (keycnt.input_mask & 0x00FF) | (value & 0x300);
+        keycnt.interrupt = value & 0x4000;
+        keycnt.and_mode = value & 0x8000;
+        cpu.CheckKeypadInterrupt();
+      }
+    });
+
+  /* Interrupt Control */
+  map(IE,
+    [](CPU& cpu, u32) -> u16 { return ReadBytes16(cpu.irq, 0); },
+    [](CPU& cpu, u32, u16 value, u16 mask) { WriteBytes16(cpu.irq, 0, value, mask); });
+  map(IF,
+    [](CPU& cpu, u32) -> u16 { return ReadBytes16(cpu.irq, 2); },
+    [](CPU& cpu, u32, u16 value, u16 mask) { WriteBytes16(cpu.irq, 2, value, mask); });
+  map(IME,
+    [](CPU& cpu, u32) -> u16 { return cpu.irq.Read(4); },
+    [](CPU& cpu, u32, u16 value, u16 mask) {
+      if (mask & 0x00FF) cpu.irq.Write(4, u8(value));
+    });
+  map(IME + 2, read_zero, write_ignore);
+
+  /* Waitstates */
+  map(WAITCNT,
+    [](CPU& cpu, u32) -> u16 {
+      auto& waitcnt = cpu.mmio.waitcnt;
+      return (waitcnt.sram <<  0) |
+             (waitcnt.ws0_n <<  2) |
+             (waitcnt.ws0_s <<  4) |
+             (waitcnt.ws1_n <<  5) |
+             (waitcnt.ws1_s <<  7) |
+             (waitcnt.ws2_n <<  8) |
+             (waitcnt.ws2_s << 10) |
+             (waitcnt.phi << 11) |
+             (waitcnt.prefetch << 14);
+    },
+    [](CPU& cpu, u32, u16 value, u16 mask) {
+      auto& waitcnt = cpu.mmio.waitcnt;
+      if (mask & 0x00FF) {
+        waitcnt.sram  = (value >> 0) & 3;
+        waitcnt.ws0_n = (value >> 2) & 3;
+        waitcnt.ws0_s = (value >> 4) & 1;
+        waitcnt.ws1_n = (value >> 5) & 3;
+        waitcnt.ws1_s = (value >> 7) & 1;
+      }
+      if (mask & 0xFF00) {
+        waitcnt.ws2_n = (value >>  8) & 3;
+        waitcnt.ws2_s = (value >> 10) & 1;
+        waitcnt.phi = (value >> 11) & 3;
+        waitcnt.prefetch = (value >> 14) & 1;
+        waitcnt.cgb = (value >> 15) & 1;
+      }
+      cpu.UpdateMemoryDelayTable();
+    });
+  map(WAITCNT + 2, read_zero, write_ignore);
+
+  map(POSTFLG,
+    [](CPU& cpu, u32 address) -> u16 {
+      // HALTCNT is write-only.
+      return cpu.mmio.postflg | (cpu.ReadUnused(address) & 0xFF00);
+    },
+    [](CPU& cpu, u32, u16 value, u16 mask) {
+      if (mask & 0x00FF) {
+        cpu.mmio.postflg = value & 1;
+      }
+      if (mask & 0xFF00) {
+        if (value & 0x8000) {
+          cpu.mmio.haltcnt = HaltControl::STOP;
+        } else {
+          cpu.mmio.haltcnt = HaltControl::HALT;
+        }
+        cpu.BreakBlock();
+      }
+    });
 }
 
 } // namespace nba::core
@@ -8,6 +8,7 @@
 #include "cpu.hpp"
 
 #include <common/compiler.hpp>
+#include <algorithm>
 #include <cstring>
 
 namespace nba::core {
@@ -22,13 +23,14 @@ using Key = InputDevice::Key;
 CPU::CPU(std::shared_ptr<Config> config)
     : ARM7TDMI::ARM7TDMI(scheduler, this)
     , config(config)
-    , irq(*this, scheduler)
+    , irq(IRQLine(), scheduler)
     , dma(*this, irq, scheduler)
     , apu(scheduler, dma, config)
     , ppu(scheduler, irq, dma, config)
     , timer(scheduler, irq, apu)
     , serial_bus(irq) {
   std::memset(memory.bios, 0, 0x04000);
+  SetupMMIOTable();
   Reset();
 }
 
@@ -58,7 +60,16 @@ void CPU::Reset() {
   serial_bus.Reset();
   ARM7TDMI::Reset();
 
-  if (config->skip_bios) {
+  if (!SetJITEnable(config->cpu.backend == Config::CPU::Backend::JIT)) {
+    LOG_WARN("JIT is not available on this host, using the cached interpreter.");
+  }
+
+  SetIdleLoopDetection(config->cpu.idle_loop_skip && !idle_loop_skip_blacklisted);
+  SetSWIHook(config->hle_bios);
+  swi_intr_wait_retry = false;
+
+  // Without a BIOS image there is no boot code to run.
+  if (config->skip_bios || memory.bios_stub) {
     SwitchMode(arm::MODE_SYS);
     state.bank[arm::BANK_SVC][arm::BANK_R13] = 0x03007FE0;
     state.bank[arm::BANK_IRQ][arm::BANK_R13] = 0x03007FA0;
@@ -83,6 +94,10 @@ void CPU::RunFor(int cycles) {
 
   auto limit = scheduler.GetTimestampNow() + cycles;
 
+  // The M4A hook must observe every instruction boundary, which the
+  // cached interpreter does not provide.
+  bool cached = config->cpu.backend != Config::CPU::Backend::Interpreter && !m4a_xq_enable;
+
   while (scheduler.GetTimestampNow() < limit) {
     if (unlikely(mmio.haltcnt == HaltControl::HALT && irq.HasServableIRQ())) {
       mmio.haltcnt = HaltControl::RUN;
@@ -92,13 +107,33 @@ void CPU::RunFor(int cycles) {
       if (unlikely(m4a_xq_enable && state.r15 == m4a_setfreq_address)) {
         M4ASampleFreqSetHook();
       }
-      Run();
+      if (cached) {
+        idle_loop_unsafe = false;
+
+        /* An idle loop cannot make progress until the next event,
+         * so like in HALT mode we may skip ahead to it.
+         */
+        if (RunBlock(limit) && !idle_loop_unsafe && !dma.IsRunning()) {
+          SkipToNextEvent(limit);
+        }
+      } else {
+        Run();
+      }
     } else {
-      Tick(scheduler.GetRemainingCycleCount());
+      SkipToNextEvent(limit);
     }
   }
 }
 
+/* Skips ahead to the next event, but not past the end of the time slice,
+ * so that RunFor() returns on time even when there are few events.
+ */
+void CPU::SkipToNextEvent(u64 limit) {
+  auto cycles = std::min<u64>(scheduler.GetRemainingCycleCount(), limit - scheduler.GetTimestampNow());
+
+  Tick(int(cycles));
+}
+
 void CPU::UpdateMemoryDelayTable() {
   auto cycles16_n = cycles16[int(Access::Nonsequential)];
   auto cycles16_s = cycles16[int(Access::Sequential)];
@@ -133,6 +168,43 @@ void CPU::UpdateMemoryDelayTable() {
     cycles32_s[0xA + i] = cycles16_s[0xA] * 2;
     cycles32_s[0xC + i] = cycles16_s[0xC] * 2;
   }
+
+  UpdatePageTable();
+}
+
+void CPU::UpdatePageTable() {
+  for (u32 i = 0; i < page_table.size(); i++) {
+    u32 address = i << kPageShift;
+    int region = address >> 24;
+    auto& page = page_table[i];
+
+    page = {};
+
+    switch (region) {
+      case 0x02: {
+        page.read = memory.wram + (address & 0x3FFFF);
+        page.write = page.read;
+        page.canonical = 0x02000000 | (address & 0x3FFFF);
+        break;
+      }
+      case 0x03: {
+        page.read = memory.iram;
+        page.write = page.read;
+        page.canonical = 0x03000000;
+        break;
+      }
+      case 0x08 ... 0x0D: {
+        page.read = game_pak.GetROMPointer(address, 1 << kPageShift);
+        page.rom = true;
+        break;
+      }
+    }
+
+    for (int access = 0; access < 2; access++) {
+      page.cycles[0][access] = cycles16[access][region];
+      page.cycles[1][access] = cycles32[access][region];
+    }
+  }
 }
 
 void CPU::M4ASearchForSampleFreqSet() {
@@ -13,9 +13,11 @@
 #include <emulator/cartridge/backup/backup.hpp>
 #include <emulator/cartridge/gpio/gpio.hpp>
 #include <emulator/cartridge/game_pak.hpp>
+#include <array>
 #include <emulator/config/config.hpp>
 #include <memory>
 #include <type_traits>
+#include <vector>
 
 #include "arm/arm7tdmi.hpp"
 #include "hw/apu/apu.hpp"
@@ -28,7 +30,7 @@
 
 namespace nba::core {
 
-struct CPU final : private arm::ARM7TDMI, private arm::MemoryBase {
+struct CPU final : private arm::ARM7TDMI<CPU> {
   using Access = arm::MemoryBase::Access;
 
   CPU(std::shared_ptr<Config> config);
@@ -36,6 +38,10 @@ struct CPU final : private arm::ARM7TDMI, private arm::MemoryBase {
   void Reset();
   void RunFor(int cycles);
 
+  /// Installs a minimal BIOS with exception vectors and an IRQ handler,
+  /// for use with the high-level emulated SWIs when no BIOS image is available.
+  void LoadBIOSStub();
+
   enum class HaltControl {
     RUN,
     STOP,
@@ -49,10 +55,14 @@ struct CPU final : private arm::ARM7TDMI, private arm::MemoryBase {
     u8 wram[0x40000];
     u8 iram[0x08000];
     u32 bios_latch = 0;
+    bool bios_stub = false;
   } memory;
 
   GamePak game_pak;
 
+  /* Set for games which do not work with idle loop skipping. */
+  bool idle_loop_skip_blacklisted = false;
+
   struct MMIO {
     u16 keyinput = 0x3FF;
     u16 rcnt_hack = 0;
@@ -88,11 +98,35 @@ struct CPU final : private arm::ARM7TDMI, private arm::MemoryBase {
   SerialBus serial_bus;
 
 private:
-  auto ReadMMIO(u32 address) -> u8;
-  void WriteMMIO(u32 address, u8 value);
-  void WriteMMIO16(u32 address, u16 value);
+  friend struct arm::ARM7TDMI<CPU>;
+  friend struct DMA;
+
+  template<typename T>
+  auto ReadMMIO(u32 address) -> T;
+
+  template<typename T>
+  void WriteMMIO(u32 address, T value);
+
+  void SetupMMIOTable();
+
+  bool HandleSWI(int number);
+  void SWIRegisterRamReset(u32 flags);
+  bool SWIIntrWait(bool discard_old_flags, u16 flags);
+  void SWIDiv(s32 numerator, s32 denominator);
+  static auto SWIArcTan(s32 tan) -> u16;
+  static auto SWIArcTan2(s32 x, s32 y) -> u16;
+  void SWICpuSet(u32 src, u32 dst, u32 control);
+  void SWICpuFastSet(u32 src, u32 dst, u32 control);
+  void SWIBgAffineSet(u32 src, u32 dst, int count);
+  void SWIObjAffineSet(u32 src, u32 dst, int count, int stride);
+  void SWIDecompress(u32 src, u32 dst, bool vram, void (CPU::*decode)(u32, size_t, std::vector<u8>&));
+  void SWIDecodeLZ77(u32 src, size_t size, std::vector<u8>& output);
+  void SWIDecodeRL(u32 src, size_t size, std::vector<u8>& output);
+  void SWIHuffUnComp(u32 src, u32 dst);
+
   auto ReadBIOS(u32 address) -> u32;
   auto ReadUnused(u32 address) -> u32;
+  auto GetCodePointer(u32 address) -> u8 const*;
 
   template<typename T>
   auto Read(u32 address, Access access) -> T;
@@ -100,27 +134,27 @@ private:
   template<typename T>
   void Write(u32 address, T value, Access access);
 
-  auto ReadByte(u32 address, Access access) -> u8  final {
+  auto ReadByte(u32 address, Access access) -> u8 {
     return Read<u8>(address, access);
   }
 
-  auto ReadHalf(u32 address, Access access) -> u16 final {
+  auto ReadHalf(u32 address, Access access) -> u16 {
     return Read<u16>(address, access);
   }
 
-  auto ReadWord(u32 address, Access access) -> u32 final {
+  auto ReadWord(u32 address, Access access) -> u32 {
     return Read<u32>(address, access);
   }
 
-  void WriteByte(u32 address, u8  value, Access access) final {
+  void WriteByte(u32 address, u8  value, Access access) {
     Write<u8>(address, value, access);
   }
 
-  void WriteHalf(u32 address, u16 value, Access access) final {
+  void WriteHalf(u32 address, u16 value, Access access) {
     Write<u16>(address, value, access);
   }
 
-  void WriteWord(u32 address, u32 value, Access access) final {
+  void WriteWord(u32 address, u32 value, Access access) {
     Write<u32>(address, value, access);
   }
 
@@ -128,6 +162,10 @@ private:
     PrefetchStepRAM(1);
   }
 
+  void UpdatePageTable();
+
+  void SkipToNextEvent(u64 limit);
+
   void ALWAYS_INLINE Tick(int cycles) noexcept {
     openbus_from_dma = false;
     
@@ -254,6 +292,12 @@ private:
   bool bus_is_controlled_by_dma;
   bool openbus_from_dma;
 
+  /* Set while a high-level emulated IntrWait waits for an IRQ. */
+  bool swi_intr_wait_retry = false;
+
+  /* Set by reads whose result may change without a scheduler event. */
+  bool idle_loop_unsafe = false;
+
   int cycles16[2][256] {
     { 1, 1, 3, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 1 },
     { 1, 1, 3, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 1 },
@@ -264,6 +308,37 @@ private:
     { 1, 1, 6, 1, 1, 2, 2, 1, 0, 0, 0, 0, 0, 0, 0, 1 }
   };
 
+  static constexpr int kPageShift = 15;
+  static constexpr u32 kPageMask = (1 << kPageShift) - 1;
+
+  /** Host mapping of a 32 KiB page of the address space below 0x10000000.
+    * Pages which are not plain memory (BIOS, MMIO, PRAM/VRAM/OAM, SRAM,
+    * GPIO, EEPROM and open bus) have null pointers and use the slow path.
+    */
+  struct Page {
+    u8* read = nullptr;
+    u8* write = nullptr;
+    u32 canonical = 0;
+    bool rom = false;
+    u8 cycles[2][2] {}; /* [16-bit, 32-bit][N, S] */
+  };
+
+  std::array<Page, (0x10000000 >> kPageShift)> page_table;
+
+  /** Handlers of a 16-bit I/O register. Writes receive a mask of the bytes
+    * which are written, so that 8-bit and 16-bit accesses share one handler.
+    * 32-bit accesses are split into two 16-bit accesses, unless the register
+    * at the lower address provides native 32-bit handlers.
+    */
+  struct MMIORegister {
+    u16  (*read)(CPU& cpu, u32 address);
+    void (*write)(CPU& cpu, u32 address, u16 value, u16 mask);
+    u32  (*read32)(CPU& cpu, u32 address);
+    void (*write32)(CPU& cpu, u32 address, u32 value);
+  };
+
+  std::array<MMIORegister, 0x400 / sizeof(u16)> mmio_table;
+
   static constexpr int s_ws_nseq[4] = { 4, 3, 2, 8 }; /* Non-sequential SRAM/WS0/WS1/WS2 */
   static constexpr int s_ws_seq0[2] = { 2, 1 };       /* Sequential WS0 */
   static constexpr int s_ws_seq1[2] = { 4, 1 };       /* Sequential WS1 */
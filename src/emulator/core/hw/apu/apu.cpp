@@ -5,6 +5,7 @@
  * Refer to the included LICENSE file.
  */
 
+#include <algorithm>
 #include <cmath>
 #include <common/dsp/resampler/blep.hpp>
 #include <common/dsp/resampler/cosine.hpp>
@@ -17,7 +18,7 @@
 namespace nba::core {
 
 // See callback.cpp for implementation
-void AudioCallback(APU* apu, s16* stream, int byte_len);
+void AudioCallback(APU* apu, void* stream, int byte_len);
 
 APU::APU(
   Scheduler& scheduler,
@@ -27,6 +28,12 @@ APU::APU(
     , scheduler(scheduler)
     , dma(dma)
     , config(config) {
+  scheduler.Register<&APU::StepMixer>(EventClass::APU_mixer, this);
+  scheduler.Register<&APU::StepSequencer>(EventClass::APU_sequencer, this);
+  scheduler.Register<&APU::StepPSG1>(EventClass::APU_PSG1_generate, this);
+  scheduler.Register<&APU::StepPSG2>(EventClass::APU_PSG2_generate, this);
+  scheduler.Register<&APU::StepPSG3>(EventClass::APU_PSG3_generate, this);
+  scheduler.Register<&APU::StepPSG4>(EventClass::APU_PSG4_generate, this);
 }
 
 void APU::Reset() {
@@ -42,16 +49,20 @@ void APU::Reset() {
   mmio.bias.Reset();
 
   resolution_old = 0;
-  scheduler.Add(mmio.bias.GetSampleInterval(), this, &APU::StepMixer);
-  scheduler.Add(BaseChannel::s_cycles_per_step, this, &APU::StepSequencer);
+  rate_adjust = 1;
+  mixer_timestamp = scheduler.GetTimestampNow() + mmio.bias.GetSampleInterval();
+  scheduler.Add(mmio.bias.GetSampleInterval() * kMixerBatchSize, EventClass::APU_mixer);
+  scheduler.Add(BaseChannel::s_cycles_per_step, EventClass::APU_sequencer);
 
   auto audio_dev = config->audio_dev;
   audio_dev->Close();
+  output_format = audio_dev->GetSampleFormat();
   audio_dev->Open(this, (AudioDevice::Callback)AudioCallback);
 
   using Interpolation = Config::Audio::Interpolation;
 
-  buffer = std::make_shared<common::dsp::StereoRingBuffer<float>>(audio_dev->GetBlockSize() * 4, true);
+  // The audio callback may already be running, so publish the new buffer atomically.
+  std::atomic_store(&buffer, std::make_shared<StereoSPSCRingBuffer<float>>(audio_dev->GetBlockSize() * 4));
 
   switch (config->audio.interpolation) {
     case Interpolation::Cosine:
@@ -66,11 +77,12 @@ void APU::Reset() {
     case Interpolation::Sinc_64:
       resampler = std::make_unique<SincStereoResampler<float, 64>>(buffer);
       break;
+    // The long kernels use a coarser phase table to keep it in cache.
     case Interpolation::Sinc_128:
-      resampler = std::make_unique<SincStereoResampler<float, 128>>(buffer);
+      resampler = std::make_unique<SincStereoResampler<float, 128, 256>>(buffer);
       break;
     case Interpolation::Sinc_256:
-      resampler = std::make_unique<SincStereoResampler<float, 256>>(buffer);
+      resampler = std::make_unique<SincStereoResampler<float, 256, 256>>(buffer);
       break;
   }
 
@@ -83,7 +95,7 @@ void APU::Reset() {
     }
   }
 
-  resampler->SetSampleRates(mmio.bias.GetSampleRate(), audio_dev->GetSampleRate());
+  resampler->SetSampleRates(mmio.bias.GetSampleRate(), audio_dev->GetSampleRate() * rate_adjust);
 }
 
 void APU::OnTimerOverflow(int timer_id, int times, int samplerate) {
@@ -95,6 +107,8 @@ void APU::OnTimerOverflow(int timer_id, int times, int samplerate) {
 
   constexpr DMA::Occasion occasion[2] = { DMA::Occasion::FIFO0, DMA::Occasion::FIFO1 };
 
+  RunMixer();
+
   for (int fifo_id = 0; fifo_id < 2; fifo_id++) {
     if (soundcnt.dma[fifo_id].timer_id == timer_id) {
       auto& fifo = mmio.fifo[fifo_id];
@@ -117,12 +131,17 @@ void APU::OnTimerOverflow(int timer_id, int times, int samplerate) {
   }
 }
 
-void APU::StepMixer(int cycles_late) {
+void APU::RunMixer() {
   auto& bias = mmio.bias;
+  auto now = scheduler.GetTimestampNow();
+
+  if (mixer_timestamp > now) {
+    return;
+  }
 
   if (bias.resolution != resolution_old) {
     resampler->SetSampleRates(bias.GetSampleRate(),
-      config->audio_dev->GetSampleRate());
+      config->audio_dev->GetSampleRate() * rate_adjust);
     resolution_old = mmio.bias.resolution;
     if (config->audio.interpolate_fifo) {
       for (int fifo = 0; fifo < 2; fifo++) {
@@ -131,6 +150,26 @@ void APU::StepMixer(int cycles_late) {
     }
   }
 
+  auto interval = bias.GetSampleInterval();
+
+  if (config->audio.interpolate_fifo) {
+    // The interpolated FIFO samples change with every output sample.
+    while (mixer_timestamp <= now) {
+      resampler->Write(MixSample());
+      mixer_timestamp += interval;
+    }
+  } else {
+    // The inputs did not change since the last call, so all samples are equal.
+    auto sample = MixSample();
+
+    while (mixer_timestamp <= now) {
+      resampler->Write(sample);
+      mixer_timestamp += interval;
+    }
+  }
+}
+
+auto APU::MixSample() -> common::dsp::StereoSample<float> {
   common::dsp::StereoSample<s16> sample { 0, 0 };
 
   constexpr int psg_volume_tab[4] = { 1, 2, 4, 0 };
@@ -168,20 +207,62 @@ void APU::StepMixer(int cycles_late) {
     sample[channel] -= 0x200;
   }
 
-  buffer_mutex.lock();
-  resampler->Write({ sample[0] / float(0x200), sample[1] / float(0x200) });
-  buffer_mutex.unlock();
+  return { sample[0] / float(0x200), sample[1] / float(0x200) };
+}
+
+void APU::UpdateRateControl() {
+  // Maximum deviation from the nominal sample rate, small enough to be inaudible.
+  static constexpr float kMaxRateAdjust = 0.005;
 
-  scheduler.Add(mmio.bias.GetSampleInterval() - cycles_late, this, &APU::StepMixer);
+  if (!config->audio.dynamic_rate_control) {
+    return;
+  }
+
+  // A fuller buffer lowers the output rate, so that fewer samples are produced.
+  float fill = buffer->Available() / float(buffer->Capacity());
+
+  rate_adjust = 1 + kMaxRateAdjust * (1 - 2 * std::clamp(fill, 0.0f, 1.0f));
+
+  resampler->SetSampleRates(mmio.bias.GetSampleRate(),
+    config->audio_dev->GetSampleRate() * rate_adjust);
+}
+
+void APU::StepMixer(int cycles_late) {
+  RunMixer();
+
+  scheduler.Add(mmio.bias.GetSampleInterval() * kMixerBatchSize - cycles_late, EventClass::APU_mixer);
 }
 
 void APU::StepSequencer(int cycles_late) {
+  RunMixer();
+
   mmio.psg1.Tick();
   mmio.psg2.Tick();
   mmio.psg3.Tick();
   mmio.psg4.Tick();
 
-  scheduler.Add(BaseChannel::s_cycles_per_step - cycles_late, this, &APU::StepSequencer);
+  scheduler.Add(BaseChannel::s_cycles_per_step - cycles_late, EventClass::APU_sequencer);
+}
+
+/* The PSG outputs only change when they generate a new sample. */
+void APU::StepPSG1(int cycles_late) {
+  RunMixer();
+  mmio.psg1.Generate(cycles_late);
+}
+
+void APU::StepPSG2(int cycles_late) {
+  RunMixer();
+  mmio.psg2.Generate(cycles_late);
+}
+
+void APU::StepPSG3(int cycles_late) {
+  RunMixer();
+  mmio.psg3.Generate(cycles_late);
+}
+
+void APU::StepPSG4(int cycles_late) {
+  RunMixer();
+  mmio.psg4.Generate(cycles_late);
 }
 
 } // namespace nba::core
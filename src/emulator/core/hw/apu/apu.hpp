@@ -12,7 +12,6 @@
 #include <emulator/config/config.hpp>
 #include <emulator/core/hw/dma.hpp>
 #include <emulator/core/scheduler.hpp>
-#include <mutex>
 
 #include "channel/quad_channel.hpp"
 #include "channel/wave_channel.hpp"
@@ -32,10 +31,19 @@ struct APU {
   void Reset();
   void OnTimerOverflow(int timer_id, int times, int samplerate);
 
+  /// Mixes all output samples up to the current time. Must be called
+  /// before any change to the mixer inputs (PSG samples, FIFO latches,
+  /// SOUNDCNT and SOUNDBIAS) takes effect.
+  void RunMixer();
+
+  /// Nudges the output sample rate so that the audio buffer stays about half full.
+  /// Called once per frame if dynamic rate control is enabled.
+  void UpdateRateControl();
+
   struct MMIO {
     MMIO(Scheduler& scheduler)
-        : psg1(scheduler)
-        , psg2(scheduler)
+        : psg1(scheduler, EventClass::APU_PSG1_generate)
+        , psg2(scheduler, EventClass::APU_PSG2_generate)
         , psg3(scheduler)
         , psg4(scheduler, bias) {
     }
@@ -56,18 +64,36 @@ struct APU {
   std::unique_ptr<common::dsp::Resampler<float>> fifo_resampler[2];
   int fifo_samplerate[2];
 
-  std::mutex buffer_mutex;
-  std::shared_ptr<common::dsp::StereoRingBuffer<float>> buffer;
+  /* Written by the emulation thread and read by the audio callback. */
+  std::shared_ptr<common::dsp::StereoSPSCRingBuffer<float>> buffer;
+  AudioDevice::SampleFormat output_format = AudioDevice::SampleFormat::S16;
   std::unique_ptr<common::dsp::StereoResampler<float>> resampler;
 
 private:
+  /* Output samples are mixed in batches of (at most) this many samples,
+   * or earlier if one of the mixer inputs changes.
+   */
+  static constexpr int kMixerBatchSize = 128;
+
+  auto MixSample() -> common::dsp::StereoSample<float>;
+
   void StepMixer(int cycles_late);
   void StepSequencer(int cycles_late);
+  void StepPSG1(int cycles_late);
+  void StepPSG2(int cycles_late);
+  void StepPSG3(int cycles_late);
+  void StepPSG4(int cycles_late);
 
   Scheduler& scheduler;
   DMA& dma;
   std::shared_ptr<Config> config;
   int resolution_old = 0;
+
+  /* Factor applied to the audio device sample rate by dynamic rate control. */
+  float rate_adjust = 1;
+
+  /* Timestamp of the next output sample which has not been mixed yet. */
+  u64 mixer_timestamp = 0;
 };
 
 } // namespace nba::core
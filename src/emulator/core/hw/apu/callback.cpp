@@ -6,49 +6,62 @@
  */
 
 #include <algorithm>
-#include <cmath>
+#include <common/dsp/convert.hpp>
+#include <cstring>
+#include <memory>
 
 #include "apu.hpp"
 
 namespace nba::core {
 
-void AudioCallback(APU* apu, s16* stream, int byte_len) {
-  std::lock_guard<std::mutex> guard(apu->buffer_mutex);
+using SampleFormat = AudioDevice::SampleFormat;
+using StereoSample = common::dsp::StereoSample<float>;
+
+static void WriteSamples(void* stream, int offset, StereoSample const* samples, int count, SampleFormat format) {
+  if (format == SampleFormat::F32) {
+    std::memcpy((float*)stream + offset * 2, samples, count * sizeof(StereoSample));
+  } else {
+    common::dsp::ConvertFloatToS16((float const*)samples, (s16*)stream + offset * 2, count * 2);
+  }
+}
+
+void AudioCallback(APU* apu, void* stream, int byte_len) {
+  // The buffer itself is lock-free, only its replacement in APU::Reset() is synchronized.
+  auto buffer = std::atomic_load(&apu->buffer);
 
   // Do not try to access the buffer if it wasn't setup yet.
-  if (!apu->buffer) {
+  if (!buffer) {
     return;
   }
 
-  int samples = byte_len/sizeof(s16)/2;
-  int available = apu->buffer->Available();
-
-  static constexpr float kMaxAmplitude = 0.999;
+  auto format = apu->output_format;
+  int samples = byte_len / (format == SampleFormat::F32 ? sizeof(float) : sizeof(s16)) / 2;
+  int available = buffer->Available();
 
   if (available >= samples) {
-    for (int x = 0; x < samples; x++) {
-      auto sample = apu->buffer->Read();
-      sample[0] = std::clamp(sample[0], -kMaxAmplitude, kMaxAmplitude);
-      sample[1] = std::clamp(sample[1], -kMaxAmplitude, kMaxAmplitude);
-      sample *= 32767.0;
-
-      stream[x*2+0] = s16(std::round(sample.left));
-      stream[x*2+1] = s16(std::round(sample.right));
-    }
-  } else {
-    int y = 0;
+    int offset = 0;
 
-    for (int x = 0; x < samples; x++) {
-      auto sample = apu->buffer->Peek(y);
-      sample[0] = std::clamp(sample[0], -kMaxAmplitude, kMaxAmplitude);
-      sample[1] = std::clamp(sample[1], -kMaxAmplitude, kMaxAmplitude);
-      sample *= 32767.0;
+    for (auto& span : buffer->PeekSpans(samples)) {
+      WriteSamples(stream, offset, span.data, span.length, format);
+      offset += span.length;
+    }
 
-      if (++y >= available) y = 0;
+    buffer->Skip(samples);
+  } else if (available > 0) {
+    // Not enough samples: loop over the available ones without consuming them.
+    auto spans = buffer->PeekSpans(available);
+    int offset = 0;
 
-      stream[x*2+0] = s16(std::round(sample.left));
-      stream[x*2+1] = s16(std::round(sample.right));
+    while (offset < samples) {
+      for (auto& span : spans) {
+        int count = std::min(span.length, samples - offset);
+        WriteSamples(stream, offset, span.data, count, format);
+        offset += count;
+      }
     }
+  } else {
+    // Both sample formats encode silence as zero.
+    std::memset(stream, 0, byte_len);
   }
 }
 
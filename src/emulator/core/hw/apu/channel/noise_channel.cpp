@@ -76,7 +76,7 @@ void NoiseChannel::Generate(int cycles_late) {
     skip_count = 0;
   }
 
-  scheduler.Add(noise_interval - cycles_late, event_cb);
+  scheduler.Add(noise_interval - cycles_late, EventClass::APU_PSG4_generate);
 }
 
 auto NoiseChannel::Read(int offset) -> u8 {
@@ -154,7 +154,7 @@ void NoiseChannel::Write(int offset, u8 value) {
         if (!IsEnabled()) {
           // TODO: properly handle skip count and properly align event to system clock.
           skip_count = 0;
-          scheduler.Add(GetSynthesisInterval(frequency_ratio, frequency_shift), event_cb);
+          scheduler.Add(GetSynthesisInterval(frequency_ratio, frequency_shift), EventClass::APU_PSG4_generate);
         }
 
         constexpr u16 lfsr_init[] = { 0x4000, 0x0040 };
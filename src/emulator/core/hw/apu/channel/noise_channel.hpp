@@ -42,10 +42,6 @@ private:
   s8 sample = 0;
 
   Scheduler& scheduler;
-  std::function<void(int)> event_cb = [this](int cycles_late) {
-    this->Generate(cycles_late);
-  };
-
   int frequency_shift;
   int frequency_ratio;
   int width;
@@ -9,9 +9,10 @@
 
 namespace nba::core {
 
-QuadChannel::QuadChannel(Scheduler& scheduler)
+QuadChannel::QuadChannel(Scheduler& scheduler, EventClass event_class)
     : BaseChannel(true, true)
-    , scheduler(scheduler) {
+    , scheduler(scheduler)
+    , event_class(event_class) {
   Reset();
 }
 
@@ -43,7 +44,7 @@ void QuadChannel::Generate(int cycles_late) {
   }
   phase = (phase + 1) % 8;
 
-  scheduler.Add(GetSynthesisIntervalFromFrequency(sweep.current_freq) - cycles_late, event_cb);
+  scheduler.Add(GetSynthesisIntervalFromFrequency(sweep.current_freq) - cycles_late, event_class);
 }
 
 auto QuadChannel::Read(int offset) -> u8 {
@@ -135,7 +136,7 @@ void QuadChannel::Write(int offset, u8 value) {
       if (dac_enable && (value & 0x80)) {
         if (!IsEnabled()) {
           // TODO: properly align event to system clock.
-          scheduler.Add(GetSynthesisIntervalFromFrequency(sweep.current_freq), event_cb);
+          scheduler.Add(GetSynthesisIntervalFromFrequency(sweep.current_freq), event_class);
         }
         phase = 0;
         Restart();
@@ -16,7 +16,7 @@ namespace nba::core {
 
 class QuadChannel : public BaseChannel {
 public:
-  QuadChannel(Scheduler& scheduler);
+  QuadChannel(Scheduler& scheduler, EventClass event_class);
 
   void Reset();
   auto GetSample() -> s8 override { return sample; }
@@ -33,9 +33,7 @@ private:
   }
 
   Scheduler& scheduler;
-  std::function<void(int)> event_cb = [this](int cycles_late) {
-    this->Generate(cycles_late);
-  };
+  EventClass event_class;
 
   s8 sample = 0;
   int phase;
@@ -39,7 +39,7 @@ void WaveChannel::Generate(int cycles_late) {
   if (!IsEnabled()) {
     sample = 0;
     if (BaseChannel::IsEnabled()) {
-      scheduler.Add(GetSynthesisIntervalFromFrequency(frequency) - cycles_late, event_cb);
+      scheduler.Add(GetSynthesisIntervalFromFrequency(frequency) - cycles_late, EventClass::APU_PSG3_generate);
     }
     return;
   }
@@ -63,7 +63,7 @@ void WaveChannel::Generate(int cycles_late) {
     }
   }
 
-  scheduler.Add(GetSynthesisIntervalFromFrequency(frequency) - cycles_late, event_cb);
+  scheduler.Add(GetSynthesisIntervalFromFrequency(frequency) - cycles_late, EventClass::APU_PSG3_generate);
 }
 
 auto WaveChannel::Read(int offset) -> u8 {
@@ -127,7 +127,7 @@ void WaveChannel::Write(int offset, u8 value) {
       if (playing && (value & 0x80)) {
         if (!BaseChannel::IsEnabled()) {
           // TODO: properly align event to system clock.
-          scheduler.Add(GetSynthesisIntervalFromFrequency(frequency), event_cb);
+          scheduler.Add(GetSynthesisIntervalFromFrequency(frequency), EventClass::APU_PSG3_generate);
         }
         phase = 0;
         if (dimension) {
@@ -40,10 +40,6 @@ private:
   }
 
   Scheduler& scheduler;
-  std::function<void(int)> event_cb = [this](int cycles_late) {
-    this->Generate(cycles_late);
-  };
-
   s8 sample = 0;
   bool playing;
   bool force_volume;
@@ -6,6 +6,7 @@
  */
 
 #include <common/compiler.hpp>
+#include <emulator/core/cpu.hpp>
 #include <emulator/core/cpu-mmio.hpp>
 
 #include "dma.hpp"
@@ -74,17 +75,21 @@ void DMA::ScheduleDMAs(unsigned int bitset) {
   while (bitset > 0) {
     auto chan_id = g_dma_from_bitset[bitset];
     bitset &= ~(1 << chan_id);
-    channels[chan_id].startup_event = scheduler.Add(2, [this, chan_id](int cycles_late) {
-      channels[chan_id].startup_event = nullptr;
-      if (runnable_set.none()) {
-        active_dma_id = chan_id;
-      } else if (chan_id < active_dma_id) {
-        active_dma_id = chan_id;
-        early_exit_trigger = true;
-      }
-      runnable_set.set(chan_id, true);
-    });
+    channels[chan_id].startup_event = scheduler.Add(2, EventClass::DMA_activated, chan_id);
+  }
+}
+
+void DMA::OnActivated(int cycles_late, u64 user_data) {
+  int chan_id = int(user_data);
+
+  channels[chan_id].startup_event = nullptr;
+  if (runnable_set.none()) {
+    active_dma_id = chan_id;
+  } else if (chan_id < active_dma_id) {
+    active_dma_id = chan_id;
+    early_exit_trigger = true;
   }
+  runnable_set.set(chan_id, true);
 }
 
 void DMA::SelectNextDMA() {
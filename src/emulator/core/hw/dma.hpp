@@ -15,13 +15,16 @@
 
 namespace nba::core {
 
+struct CPU;
+
 struct DMA {
   using Access = arm::MemoryBase::Access;
 
-  DMA(arm::MemoryBase& memory, IRQ& irq, Scheduler& scheduler)
+  DMA(CPU& memory, IRQ& irq, Scheduler& scheduler)
       : memory(memory)
       , irq(irq)
       , scheduler(scheduler) {
+    scheduler.Register<&DMA::OnActivated>(EventClass::DMA_activated, this);
     Reset();
   }
 
@@ -106,11 +109,12 @@ private:
   }
 
   void ScheduleDMAs(unsigned int bitset);
+  void OnActivated(int cycles_late, u64 user_data);
   void SelectNextDMA();
   void OnChannelWritten(Channel& channel, bool enable_old);
   void RunChannel(bool first);
 
-  arm::MemoryBase& memory;
+  CPU& memory;
   IRQ& irq;
   Scheduler& scheduler;
 
@@ -77,16 +77,13 @@ void IRQ::Raise(IRQ::Source source, int channel) {
 }
 
 void IRQ::UpdateIRQLine() {
-  bool irq_line = MasterEnable() && HasServableIRQ();
+  bool irq_line_new = MasterEnable() && HasServableIRQ();
 
-  if (irq_line != cpu.IRQLine()) {
+  if (irq_line_new != irq_line) {
     if (event != nullptr) {
       scheduler.Cancel(event);
     }
-    event = scheduler.Add(1, [=](int late) {
-      cpu.IRQLine() = irq_line;
-      event = nullptr;
-    });
+    event = scheduler.Add(1, EventClass::IRQ_update_line, irq_line_new);
   }
 }
 
@@ -8,7 +8,6 @@
 #pragma once
 
 #include <common/integer.hpp>
-#include <emulator/core/arm/arm7tdmi.hpp>
 #include <emulator/core/scheduler.hpp>
 
 namespace nba::core {
@@ -25,9 +24,10 @@ struct IRQ {
     GamePak
   };
 
-  IRQ(arm::ARM7TDMI& cpu, Scheduler& scheduler)
-      : cpu(cpu)
+  IRQ(bool& irq_line, Scheduler& scheduler)
+      : irq_line(irq_line)
       , scheduler(scheduler) {
+    scheduler.Register<&IRQ::OnUpdateIRQLine>(EventClass::IRQ_update_line, this);
     Reset();
   }
 
@@ -36,7 +36,7 @@ struct IRQ {
     reg_ie = 0;
     reg_if = 0;
     event = nullptr;
-    cpu.IRQLine() = false;
+    irq_line = false;
   }
 
   auto Read(int offset) const -> u8;
@@ -60,10 +60,15 @@ private:
 
   void UpdateIRQLine();
 
+  void OnUpdateIRQLine(int cycles_late, u64 irq_line_new) {
+    irq_line = irq_line_new;
+    event = nullptr;
+  }
+
   int reg_ime;
   u16 reg_ie;
   u16 reg_if;
-  arm::ARM7TDMI& cpu;
+  bool& irq_line;
   Scheduler& scheduler;
   Scheduler::Event* event = nullptr;
 };
@@ -6,6 +6,7 @@
  */
 
 #include <algorithm>
+#include <utility>
 
 #include "ppu.hpp"
 
@@ -13,11 +14,15 @@ namespace nba::core {
 
 using BlendMode = BlendControl::Effect;
 
-auto PPU::ConvertColor(u16 color) -> u32 {
+auto PPU::ConvertColor(u16 color, Config::Video::Format format) -> u32 {
   int r = (color >>  0) & 0x1F;
   int g = (color >>  5) & 0x1F;
   int b = (color >> 10) & 0x1F;
 
+  if (format == Config::Video::Format::ABGR8888) {
+    std::swap(r, b);
+  }
+
   return r << 19 |
          g << 11 |
          b <<  3 |
@@ -30,7 +35,7 @@ void PPU::RenderScanline() {
 
   if (mmio.dispcnt.forced_blank) {
     for (int x = 0; x < 240; x++) {
-      line[x] = ConvertColor(0x7FFF);
+      line[x] = color_lut[0x7FFF];
     }
     return;
   }
@@ -97,7 +102,7 @@ void PPU::RenderScanline() {
     case 6:
     case 7: {
       // TODO: do OBJs still work in this mode?
-      u32 backdrop = ConvertColor(ReadPalette(0, 0));
+      u32 backdrop = color_lut[ReadPalette(0, 0)];
       for (int x = 0; x < 240; x++) {
         line[x] = backdrop;
       }
@@ -113,8 +118,6 @@ void PPU::ComposeScanlineTmpl(int bg_min, int bg_max) {
 
   auto const& dispcnt = mmio.dispcnt;
   auto const& bgcnt = mmio.bgcnt;
-  auto const& winin = mmio.winin;
-  auto const& winout = mmio.winout;
 
   int bg_list[4];
   int bg_count = 0;
@@ -128,34 +131,15 @@ void PPU::ComposeScanlineTmpl(int bg_min, int bg_max) {
     }
   }
 
-  bool win0_active = false;
-  bool win1_active = false;
-  bool win2_active = false;
-
-  const int* win_layer_enable;
-  
-  if constexpr (window) {
-    win0_active = dispcnt.enable[ENABLE_WIN0] && window_scanline_enable[0];
-    win1_active = dispcnt.enable[ENABLE_WIN1] && window_scanline_enable[1];
-    win2_active = dispcnt.enable[ENABLE_OBJWIN];
-  }
-
   int prio[2];
   int layer[2];
   u16 pixel[2];
 
   for (int x = 0; x < 240; x++) {
+    int win_layer_enable = 0x3F;
+
     if constexpr (window) {
-      // Determine the window with the highest priority for this pixel.
-      if (win0_active && buffer_win[0][x]) {
-        win_layer_enable = winin.enable[0];
-      } else if (win1_active && buffer_win[1][x]) {
-        win_layer_enable = winin.enable[1];
-      } else if (win2_active && buffer_obj[x].window) {
-        win_layer_enable = winout.enable[1];
-      } else {
-        win_layer_enable = winout.enable[0];
-      }
+      win_layer_enable = window_layer_mask[x];
     }
 
     if constexpr (blending) {
@@ -170,7 +154,7 @@ void PPU::ComposeScanlineTmpl(int bg_min, int bg_max) {
       for (int i = 0; i < bg_count; i++) {
         int bg = bg_list[i];
 
-        if (!window || win_layer_enable[bg]) {
+        if (win_layer_enable & (1 << bg)) {
           auto pixel_new = buffer_bg[bg][x];
           if (pixel_new != s_color_transparent) {
             layer[1] = layer[0];
@@ -184,7 +168,7 @@ void PPU::ComposeScanlineTmpl(int bg_min, int bg_max) {
       /* Check if a OBJ pixel takes priority over one of the two
        * top-most background pixels and insert it accordingly.
        */
-      if ((!window || win_layer_enable[LAYER_OBJ]) &&
+      if ((win_layer_enable & (1 << LAYER_OBJ)) &&
           dispcnt.enable[ENABLE_OBJ] &&
           buffer_obj[x].color != s_color_transparent) {
         int priority = buffer_obj[x].priority;
@@ -214,7 +198,7 @@ void PPU::ComposeScanlineTmpl(int bg_min, int bg_max) {
         }
       }
 
-      if (!window || win_layer_enable[LAYER_SFX] || is_alpha_obj) {
+      if ((win_layer_enable & (1 << LAYER_SFX)) || is_alpha_obj) {
         auto blend_mode = mmio.bldcnt.sfx;
         bool have_dst = mmio.bldcnt.targets[0][layer[0]];
         bool have_src = mmio.bldcnt.targets[1][layer[1]];
@@ -234,7 +218,7 @@ void PPU::ComposeScanlineTmpl(int bg_min, int bg_max) {
         for (int i = bg_count - 1; i >= 0; i--) {
           int bg = bg_list[i];
 
-          if (!window || win_layer_enable[bg]) {
+          if (win_layer_enable & (1 << bg)) {
             u16 pixel_new = buffer_bg[bg][x];
             if (pixel_new != s_color_transparent) {
               pixel[0] = pixel_new;
@@ -246,7 +230,7 @@ void PPU::ComposeScanlineTmpl(int bg_min, int bg_max) {
       }
 
       // Check if a OBJ pixel takes priority over the top-most background pixel.
-      if ((!window || win_layer_enable[LAYER_OBJ]) &&
+      if ((win_layer_enable & (1 << LAYER_OBJ)) &&
           dispcnt.enable[ENABLE_OBJ] &&
           buffer_obj[x].color != s_color_transparent &&
           buffer_obj[x].priority <= prio[0]) {
@@ -254,7 +238,7 @@ void PPU::ComposeScanlineTmpl(int bg_min, int bg_max) {
       }
     }
 
-    line[x] = ConvertColor(pixel[0]);
+    line[x] = color_lut[pixel[0] & 0x7FFF];
   }
 }
 
@@ -267,12 +251,20 @@ void PPU::ComposeScanline(int bg_min, int bg_max) {
       dispcnt.enable[ENABLE_WIN1] ||
       dispcnt.enable[ENABLE_OBJWIN]) {
     key |= 1;
+    RenderWindowLayerMask();
   }
 
   if (mmio.bldcnt.sfx != BlendMode::SFX_NONE || line_contains_alpha_obj) {
     key |= 2;
   }
 
+  if (compose_simd != nullptr) {
+    compose_args.window = key & 1;
+    compose_args.blending = key & 2;
+    ComposeScanlineSIMD(bg_min, bg_max);
+    return;
+  }
+
   switch (key) {
     case 0b00:
       ComposeScanlineTmpl<false, false>(bg_min, bg_max);
@@ -289,6 +281,56 @@ void PPU::ComposeScanline(int bg_min, int bg_max) {
   }
 }
 
+void PPU::ComposeScanlineSIMD(int bg_min, int bg_max) {
+  auto const& dispcnt = mmio.dispcnt;
+  auto const& bgcnt = mmio.bgcnt;
+  auto const& bldcnt = mmio.bldcnt;
+  auto& args = compose_args;
+
+  // Sort enabled backgrounds by their priority, from back to front.
+  args.bg_count = 0;
+  for (int prio = 3; prio >= 0; prio--) {
+    for (int bg = bg_max; bg >= bg_min; bg--) {
+      if (dispcnt.enable[bg] && bgcnt[bg].priority == prio) {
+        int i = args.bg_count++;
+        args.bg_pixels[i] = buffer_bg[bg];
+        args.bg_priority[i] = prio;
+        args.bg_layer_bit[i] = 1 << bg;
+      }
+    }
+  }
+
+  args.obj_enable = dispcnt.enable[ENABLE_OBJ];
+  if (args.obj_enable) {
+    for (int x = 0; x < 240; x++) {
+      auto const& pixel = buffer_obj[x];
+      args.obj_color[x] = pixel.color;
+      args.obj_priority[x] = pixel.priority;
+      args.obj_alpha[x] = pixel.alpha;
+    }
+  }
+
+  args.win_layer_mask = window_layer_mask;
+
+  if (args.blending) {
+    args.sfx = bldcnt.sfx;
+    args.blend_dst_mask = 0;
+    args.blend_src_mask = 0;
+    for (int layer = 0; layer < 6; layer++) {
+      if (bldcnt.targets[0][layer]) args.blend_dst_mask |= 1 << layer;
+      if (bldcnt.targets[1][layer]) args.blend_src_mask |= 1 << layer;
+    }
+    args.eva = std::min<int>(16, mmio.eva);
+    args.evb = std::min<int>(16, mmio.evb);
+    args.evy = std::min<int>(16, mmio.evy);
+  }
+
+  args.backdrop = ReadPalette(0, 0);
+  args.swap_rb = config->video.format == Config::Video::Format::ABGR8888;
+
+  compose_simd(args, &output[mmio.vcount * 240]);
+}
+
 void PPU::Blend(u16& target1,
                 u16  target2,
                 BlendMode sfx) {
@@ -6,51 +6,64 @@
  */
 
 auto ReadPalette(int palette, int index) -> u16 {
-  int cell = (palette * 32) + (index * 2);
+  return pram16[palette * 16 + index];
+}
 
-  /* TODO: On Little-Endian devices we can get away with casting to uint16_t*. */
-  return ((pram[cell + 1] << 8) |
-           pram[cell + 0]) & 0x7FFF;
+void ALWAYS_INLINE MarkTileDirty(u32 address) {
+  int tile = address >> 5;
+  tile_dirty[tile >> 6] |= 1ULL << (tile & 63);
 }
 
-void DecodeTileLine4BPP(u16* buffer, u32 base, int palette, int number, int y, bool flip) {
-  u8* data = &vram[base + (number * 32) + (y * 4)];
+/* Returns the palette indices of a row of a 4BPP tile, one byte per pixel.
+ * Tiles are decoded once and then reused until VRAM is written to.
+ */
+auto GetTileRow4BPP(u32 address, int y) -> u8 const* {
+  int tile = address >> 5;
+  u64 bit = 1ULL << (tile & 63);
+  u8* indices = tile_cache[tile];
 
-  if (flip) {
-    for (int x = 0; x < 4; x++) {
-      int d  = *data++;
-      int p1 = d & 15;
-      int p2 = d >> 4;
+  if (tile_dirty[tile >> 6] & bit) {
+    u8 const* data = &vram[tile << 5];
 
-      buffer[(x*2+0)^7] = p1 ? ReadPalette(palette, p1) : s_color_transparent;
-      buffer[(x*2+1)^7] = p2 ? ReadPalette(palette, p2) : s_color_transparent;
+    for (int i = 0; i < 32; i++) {
+      indices[i * 2 + 0] = data[i] & 15;
+      indices[i * 2 + 1] = data[i] >> 4;
     }
-  } else {
-    for (int x = 0; x < 4; x++) {
-      int d  = *data++;
-      int p1 = d & 15;
-      int p2 = d >> 4;
 
-      buffer[x*2+0] = p1 ? ReadPalette(palette, p1) : s_color_transparent;
-      buffer[x*2+1] = p2 ? ReadPalette(palette, p2) : s_color_transparent;
-    }
+    tile_dirty[tile >> 6] &= ~bit;
+  }
+
+  return &indices[y * 8];
+}
+
+/* Resolves a row of eight palette indices to colors. */
+void ResolveTileLine(u16* buffer, u8 const* indices, int palette, bool flip) {
+  int flip_mask = flip ? 7 : 0;
+
+  for (int x = 0; x < 8; x++) {
+    int index = indices[x];
+    buffer[x ^ flip_mask] = index ? ReadPalette(palette, index) : s_color_transparent;
   }
 }
 
+void DecodeTileLine4BPP(u16* buffer, u32 base, int palette, int number, int y, bool flip) {
+  ResolveTileLine(buffer, GetTileRow4BPP(base + number * 32, y), palette, flip);
+}
+
 void DecodeTileLine8BPP(u16* buffer, u32 base, int number, int y, bool flip) {
-  u8* data = &vram[base + (number * 64) + (y * 8)];
+  u32 address = base + (number * 64) + (y * 8);
 
-  if (flip) {
-    for (int x = 7; x >= 0; x--) {
-      int pixel = *data++;
-      buffer[x] = pixel ? ReadPalette(0, pixel) : s_color_transparent;
-    }
-  } else {
+  /* Background tiles cannot be fetched from OBJ VRAM, these pixels are transparent.
+   * 8BPP tile numbers may otherwise reach past the end of VRAM.
+   */
+  if (address >= 0x10000) {
     for (int x = 0; x < 8; x++) {
-      int pixel = *data++;
-      buffer[x] = pixel ? ReadPalette(0, pixel) : s_color_transparent;
+      buffer[x] = s_color_transparent;
     }
+    return;
   }
+
+  ResolveTileLine(buffer, &vram[address], 0, flip);
 }
 
 auto DecodeTilePixel4BPP(u32 address, int palette, int x, int y) -> u16 {
@@ -78,10 +91,28 @@ auto DecodeTilePixel8BPP(u32 address, int x, int y, bool sprite = false) -> u16
   }
 }
 
-void AffineRenderLoop(int id,
-                      int width,
-                      int height,
-                      std::function<void(int, int, int)> render_func) {
+static auto ALWAYS_INLINE WrapAffineCoordinate(s32 value, int size) -> s32 {
+  if (value >= size) {
+    return value % size;
+  }
+  if (value < 0) {
+    return size + (value % size);
+  }
+  return value;
+}
+
+/* Renders a line of an affine or bitmap background. fetch(line_x, x, y) writes
+ * the pixel at texel (x, y) to line_x. For lines that are only scrolled (no
+ * rotation, scaling or mosaic) the texels lie on a single row, in which case
+ * the visible span is clipped once and passed to fetch_span(line_x, x, y, count)
+ * if the caller provides one.
+ */
+template<typename Fetch, typename FetchSpan = std::nullptr_t>
+void ALWAYS_INLINE AffineRenderLoop(int id,
+                                    int width,
+                                    int height,
+                                    Fetch&& fetch,
+                                    FetchSpan&& fetch_span = nullptr) {
   auto const& bg = mmio.bgcnt[2 + id];
   auto const& mosaic = mmio.mosaic.bg;
   u16* buffer = buffer_bg[2 + id];
@@ -91,6 +122,38 @@ void AffineRenderLoop(int id,
   s16 pa = mmio.bgpa[id];
   s16 pc = mmio.bgpc[id];
   
+  if (pa == 0x100 && pc == 0 && !bg.mosaic_enable) {
+    s32 x = ref_x >> 8;
+    s32 y = ref_y >> 8;
+
+    // Line x maps to texel x + line x, so the visible span is [begin, end).
+    int begin = std::clamp(-x, 0, 240);
+    int end = std::clamp(width - x, 0, 240);
+
+    if (bg.wraparound) {
+      y = WrapAffineCoordinate(y, height);
+    } else if (y >= height || y < 0) {
+      begin = end = 240;
+    }
+
+    // Spans which wrap around horizontally take the generic path.
+    if (!bg.wraparound || (begin == 0 && end == 240)) {
+      for (int _x = 0; _x < begin; _x++) buffer[_x] = s_color_transparent;
+      for (int _x = std::max(begin, end); _x < 240; _x++) buffer[_x] = s_color_transparent;
+
+      if (begin < end) {
+        if constexpr (std::is_same_v<std::decay_t<FetchSpan>, std::nullptr_t>) {
+          for (int _x = begin; _x < end; _x++) {
+            fetch(_x, x + _x, y);
+          }
+        } else {
+          fetch_span(begin, x + begin, y, end - begin);
+        }
+      }
+      return;
+    }
+  }
+
   int mosaic_x = 0;
   
   for (int _x = 0; _x < 240; _x++) {
@@ -109,22 +172,13 @@ void AffineRenderLoop(int id,
     }
     
     if (bg.wraparound) {
-      if (x >= width) {
-        x %= width;
-      } else if (x < 0) {
-        x = width + (x % width);
-      }
-      
-      if (y >= height) {
-        y %= height;
-      } else if (y < 0) {
-        y = height + (y % height);
-      }
+      x = WrapAffineCoordinate(x, width);
+      y = WrapAffineCoordinate(y, height);
     } else if (x >= width || y >= height || x < 0 || y < 0) {
       buffer[_x] = s_color_transparent;
       continue;
     }
     
-    render_func(_x, (int)x, (int)y);
+    fetch(_x, (int)x, (int)y);
   }
 }
@@ -19,15 +19,39 @@ PPU::PPU(
 )   : scheduler(scheduler)
     , irq(irq)
     , dma(dma)
-    , config(config) {
+    , config(config)
+    , compose_simd(simd::GetComposeFunction()) {
+  scheduler.Register<&PPU::OnScanlineComplete>(EventClass::PPU_scanline_complete, this);
+  scheduler.Register<&PPU::OnHblankComplete>(EventClass::PPU_hblank_complete, this);
+  scheduler.Register<&PPU::OnVblankScanlineComplete>(EventClass::PPU_vblank_scanline_complete, this);
+  scheduler.Register<&PPU::OnVblankHblankComplete>(EventClass::PPU_vblank_hblank_complete, this);
   Reset();
   mmio.dispstat.ppu = this;
 }
 
+PPU::PPU(PPU const* parent)
+    : scheduler(parent->scheduler)
+    , irq(parent->irq)
+    , dma(parent->dma)
+    , config(parent->config)
+    , compose_simd(parent->compose_simd) {
+  ResetRenderState();
+
+  // Continue with the line buffers of the parent, they are not reset.
+  std::memcpy(buffer_bg, parent->buffer_bg, sizeof(buffer_bg));
+  std::memcpy(buffer_obj, parent->buffer_obj, sizeof(buffer_obj));
+  std::memcpy(buffer_win, parent->buffer_win, sizeof(buffer_win));
+  std::memcpy(window_scanline_enable, parent->window_scanline_enable, sizeof(window_scanline_enable));
+  line_contains_alpha_obj = parent->line_contains_alpha_obj;
+}
+
+PPU::~PPU() {
+  StopRenderThread();
+}
+
 void PPU::Reset() {
-  std::memset(pram, 0, 0x00400);
-  std::memset(oam,  0, 0x00400);
-  std::memset(vram, 0, 0x18000);
+  StopRenderThread();
+  ResetRenderState();
 
   mmio.dispcnt.Reset();
   mmio.dispstat.Reset();
@@ -62,7 +86,41 @@ void PPU::Reset() {
   mmio.evy = 0;
   mmio.bldcnt.Reset();
 
-  scheduler.Add(1006, this, &PPU::OnScanlineComplete);
+  scheduler.Add(1006, EventClass::PPU_scanline_complete);
+
+  frameskip_counter = 0;
+  SelectFrameToRender();
+
+  // The render thread would only compete with the emulation for a single core.
+  if (config->video.threaded_renderer && std::thread::hardware_concurrency() != 1) {
+    StartRenderThread();
+  }
+}
+
+void PPU::ResetRenderState() {
+  std::memset(pram, 0, 0x00400);
+  std::memset(pram16, 0, sizeof(pram16));
+  std::memset(oam,  0, 0x00400);
+  std::memset(vram, 0, 0x18000);
+  std::memset(tile_dirty, 0xFF, sizeof(tile_dirty));
+
+  for (int color = 0; color < 0x8000; color++) {
+    color_lut[color] = ConvertColor(color, config->video.format);
+  }
+
+  pram_dirty = true;
+  oam_dirty = true;
+  obj_list_dirty = true;
+
+  SelectOutputBuffer();
+}
+
+void PPU::SelectOutputBuffer() {
+  output = config->video_dev->GetFrameBuffer();
+
+  if (output == nullptr) {
+    output = output_buffer;
+  }
 }
 
 void PPU::CheckVerticalCounterIRQ() {
@@ -83,7 +141,7 @@ void PPU::OnScanlineComplete(int cycles_late) {
   auto& bgpd = mmio.bgpd;
   auto& mosaic = mmio.mosaic;
 
-  scheduler.Add(226 - cycles_late, this, &PPU::OnHblankComplete);
+  scheduler.Add(226 - cycles_late, EventClass::PPU_hblank_complete);
 
   mmio.dispstat.hblank_flag = 1;
 
@@ -139,18 +197,20 @@ void PPU::OnHblankComplete(int cycles_late) {
   vcount++;
   CheckVerticalCounterIRQ();
 
+  int ops = 0;
+
   if (dispcnt.enable[ENABLE_WIN0]) {
-    RenderWindow(0);
+    ops |= RENDER_WIN0;
   }
 
   if (dispcnt.enable[ENABLE_WIN1]) {
-    RenderWindow(1);
+    ops |= RENDER_WIN1;
   }
 
   if (vcount == 160) {
-    config->video_dev->Draw(output);
+    Render(ops | RENDER_PRESENT, 0);
 
-    scheduler.Add(1006 - cycles_late, this, &PPU::OnVblankScanlineComplete);
+    scheduler.Add(1006 - cycles_late, EventClass::PPU_vblank_scanline_complete);
     dma.Request(DMA::Occasion::VBlank);
     dispstat.vblank_flag = 1;
 
@@ -168,19 +228,20 @@ void PPU::OnHblankComplete(int cycles_late) {
     bgx[1]._current = bgx[1].initial;
     bgy[1]._current = bgy[1].initial;
   } else {
-    scheduler.Add(1006 - cycles_late, this, &PPU::OnScanlineComplete);
-    RenderScanline();
+    scheduler.Add(1006 - cycles_late, EventClass::PPU_scanline_complete);
+    ops |= RENDER_LINE;
     // Render OBJs for the next scanline.
     if (mmio.dispcnt.enable[ENABLE_OBJ]) {
-      RenderLayerOAM(mmio.dispcnt.mode >= 3, mmio.vcount + 1);
+      ops |= RENDER_OAM;
     }
+    Render(ops, mmio.vcount + 1);
   }
 }
 
 void PPU::OnVblankScanlineComplete(int cycles_late) {
   auto& dispstat = mmio.dispstat;
 
-  scheduler.Add(226 - cycles_late, this, &PPU::OnVblankHblankComplete);
+  scheduler.Add(226 - cycles_late, EventClass::PPU_vblank_hblank_complete);
 
   dispstat.hblank_flag = 1;
 
@@ -199,39 +260,100 @@ void PPU::OnVblankHblankComplete(int cycles_late) {
   auto& vcount = mmio.vcount;
   auto& dispstat = mmio.dispstat;
 
+  int ops = 0;
+  int oam_line = 0;
+
   dispstat.hblank_flag = 0;
 
   if (vcount == 227) {
-    scheduler.Add(1006 - cycles_late, this, &PPU::OnScanlineComplete);
+    scheduler.Add(1006 - cycles_late, EventClass::PPU_scanline_complete);
     vcount = 0;
   } else {
-    scheduler.Add(1006 - cycles_late, this, &PPU::OnVblankScanlineComplete);
+    scheduler.Add(1006 - cycles_late, EventClass::PPU_vblank_scanline_complete);
     if (++vcount == 227) {
       dispstat.vblank_flag = 0;
+      SelectFrameToRender();
       // Render OBJs for the next scanline
       if (mmio.dispcnt.enable[ENABLE_OBJ]) {
-        RenderLayerOAM(mmio.dispcnt.mode >= 3, 0);
+        ops |= RENDER_OAM;
       }
     }
   }
 
   if (mmio.dispcnt.enable[ENABLE_WIN0]) {
-    RenderWindow(0);
+    ops |= RENDER_WIN0;
   }
 
   if (mmio.dispcnt.enable[ENABLE_WIN1]) {
-    RenderWindow(1);
+    ops |= RENDER_WIN1;
   }
 
   if (vcount == 0) {
-    RenderScanline();
+    ops |= RENDER_LINE;
     // Render OBJs for the next scanline
     if (mmio.dispcnt.enable[ENABLE_OBJ]) {
-      RenderLayerOAM(mmio.dispcnt.mode >= 3, 1);
+      ops |= RENDER_OAM;
+      oam_line = 1;
     }
   }
 
+  Render(ops, oam_line);
+
   CheckVerticalCounterIRQ();
 }
 
+void PPU::SetFrameskip(int frameskip) {
+  this->frameskip = frameskip;
+  frameskip_counter = 0;
+}
+
+void PPU::RequestFrame() {
+  frame_requested = true;
+}
+
+/* Decided right before the OBJs of the first line are rendered. */
+void PPU::SelectFrameToRender() {
+  if (frame_requested) {
+    render_frame = true;
+    frame_requested = false;
+  } else if (frameskip < 0) {
+    render_frame = false;
+  } else {
+    render_frame = frameskip_counter == 0;
+    if (++frameskip_counter > frameskip) {
+      frameskip_counter = 0;
+    }
+  }
+}
+
+void PPU::Render(int ops, int oam_line) {
+  // Windows are still tracked in skipped frames, since their state carries over to the next frame.
+  if (!render_frame) {
+    ops &= RENDER_WIN0 | RENDER_WIN1;
+    if (ops == 0) {
+      return;
+    }
+  }
+
+  if (render_thread) {
+    SubmitRenderCommand(ops, oam_line);
+  } else {
+    ExecuteRenderOps(ops, oam_line);
+  }
+}
+
+/* Render operations are executed in the order of windows, scanline, OBJs
+ * and presentation, which matches the order the H-blank handlers need.
+ */
+void PPU::ExecuteRenderOps(int ops, int oam_line) {
+  if (ops & RENDER_WIN0) RenderWindow(0);
+  if (ops & RENDER_WIN1) RenderWindow(1);
+  if (ops & RENDER_LINE) RenderScanline();
+  if (ops & RENDER_OAM)  RenderLayerOAM(mmio.dispcnt.mode >= 3, oam_line);
+  if (ops & RENDER_PRESENT) {
+    config->video_dev->Draw(output);
+    SelectOutputBuffer();
+  }
+}
+
 } // namespace nba::core
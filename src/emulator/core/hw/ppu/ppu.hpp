@@ -14,10 +14,17 @@
 #include <emulator/core/hw/interrupt.hpp>
 #include <emulator/core/scheduler.hpp>
 #include <common/integer.hpp>
-#include <functional>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
 #include <type_traits>
 
 #include "registers.hpp"
+#include "simd/compose.hpp"
 
 namespace nba::core {
 
@@ -29,8 +36,17 @@ struct PPU {
     std::shared_ptr<Config> config
   );
 
+ ~PPU();
+
   void Reset();
 
+  /// Renders only every (frameskip + 1)-th frame, or no frame unless requested if negative.
+  /// Skipped frames still update the timing-relevant state (flags, IRQs, DMA, affine registers).
+  void SetFrameskip(int frameskip);
+
+  /// Renders the next frame regardless of the frameskip.
+  void RequestFrame();
+
   template<typename T>
   auto ALWAYS_INLINE ReadPRAM(u32 address) noexcept -> T {
     return common::read<T>(pram, address & 0x3FF);
@@ -43,6 +59,14 @@ struct PPU {
     } else {
       common::write<T>(pram, address & 0x3FF, value);
     }
+
+    pram_dirty = true;
+
+    address = (address & 0x3FF) >> 1;
+    pram16[address] = common::read<u16>(pram, address << 1) & 0x7FFF;
+    if constexpr (std::is_same_v<T, u32>) {
+      pram16[address + 1] = common::read<u16>(pram, (address + 1) << 1) & 0x7FFF;
+    }
   }
 
   template<typename T>
@@ -60,6 +84,7 @@ struct PPU {
     if (address >= 0x18000) {
       address &= ~0x8000;
     }
+    MarkTileDirty(address);
     if (std::is_same_v<T, u8>) {
       auto limit = mmio.dispcnt.mode >= 3 ? 0x14000 : 0x10000;
       if (address < limit) {
@@ -79,6 +104,8 @@ struct PPU {
   void ALWAYS_INLINE WriteOAM(u32 address, T value) noexcept {
     if constexpr (!std::is_same_v<T, u8>) {
       common::write<T>(oam, address & 0x3FF, value);
+      oam_dirty = true;
+      obj_list_dirty = true;
     }
   }
 
@@ -148,6 +175,67 @@ private:
     ENABLE_OBJWIN = 7
   };
 
+  enum RenderOp {
+    RENDER_WIN0 = 1,
+    RENDER_WIN1 = 2,
+    RENDER_LINE = 4,
+    RENDER_OAM  = 8,
+    RENDER_PRESENT = 16
+  };
+
+  /** Snapshot of the state needed to execute the render operations of one H-blank
+    * on the render thread, including the PRAM, OAM and VRAM tiles written since
+    * the previous snapshot.
+    */
+  struct RenderCommand {
+    static constexpr int kMaxTiles = 256;
+
+    MMIO mmio;
+    int ops;
+    int oam_line;
+    bool pram_dirty;
+    bool oam_dirty;
+    int tile_count;
+    u8 pram[0x400];
+    u8 oam[0x400];
+    u16 tile_index[kMaxTiles];
+    u8 tile_data[kMaxTiles][32];
+  };
+
+  /** Single-producer single-consumer queue of render commands,
+    * and the render-only PPU instance which executes them.
+    */
+  struct RenderThread {
+    static constexpr size_t kCapacity = 32;
+    static constexpr int kSpinCount = 4096;
+
+    std::unique_ptr<PPU> ppu;
+    std::unique_ptr<RenderCommand[]> commands;
+    std::atomic<size_t> read_index = 0;
+    std::atomic<size_t> write_index = 0;
+    std::atomic_bool sleeping = false;
+    std::atomic_bool stop = false;
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::thread thread;
+  };
+
+  /// Constructs the render-only instance of a threaded PPU, which is not attached to the scheduler.
+  explicit PPU(PPU const* parent);
+
+  void ResetRenderState();
+  void SelectOutputBuffer();
+
+  void SelectFrameToRender();
+  void Render(int ops, int oam_line);
+  void ExecuteRenderOps(int ops, int oam_line);
+  void StartRenderThread();
+  void StopRenderThread();
+  void DrainRenderThread();
+  void SubmitRenderCommand(int ops, int oam_line);
+  void RenderThreadMain();
+  void ApplyRenderCommand(RenderCommand const& command);
+
   void CheckVerticalCounterIRQ();
   void OnScanlineComplete(int cycles_late);
   void OnHblankComplete(int cycles_late);
@@ -160,14 +248,17 @@ private:
   void RenderLayerBitmap1();
   void RenderLayerBitmap2();
   void RenderLayerBitmap3();
+  void UpdateObjectList();
   void RenderLayerOAM(bool bitmap_mode, int line);
   void RenderWindow(int id);
+  void RenderWindowLayerMask();
 
-  static auto ConvertColor(u16 color) -> u32;
+  static auto ConvertColor(u16 color, Config::Video::Format format) -> u32;
 
   template<bool window, bool blending>
   void ComposeScanlineTmpl(int bg_min, int bg_max);
   void ComposeScanline(int bg_min, int bg_max);
+  void ComposeScanlineSIMD(int bg_min, int bg_max);
   void Blend(u16& target1, u16 target2, BlendControl::Effect sfx);
 
   #include "helper.inl"
@@ -192,10 +283,74 @@ private:
     unsigned window : 1;
   } buffer_obj[240];
 
-  bool buffer_win[2][240];
+  /* Horizontal extent of WIN0 and WIN1, bit x is set if pixel x is inside. */
+  u64 buffer_win[2][4];
   bool window_scanline_enable[2];
 
-  u32 output[240*160];
+  /* Frame buffer provided by the video device or output_buffer if there is none. */
+  u32* output;
+  u32 output_buffer[240*160];
+
+  /* Cache of decoded 4BPP tiles (palette index per pixel) and a bit per tile,
+   * which is set when the tile has been written since it was last decoded.
+   */
+  u8  tile_cache[0x18000 / 32][64];
+  u64 tile_dirty[0x18000 / 32 / 64];
+
+  /* Vectorized compositor for the host (if any), ComposeScanlineTmpl() is the reference. */
+  simd::ComposeFunction compose_simd;
+  simd::ComposeArgs compose_args;
+
+  /* Palette entries without the unused bit 15, kept in sync with PRAM. */
+  u16 pram16[0x200];
+
+  /* RGB555 to output format conversion table, blended colors are no palette entries. */
+  u32 color_lut[0x8000];
+
+  /* Set by writes to PRAM and OAM, only used by the threaded renderer.
+   * Written VRAM is tracked in tile_dirty.
+   */
+  bool pram_dirty;
+  bool oam_dirty;
+
+  std::unique_ptr<RenderThread> render_thread;
+
+  int  frameskip = 0;
+  int  frameskip_counter = 0;
+  bool frame_requested = false;
+  bool render_frame = true;
+
+  /* OBJ attributes decoded from OAM. */
+  struct Object {
+    s32 x;
+    s32 y;
+    int width;
+    int height;
+    int half_width;
+    int half_height;
+    int number;
+    int palette;
+    int prio;
+    int mode;
+    bool mosaic;
+    bool affine;
+    bool flip_h;
+    bool flip_v;
+    bool is_256;
+    s16 transform[4];
+  } objects[128];
+
+  /* Indices of the OBJs which intersect each line, in OAM order.
+   * OBJs are also prepared for line 160, which is never displayed.
+   */
+  static constexpr int kObjectLines = 161;
+
+  u8 obj_line_list[kObjectLines][128];
+  u8 obj_line_count[kObjectLines];
+  bool obj_list_dirty;
+
+  /* Enabled layers of each pixel of the current line as selected by the windows. */
+  alignas(32) u8 window_layer_mask[240];
 
   static constexpr u16 s_color_transparent = 0x8000;
   static const int s_obj_size[4][4][2];
@@ -193,6 +193,7 @@ void WindowLayerSelect::Write(int address, u8 value) {
   for (int i = 0; i < 6; i++) {
     enable[address][i] = (value >> i) & 1;
   }
+  mask[address] = value & 0x3F;
 }
 
 void BlendControl::Reset() {
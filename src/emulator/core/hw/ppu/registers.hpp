@@ -98,6 +98,9 @@ struct WindowRange {
 struct WindowLayerSelect {
   int enable[2][6];
 
+  /* The same enable bits packed into a layer mask (bit n = layer n). */
+  u8 mask[2];
+
   void Reset();
   auto Read(int offset) -> u8;
   void Write(int offset, u8 value);
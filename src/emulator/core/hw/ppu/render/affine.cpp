@@ -23,17 +23,40 @@ void PPU::RenderLayerAffine(int id) {
     case 0: size = 128;  block_width = 16;  break;
     case 1: size = 256;  block_width = 32;  break;
     case 2: size = 512;  block_width = 64;  break;
-    case 3: size = 1024; block_width = 128; break;
+    default: size = 1024; block_width = 128; break;
   }
   
-  AffineRenderLoop(id, size, size, [&](int line_x, int x, int y) {
+  auto fetch = [&](int line_x, int x, int y) {
     auto tile_number = vram[map_base + (y / 8) * block_width + (x / 8)];
     buffer[line_x] = DecodeTilePixel8BPP(
       tile_base + tile_number * 64,
       x % 8,
       y % 8
     );
-  });
+  };
+
+  // Scrolled lines read the map entry once per tile instead of once per pixel.
+  auto fetch_span = [&](int line_x, int x, int y, int count) {
+    u8 const* map = &vram[map_base + (y / 8) * block_width];
+    u32 row = tile_base + (y % 8) * 8;
+
+    while (count > 0) {
+      u8 const* indices = &vram[row + map[x / 8] * 64];
+      int tile_x = x % 8;
+      int length = std::min(8 - tile_x, count);
+
+      for (int i = 0; i < length; i++) {
+        int index = indices[tile_x + i];
+        buffer[line_x + i] = index ? ReadPalette(0, index) : s_color_transparent;
+      }
+
+      line_x += length;
+      x += length;
+      count -= length;
+    }
+  };
+
+  AffineRenderLoop(id, size, size, fetch, fetch_span);
 }
 
 } // namespace nba::core
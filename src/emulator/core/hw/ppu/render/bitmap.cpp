@@ -5,6 +5,8 @@
  * Refer to the included LICENSE file.
  */
 
+#include <cstring>
+
 #include "../ppu.hpp"
 
 namespace nba::core {
@@ -14,6 +16,9 @@ void PPU::RenderLayerBitmap1() {
     int index = y * 480 + x * 2;
     
     buffer_bg[2][line_x] = (vram[index + 1] << 8) | vram[index];
+  }, [&](int line_x, int x, int y, int count) {
+    // Unscaled lines are a plain copy of little-endian RGB555 data.
+    std::memcpy(&buffer_bg[2][line_x], &vram[y * 480 + x * 2], count * sizeof(u16));
   });
 }
 
@@ -24,6 +29,13 @@ void PPU::RenderLayerBitmap2() {
     int index = frame + y * 240 + x;
     
     buffer_bg[2][line_x] = ReadPalette(0, vram[index]);
+  }, [&](int line_x, int x, int y, int count) {
+    u8 const* indices = &vram[frame + y * 240 + x];
+    u16* buffer = &buffer_bg[2][line_x];
+
+    for (int i = 0; i < count; i++) {
+      buffer[i] = ReadPalette(0, indices[i]);
+    }
   });
 }
 
@@ -34,6 +46,8 @@ void PPU::RenderLayerBitmap3() {
     int index = frame + y * 320 + x * 2;
     
     buffer_bg[2][line_x] = (vram[index + 1] << 8) | vram[index];
+  }, [&](int line_x, int x, int y, int count) {
+    std::memcpy(&buffer_bg[2][line_x], &vram[frame + y * 320 + x * 2], count * sizeof(u16));
   });
 }
 
@@ -5,6 +5,9 @@
  * Refer to the included LICENSE file.
  */
 
+#include <algorithm>
+#include <cstring>
+
 #include "../ppu.hpp"
 
 namespace nba::core {
@@ -40,89 +43,126 @@ const int PPU::s_obj_size[4][4][2] = {
   }
 };
 
-void PPU::RenderLayerOAM(bool bitmap_mode, int line) {
-  int tile_num;
-  u16 pixel;
-  s16 transform[4];
-  int cycles = mmio.dispcnt.hblank_oam_access ? 954 : 1210;
+/* Decodes the attributes of all OBJs and sorts them into per-line lists,
+ * keeping OAM order. Only done after OAM has been written.
+ */
+void PPU::UpdateObjectList() {
+  std::memset(obj_line_count, 0, sizeof(obj_line_count));
 
-  line_contains_alpha_obj = false;
+  for (int i = 0; i < 128; i++) {
+    int offset = i * 8;
 
-  for (int x = 0; x < 240; x++) {
-    buffer_obj[x].priority = 4;
-    buffer_obj[x].color = s_color_transparent;
-    buffer_obj[x].alpha = 0;
-    buffer_obj[x].window = 0;
-  }
-
-  for (s32 offset = 0; offset <= 127 * 8; offset += 8) {
     if ((oam[offset + 1] & 3) == 2) {
       continue;
     }
 
-    u16 attr0 = (oam[offset + 1] << 8) | oam[offset + 0];
-    u16 attr1 = (oam[offset + 3] << 8) | oam[offset + 2];
-    u16 attr2 = (oam[offset + 5] << 8) | oam[offset + 4];
-
-    int width;
-    int height;
+    u16 attr0 = common::read<u16>(oam, offset + 0);
+    u16 attr1 = common::read<u16>(oam, offset + 2);
+    u16 attr2 = common::read<u16>(oam, offset + 4);
 
-    s32 x = attr1 & 0x1FF;
-    s32 y = attr0 & 0x0FF;
-    int shape  =  attr0 >> 14;
-    int size   =  attr1 >> 14;
-    int prio   = (attr2 >> 10) & 3;
-    int mode   = (attr0 >> 10) & 3;
-    int mosaic = (attr0 >> 12) & 1;
+    int mode = (attr0 >> 10) & 3;
 
     if (mode == OBJ_PROHIBITED) {
       continue;
     }
 
-    if (x >= 240) x -= 512;
-    if (y >= 160) y -= 256;
+    auto& object = objects[i];
 
-    int affine  = (attr0 >> 8) & 1;
-    int attr0b9 = (attr0 >> 9) & 1;
+    s32 x = attr1 & 0x1FF;
+    s32 y = attr0 & 0x0FF;
+    int shape = attr0 >> 14;
+    int size  = attr1 >> 14;
 
-    width  = s_obj_size[shape][size][0];
-    height = s_obj_size[shape][size][1];
+    if (x >= 240) x -= 512;
+    if (y >= 160) y -= 256;
 
-    int half_width  = width / 2;
-    int half_height = height / 2;
+    object.affine = (attr0 >> 8) & 1;
+    object.width  = s_obj_size[shape][size][0];
+    object.height = s_obj_size[shape][size][1];
+    object.half_width  = object.width / 2;
+    object.half_height = object.height / 2;
 
-    if (affine) {
+    if (object.affine) {
       int group = ((attr1 >> 9) & 0x1F) << 5;
 
-      transform[0] = (oam[group + 0x7 ] << 8) | oam[group + 0x6 ];
-      transform[1] = (oam[group + 0xF ] << 8) | oam[group + 0xE ];
-      transform[2] = (oam[group + 0x17] << 8) | oam[group + 0x16];
-      transform[3] = (oam[group + 0x1F] << 8) | oam[group + 0x1E];
+      object.transform[0] = common::read<u16>(oam, group + 0x06);
+      object.transform[1] = common::read<u16>(oam, group + 0x0E);
+      object.transform[2] = common::read<u16>(oam, group + 0x16);
+      object.transform[3] = common::read<u16>(oam, group + 0x1E);
 
-      if (attr0b9) {
-        half_width  *= 2;
-        half_height *= 2;
+      if (attr0 & (1 << 9)) {
+        object.half_width  *= 2;
+        object.half_height *= 2;
       }
     } else {
-      transform[0] = 0x100;
-      transform[1] = 0;
-      transform[2] = 0;
-      transform[3] = 0x100;
+      object.transform[0] = 0x100;
+      object.transform[1] = 0;
+      object.transform[2] = 0;
+      object.transform[3] = 0x100;
     }
 
-    x += half_width;
-    y += half_height;
-
-    if (line < (y - half_height) || line >= (y + half_height)) {
-      continue;
+    object.x = x + object.half_width;
+    object.y = y + object.half_height;
+    object.number  =  attr2 & 0x3FF;
+    object.palette = (attr2 >> 12) + 16;
+    object.prio    = (attr2 >> 10) & 3;
+    object.mode    = mode;
+    object.mosaic  = (attr0 >> 12) & 1;
+    object.flip_h  = !object.affine && (attr1 & (1 << 12));
+    object.flip_v  = !object.affine && (attr1 & (1 << 13));
+    object.is_256  = (attr0 >> 13) & 1;
+
+    int line_min = std::max(y, 0);
+    int line_max = std::min(y + object.half_height * 2, kObjectLines);
+
+    for (int line = line_min; line < line_max; line++) {
+      obj_line_list[line][obj_line_count[line]++] = i;
     }
+  }
+
+  obj_list_dirty = false;
+}
+
+void PPU::RenderLayerOAM(bool bitmap_mode, int line) {
+  int tile_num;
+  u16 pixel;
+  int cycles = mmio.dispcnt.hblank_oam_access ? 954 : 1210;
+
+  line_contains_alpha_obj = false;
+
+  for (int x = 0; x < 240; x++) {
+    buffer_obj[x].priority = 4;
+    buffer_obj[x].color = s_color_transparent;
+    buffer_obj[x].alpha = 0;
+    buffer_obj[x].window = 0;
+  }
+
+  if (line >= kObjectLines) {
+    return;
+  }
+
+  if (obj_list_dirty) {
+    UpdateObjectList();
+  }
 
-    int local_y = line - y;
-    int number  =  attr2 & 0x3FF;
-    int palette = (attr2 >> 12) + 16;
-    int flip_h  = !affine && (attr1 & (1 << 12));
-    int flip_v  = !affine && (attr1 & (1 << 13));
-    int is_256  = (attr0 >> 13) & 1;
+  for (int i = 0; i < obj_line_count[line]; i++) {
+    auto const& object = objects[obj_line_list[line][i]];
+
+    s32 x = object.x;
+    int width  = object.width;
+    int height = object.height;
+    int half_width = object.half_width;
+    auto const* transform = object.transform;
+
+    int local_y = line - object.y;
+    int number  = object.number;
+    int palette = object.palette;
+    int prio    = object.prio;
+    int mode    = object.mode;
+    int mosaic  = object.mosaic;
+    int flip_h  = object.flip_h;
+    int flip_v  = object.flip_v;
+    int is_256  = object.is_256;
 
     u32 tile_base = 0x10000;
 
@@ -207,7 +247,7 @@ void PPU::RenderLayerOAM(bool bitmap_mode, int line) {
       }
     }
 
-    if (affine) {
+    if (object.affine) {
       cycles -= 10 + half_width * 4;
     } else {
       cycles -= half_width * 2;
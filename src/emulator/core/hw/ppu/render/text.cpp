@@ -39,7 +39,7 @@ void PPU::RenderLayerText(int id) {
   
   grid_x %= 32;
   
-  u32 base_adjust;
+  u32 base_adjust = 0;
   
   switch (bgcnt.size) {
     case 0:
@@ -69,7 +69,6 @@ void PPU::RenderLayerText(int id) {
       
       encoder = (vram[offset + 1] << 8) | vram[offset];
 
-      /* TODO: speed tile decoding itself up. */
       if (encoder != last_encoder) {
         int number  = encoder & 0x3FF;
         int palette = encoder >> 12;
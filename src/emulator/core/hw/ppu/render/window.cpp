@@ -5,10 +5,22 @@
  * Refer to the included LICENSE file.
  */
 
+#include <cstring>
+
 #include "../ppu.hpp"
 
 namespace nba::core {
 
+/* Returns the bits of pixels [min, max) that fall into the 64-pixel word at offset. */
+static auto GetWindowWord(int min, int max, int offset) -> u64 {
+  auto below = [](int x) -> u64 {
+    x = std::clamp(x, 0, 64);
+    return x == 64 ? ~0ULL : ((1ULL << x) - 1);
+  };
+
+  return below(max - offset) & ~below(min - offset);
+}
+
 void PPU::RenderWindow(int id) {
   int line = mmio.vcount;
   auto& winv = mmio.winv[id];
@@ -23,18 +35,62 @@ void PPU::RenderWindow(int id) {
   }
 
   if (window_scanline_enable[id] && winh._changed) {
-    if (winh.min <= winh.max) {
-      for (int x = 0; x < 240; x++) {
-        buffer_win[id][x] = x >= winh.min && x < winh.max;
-      }
-    } else {
-      for (int x = 0; x < 240; x++) {
-        buffer_win[id][x] = x >= winh.min || x < winh.max;
+    for (int i = 0; i < 4; i++) {
+      u64 bits;
+
+      if (winh.min <= winh.max) {
+        bits = GetWindowWord(winh.min, winh.max, i * 64);
+      } else {
+        // The window wraps around the right edge of the screen.
+        bits = ~GetWindowWord(winh.max, winh.min, i * 64);
       }
+
+      buffer_win[id][i] = bits & GetWindowWord(0, 240, i * 64);
     }
     
     winh._changed = false;
   }
 }
 
+/* Resolves the windows of the current line to the enabled layers of each pixel.
+ * WIN0 takes priority over WIN1, which takes priority over the OBJ window.
+ */
+void PPU::RenderWindowLayerMask() {
+  auto const& dispcnt = mmio.dispcnt;
+
+  std::memset(window_layer_mask, mmio.winout.mask[0], sizeof(window_layer_mask));
+
+  if (dispcnt.enable[ENABLE_OBJWIN]) {
+    u8 mask = mmio.winout.mask[1];
+
+    for (int x = 0; x < 240; x++) {
+      if (buffer_obj[x].window) {
+        window_layer_mask[x] = mask;
+      }
+    }
+  }
+
+  for (int id = 1; id >= 0; id--) {
+    if (!dispcnt.enable[ENABLE_WIN0 + id] || !window_scanline_enable[id]) {
+      continue;
+    }
+
+    u8 mask = mmio.winin.mask[id];
+
+    // Fill each run of consecutive pixels inside the window at once.
+    for (int i = 0; i < 4; i++) {
+      u64 bits = buffer_win[id][i];
+
+      while (bits != 0) {
+        int begin = __builtin_ctzll(bits);
+        u64 rest = ~(bits >> begin);
+        int end = rest == 0 ? 64 : begin + __builtin_ctzll(rest);
+
+        std::memset(&window_layer_mask[i * 64 + begin], mask, end - begin);
+        bits &= end == 64 ? 0 : ~0ULL << end;
+      }
+    }
+  }
+}
+
 } // namespace nba::core
@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2021 fleroviux
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#include "compose.hpp"
+
+#if defined(COMPOSE_X86) && defined(_MSC_VER)
+  #include <intrin.h>
+#endif
+
+namespace nba::core::simd {
+
+#ifdef COMPOSE_X86
+
+static bool HostSupports(bool avx2) {
+#if defined(_MSC_VER)
+  int info[4];
+
+  __cpuid(info, 0);
+  int max_leaf = info[0];
+
+  __cpuid(info, 1);
+  bool sse41 = info[2] & (1 << 19);
+  bool osxsave = info[2] & (1 << 27);
+
+  if (!avx2) {
+    return sse41;
+  }
+
+  // AVX2 also requires the OS to save the YMM registers.
+  if (max_leaf < 7 || !osxsave || (_xgetbv(0) & 6) != 6) {
+    return false;
+  }
+
+  __cpuidex(info, 7, 0);
+  return info[1] & (1 << 5);
+#else
+  __builtin_cpu_init();
+  return avx2 ? __builtin_cpu_supports("avx2") : __builtin_cpu_supports("sse4.1");
+#endif
+}
+
+#endif
+
+auto GetComposeFunction() -> ComposeFunction {
+#if defined(COMPOSE_X86)
+  if (HostSupports(true)) {
+    return &ComposeAVX2;
+  }
+  if (HostSupports(false)) {
+    return &ComposeSSE41;
+  }
+  return nullptr;
+#elif defined(COMPOSE_NEON)
+  return &ComposeNEON;
+#else
+  return nullptr;
+#endif
+}
+
+} // namespace nba::core::simd
@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2021 fleroviux
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#pragma once
+
+#include <common/integer.hpp>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+  #define COMPOSE_X86
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(__aarch64__)
+  #define COMPOSE_NEON
+#endif
+
+namespace nba::core::simd {
+
+/** Everything the vectorized compositor needs to compose one scanline.
+  * It is filled by PPU::ComposeScanline() and mirrors the state that the
+  * scalar PPU::ComposeScanlineTmpl() reads, so both produce identical output.
+  */
+struct ComposeArgs {
+  bool window;
+  bool blending;
+
+  /* Enabled backgrounds from back to front (lowest to highest priority). */
+  int bg_count;
+  u16 const* bg_pixels[4];
+  u16 bg_priority[4];
+  u16 bg_layer_bit[4];
+
+  /* OBJ line buffer split into separate arrays. */
+  bool obj_enable;
+  alignas(32) u16 obj_color[240];
+  alignas(32) u16 obj_priority[240];
+  alignas(32) u16 obj_alpha[240];
+
+  /* Enabled layers of each pixel as selected by the windows (bit n = layer n, bit 5 = SFX). */
+  u8 const* win_layer_mask;
+
+  u16 backdrop;
+
+  /* Swap the red and blue channel for ABGR8888 output. */
+  bool swap_rb;
+
+  /* Blending, with the coefficients clamped to 16. */
+  int sfx;
+  u16 blend_dst_mask;
+  u16 blend_src_mask;
+  u16 eva;
+  u16 evb;
+  u16 evy;
+};
+
+/* The values of BlendControl::Effect. */
+enum {
+  kSFXNone,
+  kSFXBlend,
+  kSFXBrighten,
+  kSFXDarken
+};
+
+using ComposeFunction = void (*)(ComposeArgs const& args, u32* line);
+
+/* Implementations are only compiled for the matching architecture
+ * and may only be called if the host supports the instruction set.
+ */
+void ComposeSSE41(ComposeArgs const& args, u32* line);
+void ComposeAVX2(ComposeArgs const& args, u32* line);
+void ComposeNEON(ComposeArgs const& args, u32* line);
+
+/// @returns the fastest compositor supported by the host, or nullptr if there is none.
+auto GetComposeFunction() -> ComposeFunction;
+
+} // namespace nba::core::simd
@@ -0,0 +1,199 @@
+/*
+ * Copyright (C) 2021 fleroviux
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+/* Vectorized scanline compositor, included by each instruction set specific
+ * translation unit after it has defined a vector type V with u16 lanes:
+ *
+ *   V::kLanes               number of u16 lanes
+ *   V::Load(u16 const*)     V::LoadBytes(u8 const*) (zero-extended)
+ *   V::Set(u16)             V::Zero()
+ *   V::And/Or/AndNot(a, b)  (AndNot computes ~a & b)
+ *   V::Add/Sub/Mul(a, b)    V::Min(a, b)  V::ShiftLeft<n>(a)  V::ShiftRight<n>(a)
+ *   V::Equal(a, b)          V::LessEqual(a, b)  (all-ones lanes where true)
+ *   V::Select(mask, a, b)   (a where mask is set, b elsewhere)
+ *   V::StoreRGB888(u32*, a) (converts RGB555 to ARGB8888)
+ *
+ * The definitions must have internal linkage, since they are compiled
+ * with different instruction set flags per translation unit.
+ */
+
+namespace {
+
+using T = typename V::Type;
+
+constexpr u16 kColorTransparent = 0x8000;
+constexpr u16 kLayerOBJ = 1 << 4;
+constexpr u16 kLayerBD  = 1 << 5;
+constexpr u16 kLayerSFX = 1 << 5;
+
+ALWAYS_INLINE T NotEqual(T a, T b) {
+  return V::AndNot(V::Equal(a, b), V::Set(0xFFFF));
+}
+
+ALWAYS_INLINE T TestBits(T a, u16 bits) {
+  return NotEqual(V::And(a, V::Set(bits)), V::Zero());
+}
+
+template<int shift>
+ALWAYS_INLINE T Channel(T color) {
+  return V::And(V::ShiftRight<shift>(color), V::Set(0x1F));
+}
+
+ALWAYS_INLINE T Pack(T r, T g, T b) {
+  return V::Or(V::Or(r, V::ShiftLeft<5>(g)), V::ShiftLeft<10>(b));
+}
+
+ALWAYS_INLINE T BlendAlpha(T color1, T color2, T eva, T evb) {
+  auto blend = [&](T c1, T c2) {
+    return V::Min(V::ShiftRight<4>(V::Add(V::Mul(c1, eva), V::Mul(c2, evb))), V::Set(31));
+  };
+
+  return Pack(
+    blend(Channel< 0>(color1), Channel< 0>(color2)),
+    blend(Channel< 5>(color1), Channel< 5>(color2)),
+    blend(Channel<10>(color1), Channel<10>(color2)));
+}
+
+ALWAYS_INLINE T Brighten(T color, T evy) {
+  auto brighten = [&](T c) {
+    return V::Add(c, V::ShiftRight<4>(V::Mul(V::Sub(V::Set(31), c), evy)));
+  };
+
+  return Pack(brighten(Channel<0>(color)), brighten(Channel<5>(color)), brighten(Channel<10>(color)));
+}
+
+ALWAYS_INLINE T Darken(T color, T evy) {
+  auto darken = [&](T c) {
+    return V::Sub(c, V::ShiftRight<4>(V::Mul(c, evy)));
+  };
+
+  return Pack(darken(Channel<0>(color)), darken(Channel<5>(color)), darken(Channel<10>(color)));
+}
+
+template<bool window, bool blending>
+void ComposeTmpl(ComposeArgs const& args, u32* line) {
+  for (int x = 0; x < 240; x += V::kLanes) {
+    T layer_enable = V::Set(0x3F);
+
+    if constexpr (window) {
+      layer_enable = V::LoadBytes(&args.win_layer_mask[x]);
+    }
+
+    T transparent = V::Set(kColorTransparent);
+    T pixel0 = V::Set(args.backdrop);
+    T prio0  = V::Set(4);
+
+    if constexpr (blending) {
+      T pixel1 = pixel0;
+      T prio1  = prio0;
+      T layer0 = V::Set(kLayerBD);
+      T layer1 = layer0;
+      T is_alpha_obj = V::Zero();
+
+      // Find up to two top-most visible background pixels.
+      for (int i = 0; i < args.bg_count; i++) {
+        T pixel = V::Load(&args.bg_pixels[i][x]);
+        T visible = V::AndNot(V::Equal(pixel, transparent), TestBits(layer_enable, args.bg_layer_bit[i]));
+
+        pixel1 = V::Select(visible, pixel0, pixel1);
+        pixel0 = V::Select(visible, pixel, pixel0);
+        prio1  = V::Select(visible, prio0, prio1);
+        prio0  = V::Select(visible, V::Set(args.bg_priority[i]), prio0);
+        layer1 = V::Select(visible, layer0, layer1);
+        layer0 = V::Select(visible, V::Set(args.bg_layer_bit[i]), layer0);
+      }
+
+      // Insert the OBJ pixel if it takes priority over one of the background pixels.
+      if (args.obj_enable) {
+        T color = V::Load(&args.obj_color[x]);
+        T priority = V::Load(&args.obj_priority[x]);
+        T visible = V::AndNot(V::Equal(color, transparent), TestBits(layer_enable, kLayerOBJ));
+        T top = V::And(visible, V::LessEqual(priority, prio0));
+        T second = V::AndNot(top, V::And(visible, V::LessEqual(priority, prio1)));
+
+        pixel1 = V::Select(top, pixel0, V::Select(second, color, pixel1));
+        pixel0 = V::Select(top, color, pixel0);
+        layer1 = V::Select(top, layer0, V::Select(second, V::Set(kLayerOBJ), layer1));
+        layer0 = V::Select(top, V::Set(kLayerOBJ), layer0);
+        is_alpha_obj = V::And(top, TestBits(V::Load(&args.obj_alpha[x]), 1));
+      }
+
+      T sfx_enable = window ? V::Or(TestBits(layer_enable, kLayerSFX), is_alpha_obj) : V::Set(0xFFFF);
+      T have_dst = TestBits(layer0, args.blend_dst_mask);
+      T have_src = TestBits(layer1, args.blend_src_mask);
+
+      T eva = V::Set(args.eva);
+      T evb = V::Set(args.evb);
+      T alpha = BlendAlpha(pixel0, pixel1, eva, evb);
+      T alpha_blend = V::And(sfx_enable, V::And(is_alpha_obj, have_src));
+
+      if (args.sfx != kSFXNone) {
+        T effect_blend = V::AndNot(alpha_blend, V::And(sfx_enable, have_dst));
+        T effect;
+
+        switch (args.sfx) {
+          case kSFXBlend:
+            effect_blend = V::And(effect_blend, have_src);
+            effect = alpha;
+            break;
+          case kSFXBrighten:
+            effect = Brighten(pixel0, V::Set(args.evy));
+            break;
+          default:
+            effect = Darken(pixel0, V::Set(args.evy));
+            break;
+        }
+
+        pixel0 = V::Select(effect_blend, effect, pixel0);
+      }
+
+      pixel0 = V::Select(alpha_blend, alpha, pixel0);
+    } else {
+      // Find the top-most visible background pixel.
+      for (int i = 0; i < args.bg_count; i++) {
+        T pixel = V::Load(&args.bg_pixels[i][x]);
+        T visible = V::AndNot(V::Equal(pixel, transparent), TestBits(layer_enable, args.bg_layer_bit[i]));
+
+        pixel0 = V::Select(visible, pixel, pixel0);
+        prio0  = V::Select(visible, V::Set(args.bg_priority[i]), prio0);
+      }
+
+      // Check if the OBJ pixel takes priority over the top-most background pixel.
+      if (args.obj_enable) {
+        T color = V::Load(&args.obj_color[x]);
+        T visible = V::AndNot(V::Equal(color, transparent), TestBits(layer_enable, kLayerOBJ));
+
+        visible = V::And(visible, V::LessEqual(V::Load(&args.obj_priority[x]), prio0));
+        pixel0 = V::Select(visible, color, pixel0);
+      }
+    }
+
+    if (args.swap_rb) {
+      pixel0 = Pack(Channel<10>(pixel0), Channel<5>(pixel0), Channel<0>(pixel0));
+    }
+
+    V::StoreRGB888(&line[x], pixel0);
+  }
+}
+
+void Compose(ComposeArgs const& args, u32* line) {
+  if (args.window) {
+    if (args.blending) {
+      ComposeTmpl<true, true>(args, line);
+    } else {
+      ComposeTmpl<true, false>(args, line);
+    }
+  } else {
+    if (args.blending) {
+      ComposeTmpl<false, true>(args, line);
+    } else {
+      ComposeTmpl<false, false>(args, line);
+    }
+  }
+}
+
+} // namespace
@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2021 fleroviux
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#include <common/compiler.hpp>
+
+#include "compose.hpp"
+
+#ifdef COMPOSE_X86
+
+#include <immintrin.h>
+
+namespace nba::core::simd {
+
+namespace {
+
+struct V {
+  using Type = __m256i;
+
+  static constexpr int kLanes = 16;
+
+  static ALWAYS_INLINE Type Load(u16 const* data) { return _mm256_loadu_si256((__m256i const*)data); }
+  static ALWAYS_INLINE Type LoadBytes(u8 const* data) { return _mm256_cvtepu8_epi16(_mm_loadu_si128((__m128i const*)data)); }
+  static ALWAYS_INLINE Type Set(u16 value) { return _mm256_set1_epi16(s16(value)); }
+  static ALWAYS_INLINE Type Zero() { return _mm256_setzero_si256(); }
+  static ALWAYS_INLINE Type And(Type a, Type b) { return _mm256_and_si256(a, b); }
+  static ALWAYS_INLINE Type Or(Type a, Type b) { return _mm256_or_si256(a, b); }
+  static ALWAYS_INLINE Type AndNot(Type a, Type b) { return _mm256_andnot_si256(a, b); }
+  static ALWAYS_INLINE Type Add(Type a, Type b) { return _mm256_add_epi16(a, b); }
+  static ALWAYS_INLINE Type Sub(Type a, Type b) { return _mm256_sub_epi16(a, b); }
+  static ALWAYS_INLINE Type Mul(Type a, Type b) { return _mm256_mullo_epi16(a, b); }
+  static ALWAYS_INLINE Type Min(Type a, Type b) { return _mm256_min_epu16(a, b); }
+  static ALWAYS_INLINE Type Equal(Type a, Type b) { return _mm256_cmpeq_epi16(a, b); }
+  static ALWAYS_INLINE Type LessEqual(Type a, Type b) { return _mm256_cmpeq_epi16(_mm256_min_epu16(a, b), a); }
+  static ALWAYS_INLINE Type Select(Type mask, Type a, Type b) { return _mm256_blendv_epi8(b, a, mask); }
+
+  template<int n>
+  static ALWAYS_INLINE Type ShiftLeft(Type a) { return _mm256_slli_epi16(a, n); }
+
+  template<int n>
+  static ALWAYS_INLINE Type ShiftRight(Type a) { return _mm256_srli_epi16(a, n); }
+
+  static ALWAYS_INLINE __m256i ToRGB888(__m256i color) {
+    auto r = _mm256_slli_epi32(_mm256_and_si256(color, _mm256_set1_epi32(0x001F)), 19);
+    auto g = _mm256_slli_epi32(_mm256_and_si256(color, _mm256_set1_epi32(0x03E0)),  6);
+    auto b = _mm256_srli_epi32(_mm256_and_si256(color, _mm256_set1_epi32(0x7C00)),  7);
+    return _mm256_or_si256(_mm256_or_si256(r, g), _mm256_or_si256(b, _mm256_set1_epi32(0xFF000000)));
+  }
+
+  static ALWAYS_INLINE void StoreRGB888(u32* line, Type color) {
+    _mm256_storeu_si256((__m256i*)&line[0], ToRGB888(_mm256_cvtepu16_epi32(_mm256_castsi256_si128(color))));
+    _mm256_storeu_si256((__m256i*)&line[8], ToRGB888(_mm256_cvtepu16_epi32(_mm256_extracti128_si256(color, 1))));
+  }
+};
+
+} // namespace
+
+#include "compose.inl"
+
+void ComposeAVX2(ComposeArgs const& args, u32* line) {
+  Compose(args, line);
+}
+
+} // namespace nba::core::simd
+
+#endif
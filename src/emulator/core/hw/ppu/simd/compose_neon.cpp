@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2021 fleroviux
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#include <common/compiler.hpp>
+
+#include "compose.hpp"
+
+#ifdef COMPOSE_NEON
+
+#include <arm_neon.h>
+
+namespace nba::core::simd {
+
+namespace {
+
+struct V {
+  using Type = uint16x8_t;
+
+  static constexpr int kLanes = 8;
+
+  static ALWAYS_INLINE Type Load(u16 const* data) { return vld1q_u16(data); }
+  static ALWAYS_INLINE Type LoadBytes(u8 const* data) { return vmovl_u8(vld1_u8(data)); }
+  static ALWAYS_INLINE Type Set(u16 value) { return vdupq_n_u16(value); }
+  static ALWAYS_INLINE Type Zero() { return vdupq_n_u16(0); }
+  static ALWAYS_INLINE Type And(Type a, Type b) { return vandq_u16(a, b); }
+  static ALWAYS_INLINE Type Or(Type a, Type b) { return vorrq_u16(a, b); }
+  static ALWAYS_INLINE Type AndNot(Type a, Type b) { return vbicq_u16(b, a); }
+  static ALWAYS_INLINE Type Add(Type a, Type b) { return vaddq_u16(a, b); }
+  static ALWAYS_INLINE Type Sub(Type a, Type b) { return vsubq_u16(a, b); }
+  static ALWAYS_INLINE Type Mul(Type a, Type b) { return vmulq_u16(a, b); }
+  static ALWAYS_INLINE Type Min(Type a, Type b) { return vminq_u16(a, b); }
+  static ALWAYS_INLINE Type Equal(Type a, Type b) { return vceqq_u16(a, b); }
+  static ALWAYS_INLINE Type LessEqual(Type a, Type b) { return vcleq_u16(a, b); }
+  static ALWAYS_INLINE Type Select(Type mask, Type a, Type b) { return vbslq_u16(mask, a, b); }
+
+  template<int n>
+  static ALWAYS_INLINE Type ShiftLeft(Type a) { return vshlq_n_u16(a, n); }
+
+  template<int n>
+  static ALWAYS_INLINE Type ShiftRight(Type a) { return vshrq_n_u16(a, n); }
+
+  static ALWAYS_INLINE uint32x4_t ToRGB888(uint32x4_t color) {
+    auto r = vshlq_n_u32(vandq_u32(color, vdupq_n_u32(0x001F)), 19);
+    auto g = vshlq_n_u32(vandq_u32(color, vdupq_n_u32(0x03E0)),  6);
+    auto b = vshrq_n_u32(vandq_u32(color, vdupq_n_u32(0x7C00)),  7);
+    return vorrq_u32(vorrq_u32(r, g), vorrq_u32(b, vdupq_n_u32(0xFF000000)));
+  }
+
+  static ALWAYS_INLINE void StoreRGB888(u32* line, Type color) {
+    vst1q_u32(&line[0], ToRGB888(vmovl_u16(vget_low_u16(color))));
+    vst1q_u32(&line[4], ToRGB888(vmovl_u16(vget_high_u16(color))));
+  }
+};
+
+} // namespace
+
+#include "compose.inl"
+
+void ComposeNEON(ComposeArgs const& args, u32* line) {
+  Compose(args, line);
+}
+
+} // namespace nba::core::simd
+
+#endif
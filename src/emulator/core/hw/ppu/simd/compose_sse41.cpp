@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2021 fleroviux
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#include <common/compiler.hpp>
+
+#include "compose.hpp"
+
+#ifdef COMPOSE_X86
+
+#include <smmintrin.h>
+
+namespace nba::core::simd {
+
+namespace {
+
+struct V {
+  using Type = __m128i;
+
+  static constexpr int kLanes = 8;
+
+  static ALWAYS_INLINE Type Load(u16 const* data) { return _mm_loadu_si128((__m128i const*)data); }
+  static ALWAYS_INLINE Type LoadBytes(u8 const* data) { return _mm_cvtepu8_epi16(_mm_loadl_epi64((__m128i const*)data)); }
+  static ALWAYS_INLINE Type Set(u16 value) { return _mm_set1_epi16(s16(value)); }
+  static ALWAYS_INLINE Type Zero() { return _mm_setzero_si128(); }
+  static ALWAYS_INLINE Type And(Type a, Type b) { return _mm_and_si128(a, b); }
+  static ALWAYS_INLINE Type Or(Type a, Type b) { return _mm_or_si128(a, b); }
+  static ALWAYS_INLINE Type AndNot(Type a, Type b) { return _mm_andnot_si128(a, b); }
+  static ALWAYS_INLINE Type Add(Type a, Type b) { return _mm_add_epi16(a, b); }
+  static ALWAYS_INLINE Type Sub(Type a, Type b) { return _mm_sub_epi16(a, b); }
+  static ALWAYS_INLINE Type Mul(Type a, Type b) { return _mm_mullo_epi16(a, b); }
+  static ALWAYS_INLINE Type Min(Type a, Type b) { return _mm_min_epu16(a, b); }
+  static ALWAYS_INLINE Type Equal(Type a, Type b) { return _mm_cmpeq_epi16(a, b); }
+  static ALWAYS_INLINE Type LessEqual(Type a, Type b) { return _mm_cmpeq_epi16(_mm_min_epu16(a, b), a); }
+  static ALWAYS_INLINE Type Select(Type mask, Type a, Type b) { return _mm_blendv_epi8(b, a, mask); }
+
+  template<int n>
+  static ALWAYS_INLINE Type ShiftLeft(Type a) { return _mm_slli_epi16(a, n); }
+
+  template<int n>
+  static ALWAYS_INLINE Type ShiftRight(Type a) { return _mm_srli_epi16(a, n); }
+
+  static ALWAYS_INLINE __m128i ToRGB888(__m128i color) {
+    auto r = _mm_slli_epi32(_mm_and_si128(color, _mm_set1_epi32(0x001F)), 19);
+    auto g = _mm_slli_epi32(_mm_and_si128(color, _mm_set1_epi32(0x03E0)),  6);
+    auto b = _mm_srli_epi32(_mm_and_si128(color, _mm_set1_epi32(0x7C00)),  7);
+    return _mm_or_si128(_mm_or_si128(r, g), _mm_or_si128(b, _mm_set1_epi32(0xFF000000)));
+  }
+
+  static ALWAYS_INLINE void StoreRGB888(u32* line, Type color) {
+    _mm_storeu_si128((__m128i*)&line[0], ToRGB888(_mm_cvtepu16_epi32(color)));
+    _mm_storeu_si128((__m128i*)&line[4], ToRGB888(_mm_cvtepu16_epi32(_mm_srli_si128(color, 8))));
+  }
+};
+
+} // namespace
+
+#include "compose.inl"
+
+void ComposeSSE41(ComposeArgs const& args, u32* line) {
+  Compose(args, line);
+}
+
+} // namespace nba::core::simd
+
+#endif
@@ -0,0 +1,195 @@
+/*
+ * Copyright (C) 2021 fleroviux
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#include <cstring>
+
+#include "ppu.hpp"
+
+namespace nba::core {
+
+/* The threaded renderer runs the regular renderer on a second, render-only
+ * PPU instance. At every H-blank the emulation thread snapshots the I/O
+ * registers and the memory written since the previous H-blank, so that
+ * mid-frame changes (raster effects) are observed exactly like in the
+ * synchronous renderer.
+ */
+
+void PPU::StartRenderThread() {
+  render_thread = std::make_unique<RenderThread>();
+  render_thread->ppu = std::unique_ptr<PPU>{new PPU{this}};
+  render_thread->commands = std::make_unique<RenderCommand[]>(RenderThread::kCapacity);
+  render_thread->thread = std::thread{[this]() {
+    RenderThreadMain();
+  }};
+
+  // The render-only instance starts out empty, so resend all memory.
+  std::memset(tile_dirty, 0xFF, sizeof(tile_dirty));
+  pram_dirty = true;
+  oam_dirty = true;
+}
+
+void PPU::StopRenderThread() {
+  if (!render_thread) {
+    return;
+  }
+
+  {
+    std::lock_guard lock{render_thread->mutex};
+    render_thread->stop = true;
+  }
+  render_thread->cv.notify_one();
+  render_thread->thread.join();
+  render_thread.reset();
+}
+
+/* Waits until the render thread has executed all submitted commands. */
+void PPU::DrainRenderThread() {
+  auto& thread = *render_thread;
+  auto write_index = thread.write_index.load(std::memory_order_relaxed);
+
+  while (thread.read_index.load(std::memory_order_acquire) != write_index) {
+    std::this_thread::yield();
+  }
+}
+
+void PPU::SubmitRenderCommand(int ops, int oam_line) {
+  auto& thread = *render_thread;
+  auto write_index = thread.write_index.load(std::memory_order_relaxed);
+
+  while (write_index - thread.read_index.load(std::memory_order_acquire) == RenderThread::kCapacity) {
+    std::this_thread::yield();
+  }
+
+  auto& command = thread.commands[write_index % RenderThread::kCapacity];
+
+  command.mmio = mmio;
+  command.ops = ops;
+  command.oam_line = oam_line;
+  command.pram_dirty = pram_dirty;
+  command.oam_dirty = oam_dirty;
+  command.tile_count = 0;
+
+  // The render thread now owns the pending window updates.
+  mmio.winh[0]._changed = false;
+  mmio.winh[1]._changed = false;
+
+  if (pram_dirty) {
+    std::memcpy(command.pram, pram, sizeof(pram));
+    pram_dirty = false;
+  }
+
+  if (oam_dirty) {
+    std::memcpy(command.oam, oam, sizeof(oam));
+    oam_dirty = false;
+  }
+
+  int tile_count = 0;
+
+  for (auto bits : tile_dirty) {
+    tile_count += __builtin_popcountll(bits);
+  }
+
+  if (tile_count > RenderCommand::kMaxTiles) {
+    // Too many tiles for one command. Copy them directly once the render thread is idle.
+    auto& renderer = *thread.ppu;
+
+    DrainRenderThread();
+    std::memcpy(renderer.vram, vram, sizeof(vram));
+    std::memset(renderer.tile_dirty, 0xFF, sizeof(tile_dirty));
+    std::memset(tile_dirty, 0, sizeof(tile_dirty));
+  } else if (tile_count != 0) {
+    for (int i = 0; i < int(sizeof(tile_dirty) / sizeof(u64)); i++) {
+      auto bits = tile_dirty[i];
+
+      while (bits != 0) {
+        int tile = i * 64 + __builtin_ctzll(bits);
+
+        command.tile_index[command.tile_count] = tile;
+        std::memcpy(command.tile_data[command.tile_count], &vram[tile * 32], 32);
+        command.tile_count++;
+        bits &= bits - 1;
+      }
+
+      tile_dirty[i] = 0;
+    }
+  }
+
+  // Sequentially consistent, so that either the render thread sees the command
+  // before going to sleep or we see that it sleeps.
+  thread.write_index.store(write_index + 1);
+
+  if (thread.sleeping.load()) {
+    std::lock_guard lock{thread.mutex};
+    thread.cv.notify_one();
+  }
+}
+
+void PPU::RenderThreadMain() {
+  auto& thread = *render_thread;
+  auto& renderer = *thread.ppu;
+
+  auto available = [&](size_t read_index) {
+    return thread.write_index.load() != read_index;
+  };
+
+  for (;;) {
+    auto read_index = thread.read_index.load(std::memory_order_relaxed);
+
+    // Spin for a while, since a new command will usually follow soon.
+    for (int i = 0; i < RenderThread::kSpinCount && !available(read_index); i++) {
+    }
+
+    if (!available(read_index)) {
+      std::unique_lock lock{thread.mutex};
+
+      thread.sleeping = true;
+      thread.cv.wait(lock, [&]() {
+        return thread.stop || available(read_index);
+      });
+      thread.sleeping = false;
+    }
+
+    if (thread.stop) {
+      return;
+    }
+
+    renderer.ApplyRenderCommand(thread.commands[read_index % RenderThread::kCapacity]);
+    thread.read_index.store(read_index + 1, std::memory_order_release);
+  }
+}
+
+void PPU::ApplyRenderCommand(RenderCommand const& command) {
+  // Window updates that were not consumed yet (window not active on the line) stay pending.
+  bool winh_changed[2] = { mmio.winh[0]._changed, mmio.winh[1]._changed };
+
+  mmio = command.mmio;
+  mmio.winh[0]._changed |= winh_changed[0];
+  mmio.winh[1]._changed |= winh_changed[1];
+
+  if (command.pram_dirty) {
+    std::memcpy(pram, command.pram, sizeof(pram));
+    for (int i = 0; i < 0x200; i++) {
+      pram16[i] = common::read<u16>(pram, i * 2) & 0x7FFF;
+    }
+  }
+
+  if (command.oam_dirty) {
+    std::memcpy(oam, command.oam, sizeof(oam));
+    obj_list_dirty = true;
+  }
+
+  for (int i = 0; i < command.tile_count; i++) {
+    u32 address = command.tile_index[i] * 32;
+
+    std::memcpy(&vram[address], command.tile_data[i], 32);
+    MarkTileDirty(address);
+  }
+
+  ExecuteRenderOps(command.ops, command.oam_line);
+}
+
+} // namespace nba::core
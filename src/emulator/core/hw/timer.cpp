@@ -19,12 +19,6 @@ void Timer::Reset() {
     auto& channel = channels[id];
     channel = {};
     channel.id = id;
-    channel.event_cb = [this, id](int cycles_late) {
-      // FIXME: ideally we would just capture the existing channel reference... not sure if it is possible.
-      auto& channel = channels[id];
-      OnOverflow(channel);
-      StartChannel(channel, cycles_late);
-    };
   }
 }
 
@@ -94,6 +88,12 @@ void Timer::Write(int chan_id, int offset, u8 value) {
           StartChannel(channel, late);
         }
       }
+
+      // A running timer which was reconfigured keeps its event.
+      if (!channel.running && channel.event != nullptr) {
+        scheduler.Cancel(channel.event);
+        channel.event = nullptr;
+      }
     }
   }
 
@@ -119,7 +119,12 @@ void Timer::StartChannel(Channel& channel, int cycles_late) {
 
   channel.running = true;
   channel.timestamp_started = scheduler.GetTimestampNow() - cycles_late;
-  channel.event = scheduler.Add(cycles - cycles_late, channel.event_cb);
+
+  if (channel.event != nullptr) {
+    scheduler.Reschedule(channel.event, cycles - cycles_late);
+  } else {
+    channel.event = scheduler.Add(cycles - cycles_late, EventClass::TM_overflow, channel.id);
+  }
 }
 
 void Timer::StopChannel(Channel& channel) {
@@ -127,11 +132,18 @@ void Timer::StopChannel(Channel& channel) {
   if (channel.counter >= 0x10000) {
     OnOverflow(channel);
   }
-  scheduler.Cancel(channel.event);
-  channel.event = nullptr;
   channel.running = false;
 }
 
+void Timer::OnOverflowEvent(int cycles_late, u64 chan_id) {
+  auto& channel = channels[chan_id];
+
+  // The scheduler removes the current event once we return.
+  channel.event = nullptr;
+  OnOverflow(channel);
+  StartChannel(channel, cycles_late);
+}
+
 void Timer::OnOverflow(Channel& channel) {
   channel.counter = channel.reload;
 
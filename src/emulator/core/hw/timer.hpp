@@ -20,6 +20,7 @@ struct Timer {
       : scheduler(scheduler)
       , irq(irq)
       , apu(apu) {
+    scheduler.Register<&Timer::OnOverflowEvent>(EventClass::TM_overflow, this);
     Reset();
   }
 
@@ -51,7 +52,6 @@ private:
     int samplerate;
     u64 timestamp_started;
     Scheduler::Event* event = nullptr;
-    std::function<void(int)> event_cb;
   } channels[4];
 
   Scheduler& scheduler;
@@ -62,6 +62,7 @@ private:
   void StartChannel(Channel& channel, int cycles_late);
   void StopChannel(Channel& channel);
   void OnOverflow(Channel& channel);
+  void OnOverflowEvent(int cycles_late, u64 chan_id);
 };
 
 } // namespace nba::core
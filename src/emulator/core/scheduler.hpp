@@ -10,17 +10,50 @@
 #include <common/log.hpp>
 #include <common/compiler.hpp>
 #include <common/integer.hpp>
-#include <functional>
+#include <array>
 #include <limits>
+#include <type_traits>
 
 namespace nba::core {
 
-struct Scheduler {  
-  template<class T>
-  using EventMethod = void (T::*)(int);
+/** Identifies the handler of a scheduler event.
+  * Each event class is bound to one handler with Scheduler::Register().
+  */
+enum class EventClass : u16 {
+  // PPU
+  PPU_scanline_complete,
+  PPU_hblank_complete,
+  PPU_vblank_scanline_complete,
+  PPU_vblank_hblank_complete,
+
+  // APU
+  APU_mixer,
+  APU_sequencer,
+  APU_PSG1_generate,
+  APU_PSG2_generate,
+  APU_PSG3_generate,
+  APU_PSG4_generate,
+
+  // IRQ controller
+  IRQ_update_line,
+
+  // Timers
+  TM_overflow,
+
+  // DMA
+  DMA_activated,
+
+  // ARM7TDMI
+  ARM_ldm_usermode_conflict,
+
+  EndOfQueue,
+  Count
+};
 
+struct Scheduler {
   struct Event {
-    std::function<void(int)> callback;
+    EventClass event_class;
+    u64 user_data;
   private:
     friend class Scheduler;
     int handle;
@@ -32,6 +65,7 @@ struct Scheduler {
       heap[i] = new Event();
       heap[i]->handle = i;
     }
+    Register<&Scheduler::OnEndOfQueue>(EventClass::EndOfQueue, this);
     Reset();
   }
 
@@ -44,9 +78,7 @@ struct Scheduler {
   void Reset() {
     heap_size = 0;
     timestamp_now = 0;
-    Add(std::numeric_limits<u64>::max(), [](int) {
-      ASSERT(false, "event queue was empty or reached the end of time.")
-    });
+    Add(std::numeric_limits<u64>::max(), EventClass::EndOfQueue);
   }
 
   auto GetTimestampNow() const -> u64 {
@@ -54,20 +86,43 @@ struct Scheduler {
   }
 
   auto GetTimestampTarget() const -> u64 {
-    return heap[0]->timestamp;
+    return timestamp_target;
   }
 
   auto GetRemainingCycleCount() const -> int {
     return int(GetTimestampTarget() - GetTimestampNow());
   }
 
-  void AddCycles(int cycles) {
+  /* This is called for every bus cycle, so only consult
+   * the heap once the earliest event is actually due.
+   */
+  void ALWAYS_INLINE AddCycles(int cycles) {
     auto timestamp_next = timestamp_now + cycles;
-    Step(timestamp_next);
+    if (unlikely(timestamp_next >= timestamp_target)) {
+      Step(timestamp_next);
+    }
     timestamp_now = timestamp_next;
   }
 
-  auto Add(u64 delay, std::function<void(int)> callback) -> Event* {
+  /** Binds an event class to a method of an object.
+    * The method either takes the number of cycles the event fired late,
+    * or that and the user data which was passed to Add().
+    */
+  template<auto method, class T>
+  void Register(EventClass event_class, T* object) {
+    handlers[int(event_class)] = {
+      object,
+      [](void* object, int cycles_late, u64 user_data) {
+        if constexpr (std::is_invocable_v<decltype(method), T*, int, u64>) {
+          (((T*)object)->*method)(cycles_late, user_data);
+        } else {
+          (((T*)object)->*method)(cycles_late);
+        }
+      }
+    };
+  }
+
+  auto Add(u64 delay, EventClass event_class, u64 user_data = 0) -> Event* {
     int n = heap_size++;
     int p = Parent(n);
 
@@ -75,7 +130,8 @@ struct Scheduler {
 
     auto event = heap[n];
     event->timestamp = GetTimestampNow() + delay;
-    event->callback = callback;
+    event->event_class = event_class;
+    event->user_data = user_data;
 
     while (n != 0 && heap[p]->timestamp > heap[n]->timestamp) {
       Swap(n, p);
@@ -83,14 +139,15 @@ struct Scheduler {
       p = Parent(n);
     }
 
+    timestamp_target = heap[0]->timestamp;
     return event;
   }
 
-  template<class T>
-  void Add(u64 delay, T* object, EventMethod<T> method) {
-    Add(delay, [object, method](int cycles_late) {
-      (object->*method)(cycles_late);
-    });
+  /// Moves a pending event to a new point in time, relative to now.
+  /// Must not be used on the event which is currently being handled.
+  void Reschedule(Event* event, u64 delay) {
+    event->timestamp = GetTimestampNow() + delay;
+    Update(event->handle);
   }
 
   void Cancel(Event* event) {
@@ -105,17 +162,22 @@ private:
   constexpr int RightChild(int n) { return n * 2 + 2; }
 
   void Step(u64 timestamp_next) {
-    while (heap[0]->timestamp <= timestamp_next && heap_size > 0) {
+    while (timestamp_target <= timestamp_next && heap_size > 0) {
       auto event = heap[0];
+      auto& handler = handlers[int(event->event_class)];
       timestamp_now = event->timestamp;
-      event->callback(0);
+      handler.callback(handler.object, 0, event->user_data);
       Remove(event->handle);
     }
   }
 
   void Remove(int n) {
     Swap(n, --heap_size);
+    Update(n);
+  }
 
+  /// Restores the heap property after the timestamp of heap[n] changed.
+  void Update(int n) {
     int p = Parent(n);
     if (n != 0 && heap[p]->timestamp > heap[n]->timestamp) {
       do {
@@ -126,6 +188,8 @@ private:
     } else {
       Heapify(n);
     }
+
+    timestamp_target = heap[0]->timestamp;
   }
 
   void Swap(int i, int j) {
@@ -151,9 +215,21 @@ private:
     }
   }
 
+  void OnEndOfQueue(int) {
+    ASSERT(false, "event queue was empty or reached the end of time.")
+  }
+
+  struct Handler {
+    void* object = nullptr;
+    void (*callback)(void* object, int cycles_late, u64 user_data) = nullptr;
+  };
+
+  std::array<Handler, int(EventClass::Count)> handlers;
+
   Event* heap[kMaxEvents];
   int heap_size;
   u64 timestamp_now;
+  u64 timestamp_target; /* cached timestamp of heap[0] */
 };
 
 } // namespace nba::core
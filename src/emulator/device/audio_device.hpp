@@ -14,10 +14,17 @@ namespace nba {
 struct AudioDevice {
   virtual ~AudioDevice() = default;
 
-  typedef void (*Callback)(void* userdata, s16* stream, int byte_len);
+  enum class SampleFormat {
+    S16,
+    F32
+  };
+
+  /// @param stream interleaved stereo samples in the format given by GetSampleFormat().
+  typedef void (*Callback)(void* userdata, void* stream, int byte_len);
 
   virtual auto GetSampleRate() -> int = 0;
   virtual auto GetBlockSize() -> int = 0;
+  virtual auto GetSampleFormat() -> SampleFormat { return SampleFormat::S16; }
   virtual bool Open(void* userdata, Callback callback) = 0;
   virtual void Close() = 0;
 };
@@ -14,6 +14,11 @@ namespace nba {
 struct VideoDevice {
   virtual ~VideoDevice() = default;
 
+  /// Optionally provides the memory that the next frame will be rendered into,
+  /// so that Draw() can present it without a copy.
+  /// @returns nullptr if the emulator should use its own buffer.
+  virtual auto GetFrameBuffer() -> u32* { return nullptr; }
+
   virtual void Draw(u32* buffer) = 0;
 };
 
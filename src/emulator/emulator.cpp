@@ -134,7 +134,11 @@ auto Emulator::LoadGame(std::string const& path) -> StatusCode {
   if (!bios_loaded) {
     auto status = LoadBIOS();
     if (status != StatusCode::Ok) {
-      return status;
+      if (!config->hle_bios) {
+        return status;
+      }
+      LOG_WARN("No usable BIOS file, running with the high-level emulated BIOS.");
+      cpu.LoadBIOSStub();
     }
     bios_loaded = true;
   }
@@ -220,16 +224,28 @@ auto Emulator::LoadGame(std::string const& path) -> StatusCode {
   }
 
   cpu.game_pak = GamePak{std::move(rom), std::move(backup), std::move(gpio), mask};
+  cpu.idle_loop_skip_blacklisted = g_idle_loop_skip_blacklist.count(game_code) != 0;
 
   return StatusCode::Ok;
 }
 
 void Emulator::Run(int cycles) {
   cpu.RunFor(cycles);
+  cpu.apu.RunMixer();
 }
 
 void Emulator::Frame() {
   cpu.RunFor(g_cycles_per_frame);
+  cpu.apu.RunMixer();
+  cpu.apu.UpdateRateControl();
+}
+
+void Emulator::SetFrameskip(int frameskip) {
+  cpu.ppu.SetFrameskip(frameskip);
+}
+
+void Emulator::RequestFrame() {
+  cpu.ppu.RequestFrame();
 }
 
 } // namespace nba
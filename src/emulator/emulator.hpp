@@ -28,6 +28,13 @@ struct Emulator {
   auto LoadGame(std::string const& path) -> StatusCode;
   void Run(int cycles);
   void Frame();
+
+  /// Renders only every (frameskip + 1)-th frame, or no frame unless requested if negative.
+  /// Emulation is not affected, only the output of the skipped frames.
+  void SetFrameskip(int frameskip);
+
+  /// Renders the next frame regardless of the frameskip.
+  void RequestFrame();
   
 private:
   static auto DetectBackupType(u8* rom, size_t size) -> Config::BackupType;
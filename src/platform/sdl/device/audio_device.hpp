@@ -15,12 +15,13 @@
 struct SDL2_AudioDevice : public nba::AudioDevice {
   auto GetSampleRate() -> int final { return have.freq; }
   auto GetBlockSize() -> int final { return have.samples; }
+  auto GetSampleFormat() -> SampleFormat final { return SampleFormat::F32; }
 
   auto SetPassthrough(SDL_AudioCallback passthrough) {
     this->passthrough = passthrough;
   }
 
-  void InvokeCallback(s16* stream, int byte_len) {
+  void InvokeCallback(void* stream, int byte_len) {
     if (callback) {
       callback(callback_userdata, stream, byte_len);
     }
@@ -37,7 +38,8 @@ struct SDL2_AudioDevice : public nba::AudioDevice {
     /* TODO: read from configuration file. */
     want.freq = 48000;
     want.samples = 2048;
-    want.format = AUDIO_S16;
+    // The emulator mixes in float, so SDL does not need to convert the samples.
+    want.format = AUDIO_F32SYS;
     want.channels = 2;
 
     if (passthrough != nullptr) {
@@ -59,7 +61,7 @@ struct SDL2_AudioDevice : public nba::AudioDevice {
     }
 
     if (have.format != want.format) {
-      LOG_ERROR("SDL_AudioDevice: S16 sample format unavailable.");
+      LOG_ERROR("SDL_AudioDevice: F32 sample format unavailable.");
       return false;
     }
 
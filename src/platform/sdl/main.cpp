@@ -6,6 +6,7 @@
  */
 
 #include <atomic>
+#include <chrono>
 #include <common/log.hpp>
 #include <cstdlib>
 #include <cstring>
@@ -16,8 +17,10 @@
 #include <filesystem>
 #include <fmt/format.h>
 #include <iterator>
+#include <mutex>
 #include <optional>
 #include <string>
+#include <thread>
 #include <toml.hpp>
 #include <unordered_map>
 
@@ -30,13 +33,69 @@
 static constexpr auto kNativeWidth = 240;
 static constexpr auto kNativeHeight = 160;
 
+/* Triple-buffered handoff of frames from the emulation thread to the render thread.
+ * Each side owns one buffer, the third one is swapped atomically with either side.
+ */
+struct FrameExchange {
+  static constexpr int kFrameSize = kNativeWidth * kNativeHeight;
+
+  /// @param storage memory for three frames, which the emulation thread renders into.
+  void SetStorage(u32* storage) {
+    for (int i = 0; i < 3; i++) {
+      buffers[i] = &storage[i * kFrameSize];
+    }
+  }
+
+  auto GetWriteBuffer() -> u32* { return buffers[write_index]; }
+  auto GetReadBuffer() -> u32* { return buffers[read_index]; }
+  auto GetReadIndex() -> int { return read_index; }
+
+  /// Called by the emulation thread once its buffer holds a complete frame.
+  void Publish() {
+    write_index = shared_index.exchange(write_index | kFresh, std::memory_order_acq_rel) & kIndexMask;
+  }
+
+  /// Called by the render thread.
+  bool HasNewFrame() {
+    return (shared_index.load(std::memory_order_relaxed) & kFresh) != 0;
+  }
+
+  /// Called by the render thread, @returns whether a new frame was acquired.
+  bool Acquire() {
+    if (!HasNewFrame()) {
+      return false;
+    }
+    read_index = shared_index.exchange(read_index, std::memory_order_acq_rel) & kIndexMask;
+    return true;
+  }
+
+private:
+  static constexpr int kIndexMask = 3;
+  static constexpr int kFresh = 4;
+
+  u32* buffers[3];
+  int write_index = 0;
+  int read_index = 1;
+  std::atomic_int shared_index = 2;
+};
+
 static SDL_Window* g_window;
 static SDL_GLContext g_gl_context;
 static GLuint g_gl_texture;
-static u32 g_framebuffer[kNativeWidth * kNativeHeight];
-static auto g_frame_counter = 0;
+static FrameExchange g_frames;
+static u32 g_frame_storage[3 * FrameExchange::kFrameSize];
+
+/* Persistently mapped pixel buffer holding the three frames, if supported.
+ * The fences protect each frame until its upload to the texture completed.
+ */
+static GLuint g_gl_pbo = 0;
+static GLsync g_gl_upload_fence[3] = {};
+static std::atomic_int g_frame_counter = 0;
 static auto g_swap_interval = 1;
 
+static std::thread g_emulation_thread;
+static std::atomic_bool g_emulation_running = false;
+
 static std::atomic_bool g_sync_to_audio = true;
 static int g_cycles_per_audio_frame = 0;
 
@@ -44,7 +103,7 @@ static auto g_keyboard_input_device = nba::BasicInputDevice{};
 static auto g_controller_input_device = nba::BasicInputDevice{};
 static SDL_GameController* g_game_controller = nullptr;
 static auto g_game_controller_button_x_old = false;
-static auto g_fastforward = false;
+static std::atomic_bool g_fastforward = false;
 
 static auto g_config = std::make_shared<nba::Config>();
 static auto g_emulator = std::make_unique<nba::Emulator>(g_config);
@@ -69,8 +128,15 @@ struct CombinedInputDevice : public nba::InputDevice {
 };
 
 struct SDL2_VideoDevice : public nba::VideoDevice {
+  auto GetFrameBuffer() -> u32* final {
+    return g_frames.GetWriteBuffer();
+  }
+
   void Draw(u32* buffer) final {
-    std::memcpy(g_framebuffer, buffer, sizeof(u32) * kNativeWidth * kNativeHeight);
+    if (buffer != g_frames.GetWriteBuffer()) {
+      std::memcpy(g_frames.GetWriteBuffer(), buffer, sizeof(u32) * FrameExchange::kFrameSize);
+    }
+    g_frames.Publish();
     g_frame_counter++;
   }
 };
@@ -80,7 +146,10 @@ void update_fullscreen();
 void update_viewport();
 void update_key(SDL_KeyboardEvent* event);
 void update_controller();
-void audio_passthrough(SDL2_AudioDevice* audio_device, s16* stream, int byte_len);
+void audio_passthrough(SDL2_AudioDevice* audio_device, void* stream, int byte_len);
+void emulation_thread_main();
+void init_frame_texture();
+void upload_frame();
 
 void usage(char* app_name) {
   fmt::print("Usage: {0} [--bios bios_path] [--force-rtc] [--save-type type] [--fullscreen] [--scale factor] [--resampler type] [--sync-to-audio yes/no] rom_path\n", app_name);
@@ -298,10 +367,7 @@ void init(int argc, char** argv) {
   glMatrixMode(GL_MODELVIEW);
   glLoadIdentity();
   glEnable(GL_TEXTURE_2D);
-  glGenTextures(1, &g_gl_texture);
-  glBindTexture(GL_TEXTURE_2D, g_gl_texture);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  init_frame_texture();
   if (!g_config->video.shader.path_vs.empty() && !g_config->video.shader.path_fs.empty()) {
     auto vert_src = load_as_string(g_config->video.shader.path_vs);
     auto frag_src = load_as_string(g_config->video.shader.path_fs);
@@ -319,7 +385,8 @@ void init(int argc, char** argv) {
   }
   glClearColor(0, 0, 0, 1);
   glClear(GL_COLOR_BUFFER_BIT);
-  g_sync_to_audio = g_config->sync_to_audio;
+  // With dynamic rate control the audio callback only drains the buffer.
+  g_sync_to_audio = g_config->sync_to_audio && !g_config->audio.dynamic_rate_control;
   update_fullscreen();
   update_viewport();
   for (int i = 0; i < SDL_NumJoysticks(); i++) {
@@ -338,6 +405,120 @@ void init(int argc, char** argv) {
   g_config->video_dev = std::make_shared<SDL2_VideoDevice>();
   g_emulator->Reset();
   g_cycles_per_audio_frame = 16777216ULL * audio_device->GetBlockSize() / audio_device->GetSampleRate();
+  g_emulation_running = true;
+  g_emulation_thread = std::thread{emulation_thread_main};
+}
+
+/* Runs the emulator at its native frame rate, or as fast as possible while fast-forwarding,
+ * unless the audio callback drives emulation.
+ */
+void emulation_thread_main() {
+  using Clock = std::chrono::steady_clock;
+
+  // 280896 cycles per frame at 16.78 MHz
+  static constexpr auto kFrameDuration = std::chrono::nanoseconds{16742706};
+
+  auto frame_deadline = Clock::now();
+
+  while (g_emulation_running) {
+    if (g_sync_to_audio) {
+      std::this_thread::sleep_for(std::chrono::milliseconds{1});
+      frame_deadline = Clock::now();
+      continue;
+    }
+
+    g_emulator_lock.lock();
+    g_emulator->Frame();
+    g_emulator_lock.unlock();
+
+    if (g_fastforward) {
+      frame_deadline = Clock::now();
+      continue;
+    }
+
+    frame_deadline += kFrameDuration;
+
+    auto now = Clock::now();
+
+    // Do not try to catch up if we fell far behind (e.g. after a stall).
+    if (now - frame_deadline > kFrameDuration * 4) {
+      frame_deadline = now;
+    } else {
+      std::this_thread::sleep_until(frame_deadline);
+    }
+  }
+}
+
+/* Allocates the texture storage once and, if possible, maps a pixel buffer
+ * that the emulator renders into, so that uploads are done by the GPU.
+ */
+void init_frame_texture() {
+  glGenTextures(1, &g_gl_texture);
+  glBindTexture(GL_TEXTURE_2D, g_gl_texture);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+  if (GLEW_ARB_texture_storage) {
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, kNativeWidth, kNativeHeight);
+  } else {
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, kNativeWidth, kNativeHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+  }
+
+  g_frames.SetStorage(g_frame_storage);
+
+  if (GLEW_ARB_buffer_storage) {
+    constexpr GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    constexpr GLsizeiptr size = sizeof(g_frame_storage);
+
+    glGenBuffers(1, &g_gl_pbo);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, g_gl_pbo);
+    glBufferStorage(GL_PIXEL_UNPACK_BUFFER, size, nullptr, flags);
+
+    auto storage = (u32*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, flags);
+
+    if (storage != nullptr) {
+      g_frames.SetStorage(storage);
+    } else {
+      LOG_WARN("Failed to map pixel buffer, uploading frames from system memory.");
+      glDeleteBuffers(1, &g_gl_pbo);
+      g_gl_pbo = 0;
+    }
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+  }
+}
+
+/* Uploads the newest frame to the texture, if there is one. */
+void upload_frame() {
+  if (!g_frames.HasNewFrame()) {
+    return;
+  }
+
+  // The current frame goes back to the emulation thread, so its upload must be complete.
+  auto& fence = g_gl_upload_fence[g_frames.GetReadIndex()];
+
+  if (fence != nullptr) {
+    while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED) {
+    }
+    glDeleteSync(fence);
+    fence = nullptr;
+  }
+
+  g_frames.Acquire();
+
+  auto format = g_config->video.format == nba::Config::Video::Format::ABGR8888 ? GL_RGBA : GL_BGRA;
+
+  if (g_gl_pbo != 0) {
+    auto offset = sizeof(u32) * FrameExchange::kFrameSize * g_frames.GetReadIndex();
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, g_gl_pbo);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, kNativeWidth, kNativeHeight, format, GL_UNSIGNED_BYTE, (void*)offset);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    g_gl_upload_fence[g_frames.GetReadIndex()] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  } else {
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, kNativeWidth, kNativeHeight, format, GL_UNSIGNED_BYTE, g_frames.GetReadBuffer());
+  }
 }
 
 void loop() {
@@ -347,25 +528,10 @@ void loop() {
 
   for (;;) {
     update_controller();
-    if (!g_sync_to_audio) {
-      g_emulator_lock.lock();
-      g_emulator->Frame();
-      g_emulator_lock.unlock();
-    }
     update_viewport();
     glClear(GL_COLOR_BUFFER_BIT);
     glBindTexture(GL_TEXTURE_2D, g_gl_texture);
-    glTexImage2D(
-      GL_TEXTURE_2D,
-      0,
-      GL_RGBA,
-      kNativeWidth,
-      kNativeHeight,
-      0,
-      GL_BGRA,
-      GL_UNSIGNED_BYTE,
-      g_framebuffer
-    );
+    upload_frame();
     glBegin(GL_QUADS);
     glTexCoord2f(0, 0);
     glVertex2f(-1.0f, 1.0f);
@@ -379,9 +545,9 @@ void loop() {
     SDL_GL_SwapWindow(g_window);
     auto ticks_end = SDL_GetTicks();
     if ((ticks_end - ticks_start) >= 1000) {
-      auto title = fmt::format("NanoBoyAdvance [{0} fps | {1}%]", g_frame_counter, int(g_frame_counter / 60.0 * 100.0));
+      int frames = g_frame_counter.exchange(0);
+      auto title = fmt::format("NanoBoyAdvance [{0} fps | {1}%]", frames, int(frames / 60.0 * 100.0));
       SDL_SetWindowTitle(g_window, title.c_str());
-      g_frame_counter = 0;
       ticks_start = ticks_end;
     }
     while (SDL_PollEvent(&event)) {
@@ -394,6 +560,8 @@ void loop() {
 }
 
 void destroy() {
+  g_emulation_running = false;
+  g_emulation_thread.join();
   // Make sure that the audio thread no longer accesses the emulator.
   g_emulator_lock.lock();
   if (g_game_controller != nullptr) {
@@ -404,7 +572,7 @@ void destroy() {
   SDL_QuitSubSystem(SDL_INIT_VIDEO | SDL_INIT_AUDIO | SDL_INIT_GAMECONTROLLER);
 }
 
-void audio_passthrough(SDL2_AudioDevice* audio_device, s16* stream, int byte_len) {
+void audio_passthrough(SDL2_AudioDevice* audio_device, void* stream, int byte_len) {
   if (g_sync_to_audio) {
     g_emulator_lock.lock();
     g_emulator->Run(g_cycles_per_audio_frame);
@@ -428,12 +596,7 @@ void update_viewport() {
 
 void update_fastforward(bool fastforward) {
   g_fastforward = fastforward;
-  g_sync_to_audio = !fastforward && g_config->sync_to_audio;
-  if (fastforward) {
-    SDL_GL_SetSwapInterval(0);
-  } else {
-    SDL_GL_SetSwapInterval(g_swap_interval);
-  }
+  g_sync_to_audio = !fastforward && g_config->sync_to_audio && !g_config->audio.dynamic_rate_control;
 }
 
 void update_key(SDL_KeyboardEvent* event) {
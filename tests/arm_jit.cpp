@@ -0,0 +1,278 @@
+/*
+ * Copyright (C) 2021 fleroviux
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "arm_system.hpp"
+
+/* The tests build loops of random instructions which run often enough
+ * to be compiled by the JIT. Code starts at address zero, loads and stores
+ * address the upper half of memory, so that code is only modified on purpose.
+ */
+static constexpr int kKernels = 6;
+static constexpr int kIterations = 40;
+
+static auto Random(std::mt19937& rng, u32 count) -> u32 {
+  return rng() % count;
+}
+
+static auto ARMDataImm(u32 cond, u32 op, u32 s, u32 rn, u32 rd, u32 rot, u32 imm) -> u32 {
+  return (cond << 28) | (1 << 25) | (op << 21) | (s << 20) | (rn << 16) | (rd << 12) | (rot << 8) | imm;
+}
+
+static auto ARMDataReg(u32 cond, u32 op, u32 s, u32 rn, u32 rd, u32 amount, u32 type, u32 rm) -> u32 {
+  return (cond << 28) | (op << 21) | (s << 20) | (rn << 16) | (rd << 12) | (amount << 7) | (type << 5) | rm;
+}
+
+static auto ARMBranch(u32 cond, u32 link, s32 offset) -> u32 {
+  return (cond << 28) | 0x0A000000 | (link << 24) | (u32(offset) & 0xFFFFFF);
+}
+
+/* ARM loops use r11 as the base of loads and stores and r12 as the loop counter.
+ * The random instructions write r0 - r10 and the flags.
+ */
+static auto RandomARM(std::mt19937& rng) -> std::vector<u32> {
+  u32 cond = Random(rng, 4) == 0 ? Random(rng, 15) : COND_AL;
+  u32 rd = Random(rng, 11);
+  u32 rn = Random(rng, 8) == 0 ? 15 : Random(rng, 11);
+
+  switch (Random(rng, 10)) {
+    case 0:
+    case 1:
+    case 2: {
+      u32 op = Random(rng, 16);
+      u32 s = (op >= 8 && op <= 11) ? 1 : Random(rng, 2);
+
+      return { ARMDataImm(cond, op, s, rn, rd, Random(rng, 16), Random(rng, 256)) };
+    }
+    case 3:
+    case 4: {
+      u32 op = Random(rng, 16);
+      u32 s = (op >= 8 && op <= 11) ? 1 : Random(rng, 2);
+      u32 rm = Random(rng, 8) == 0 ? 15 : Random(rng, 11);
+
+      return { ARMDataReg(cond, op, s, rn, rd, Random(rng, 32), Random(rng, 4), rm) };
+    }
+    case 5:
+    case 6: {
+      // ldr/str(b) rd, [r11, #imm] with pre- or post-indexing and writeback, or ldr(b) rd, [pc, #imm]
+      u32 pre = Random(rng, 2);
+      u32 writeback = Random(rng, 2);
+      u32 load = Random(rng, 2);
+
+      if (rn == 15) {
+        pre = 1;
+        writeback = 0;
+        load = 1;
+      } else {
+        rn = 11;
+      }
+
+      return { (cond << 28) | 0x04000000 | (pre << 24) | (Random(rng, 2) << 23) | (Random(rng, 2) << 22) |
+               (writeback << 21) | (load << 20) | (rn << 16) | (rd << 12) | Random(rng, 256) };
+    }
+    case 7: {
+      // b(l) over the next instruction
+      return { ARMBranch(cond, Random(rng, 2), 0), ARMDataImm(COND_AL, 13, 0, 0, rd, 0, Random(rng, 256)) };
+    }
+    case 8: {
+      // mul or data processing with a register specified shift, which the JIT does not translate
+      if (Random(rng, 2) == 0) {
+        return { (cond << 28) | (Random(rng, 2) << 20) | (rd << 16) | (Random(rng, 11) << 8) | 0x90 | Random(rng, 11) };
+      }
+      return { ARMDataReg(cond, 13, Random(rng, 2), 0, rd, Random(rng, 11) << 1, Random(rng, 4), Random(rng, 11)) | 0x10 };
+    }
+    case 9: {
+      // Write the previous instruction back to memory, which invalidates the block.
+      return {
+        0xE51FA00C, // ldr r10, [pc, #-12]
+        0xE50FA010  // str r10, [pc, #-16]
+      };
+    }
+  }
+
+  return {};
+}
+
+static auto BuildARM(std::mt19937& rng) -> std::vector<u32> {
+  std::vector<u32> code;
+
+  code.push_back(0xE3A0DCC0); // mov r13, #0xC000
+
+  for (int i = 0; i < kKernels; i++) {
+    code.push_back(ARMDataImm(COND_AL, 13, 0, 0, 12, 0, kIterations)); // mov r12, #kIterations
+
+    s32 loop = code.size();
+
+    code.push_back(0xE3A0B902); // mov r11, #0x8000
+
+    for (int j = 4 + Random(rng, 16); j > 0; j--) {
+      for (u32 opcode : RandomARM(rng)) {
+        code.push_back(opcode);
+      }
+    }
+
+    code.push_back(0xE25CC001); // subs r12, r12, #1
+    code.push_back(ARMBranch(0x1, 0, loop - s32(code.size()) - 2)); // bne loop
+  }
+
+  code.push_back(ARMBranch(COND_AL, 0, 1 - s32(code.size()) - 2)); // b to the first kernel
+  return code;
+}
+
+/* Thumb loops use r6 as the base of loads and stores and r7 as the loop counter.
+ * The random instructions write r0 - r5, r8 - r10 and the flags.
+ */
+static auto RandomThumb(std::mt19937& rng) -> std::vector<u16> {
+  u32 rd = Random(rng, 6);
+  u32 rs = Random(rng, 8);
+  u32 ro = Random(rng, 8);
+  u32 imm5 = Random(rng, 32);
+  u32 imm8 = Random(rng, 256);
+
+  switch (Random(rng, 16)) {
+    case 0: return { u16((Random(rng, 3) << 11) | (imm5 << 6) | (rs << 3) | rd) };
+    case 1: return { u16(0x1800 | (Random(rng, 4) << 9) | (ro << 6) | (rs << 3) | rd) };
+    case 2: return { u16(0x2000 | (Random(rng, 4) << 11) | (rd << 8) | imm8) };
+    case 3:
+    case 4: return { u16(0x4000 | (Random(rng, 16) << 6) | (rs << 3) | rd) };
+    case 5: {
+      // add, cmp or mov with a high register
+      u32 dst = Random(rng, 2) == 0 ? rd : 8 + Random(rng, 3);
+      u32 src = Random(rng, 16);
+
+      return { u16(0x4400 | (Random(rng, 3) << 8) | ((dst >> 3) << 7) | ((src >> 3) << 6) | ((src & 7) << 3) | (dst & 7)) };
+    }
+    case 6: return { u16(0x4800 | (rd << 8) | imm8) };
+    case 7: {
+      // ldr, ldrb, ldsb, ldrh or ldsh with a register offset
+      static constexpr u16 kLoads[5] { 0x5800, 0x5C00, 0x5600, 0x5A00, 0x5E00 };
+
+      return { u16(kLoads[Random(rng, 5)] | (ro << 6) | (6 << 3) | rd) };
+    }
+    case 8:
+    case 9: return { u16(0x6000 | (Random(rng, 4) << 11) | (imm5 << 6) | (6 << 3) | rd) };
+    case 10: return { u16(0x8000 | (Random(rng, 2) << 11) | (imm5 << 6) | (6 << 3) | rd) };
+    case 11: return { u16(0x9000 | (Random(rng, 2) << 11) | (rd << 8) | imm8) };
+    case 12: {
+      // add rd, pc/sp, #imm or add sp, #imm; sub sp, #imm
+      if (Random(rng, 2) == 0) {
+        return { u16(0xA000 | (Random(rng, 2) << 11) | (rd << 8) | imm8) };
+      }
+      return { u16(0xB000 | (imm8 & 0x7F)), u16(0xB080 | (imm8 & 0x7F)) };
+    }
+    case 13: {
+      // Conditional branch, branch or branch with link over the next instruction
+      u16 next = u16(0x2000 | (rd << 8) | imm8);
+
+      switch (Random(rng, 3)) {
+        case 0: return { u16(0xD000 | (Random(rng, 14) << 8)), next };
+        case 1: return { 0xE000, next };
+      }
+      return { 0xF000, 0xF800 };
+    }
+    case 14: {
+      // mul or push and pop, which the JIT does not translate
+      if (Random(rng, 2) == 0) {
+        return { u16(0x4340 | (rs << 3) | rd) };
+      }
+      return { u16(0xB400 | 0x0F), u16(0xBC00 | 0x0F) };
+    }
+    case 15: {
+      // Write the strh back to itself, which invalidates the block.
+      return {
+        0x467D, // mov r5, pc
+        0x882C, // ldrh r4, [r5, #0]
+        0x802C  // strh r4, [r5, #0]
+      };
+    }
+  }
+
+  return {};
+}
+
+static auto BuildThumb(std::mt19937& rng) -> std::vector<u16> {
+  std::vector<u16> code;
+
+  code.push_back(0xDCC0); code.push_back(0xE3A0); // mov r13, #0xC000
+  code.push_back(0xF001); code.push_back(0xE28F); // add r0, pc, #1
+  code.push_back(0xFF10); code.push_back(0xE12F); // bx r0
+
+  for (int i = 0; i < kKernels; i++) {
+    code.push_back(0x2700 | kIterations); // mov r7, #kIterations
+
+    s32 loop = code.size();
+
+    code.push_back(0x2680); // mov r6, #0x80
+    code.push_back(0x0236); // lsl r6, r6, #8
+
+    for (int j = 4 + Random(rng, 16); j > 0; j--) {
+      for (u16 opcode : RandomThumb(rng)) {
+        code.push_back(opcode);
+      }
+    }
+
+    code.push_back(0x3F01); // sub r7, #1
+    code.push_back(0xD100 | ((loop - s32(code.size()) - 2) & 0xFF)); // bne loop
+  }
+
+  code.push_back(0xE000 | ((6 - s32(code.size()) - 2) & 0x7FF)); // b to the first kernel
+  return code;
+}
+
+/// Runs the code with the JIT enabled and with Run() in lockstep.
+template<typename T>
+static void TestLoops(u32 seed, char const* name, std::vector<T> const& code, std::mt19937& rng,
+                      size_t code_buffer_size = JIT::kCodeBufferSize) {
+  static constexpr u64 kCycles = 2000000;
+
+  auto reference = std::make_unique<System>();
+  auto jit = std::make_unique<System>();
+
+  CHECK(code.size() * sizeof(T) <= TestBus::kMemorySize / 2);
+  CHECK(jit->core.SetJITEnable(true, code_buffer_size));
+
+  for (u32 address = 0; address < TestBus::kMemorySize; address++) {
+    reference->bus.memory[address] = u8(rng());
+  }
+  std::memcpy(reference->bus.memory, code.data(), code.size() * sizeof(T));
+  std::memcpy(jit->bus.memory, reference->bus.memory, TestBus::kMemorySize);
+
+  int blocks = RunLockstep(*reference, *jit, kCycles);
+
+  std::printf("seed %u, %s: %d blocks\n", seed, name, blocks);
+}
+
+int main() {
+  if (!JIT::IsSupported()) {
+    std::printf("The JIT is not supported on this host.\n");
+    return 0;
+  }
+
+  for (u32 seed = 1; seed <= 16; seed++) {
+    std::mt19937 rng{seed};
+
+    TestLoops(seed, "ARM", BuildARM(rng), rng);
+    TestLoops(seed, "Thumb", BuildThumb(rng), rng);
+  }
+
+  /* A small code buffer fills up frequently. The blocks are then flushed,
+   * while the block which failed to compile is still running.
+   */
+  static constexpr size_t kSmallBufferSize = 32 * 1024;
+
+  for (u32 seed = 1; seed <= 4; seed++) {
+    std::mt19937 rng{seed};
+
+    TestLoops(seed, "ARM, small code buffer", BuildARM(rng), rng, kSmallBufferSize);
+    TestLoops(seed, "Thumb, small code buffer", BuildThumb(rng), rng, kSmallBufferSize);
+  }
+
+  return 0;
+}
@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2021 fleroviux
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#include <memory>
+#include <random>
+
+#include "arm_system.hpp"
+
+/* Random ARM instructions of the classes that a game would commonly use:
+ * data processing, multiplies, PSR transfers, loads and stores,
+ * short branches and BX. Coprocessor instructions and SWIs are left out.
+ */
+static auto RandomARM(std::mt19937& rng) -> u32 {
+  u32 condition = (rng() % 4) == 0 ? rng() % 14 : COND_AL;
+  u32 opcode = rng() & 0x01FFFFFF;
+
+  switch (rng() % 10) {
+    case 0 ... 2: break; // data processing (register), multiplies, halfword transfers
+    case 3 ... 4: opcode |= 0x02000000; break; // data processing (immediate)
+    case 5: opcode |= 0x04000000; break; // single data transfer (immediate offset)
+    case 6: opcode = (opcode & ~0x10) | 0x06000000; break; // single data transfer (register offset)
+    case 7: opcode |= 0x08000000; break; // block data transfer
+    case 8: opcode = 0x0A000000 | (opcode & 0x01000000) | ((rng() % 64 - 32) & 0x00FFFFFF); break;
+    case 9: opcode = 0x012FFF10 | (rng() & 15); break;
+  }
+
+  /* Changing the Thumb bit without a pipeline flush is unpredictable.
+   * Do not write the CPSR control field with MSR and do not copy
+   * the SPSR with TST, TEQ, CMP or CMN to r15.
+   */
+  if ((opcode & 0x0DB00000) == 0x01200000) {
+    opcode &= ~0x00010000;
+  }
+  if ((opcode & 0x0D90F000) == 0x0110F000) {
+    opcode &= ~0x0000F000;
+  }
+
+  return (condition << 28) | opcode;
+}
+
+/* The lower half of memory holds random ARM code and the upper half
+ * random Thumb opcodes, which also serve as data for loads and stores.
+ * Stores frequently hit code, which exercises the invalidation of cached blocks.
+ */
+static void Randomize(System& system, std::mt19937& rng) {
+  auto& memory = system.bus.memory;
+
+  for (u32 address = 0; address < TestBus::kMemorySize / 2; address += 4) {
+    common::write<u32>(memory, address, RandomARM(rng));
+  }
+
+  for (u32 address = TestBus::kMemorySize / 2; address < TestBus::kMemorySize; address += 2) {
+    common::write<u16>(memory, address, u16(rng()));
+  }
+
+  for (int i = 0; i < 15; i++) {
+    system.core.state.reg[i] = rng() & TestBus::kMemoryMask;
+  }
+}
+
+/// Runs random code with RunBlock() and with Run() in lockstep.
+static void TestRandomCode(u32 seed) {
+  static constexpr u64 kCycles = 1000000;
+
+  auto reference = std::make_unique<System>();
+  auto cached = std::make_unique<System>();
+
+  std::mt19937 rng{seed};
+  Randomize(*reference, rng);
+
+  std::memcpy(cached->bus.memory, reference->bus.memory, TestBus::kMemorySize);
+  cached->core.state = reference->core.state;
+
+  int blocks = RunLockstep(*reference, *cached, kCycles);
+
+  std::printf("seed %u: %d blocks\n", seed, blocks);
+}
+
+/// Blocks must not end early while the IRQ line is asserted but IRQs are masked.
+static void TestMaskedIRQ() {
+  auto system = std::make_unique<System>();
+  auto& core = system->core;
+
+  for (u32 address = 0; address < TestBus::kMemorySize; address += 4) {
+    common::write<u32>(system->bus.memory, address, 0xE1A00000); // mov r0, r0
+  }
+
+  // After the reset IRQs are masked. Run past the opcodes that the reset left in the pipeline.
+  core.Reset();
+  core.RunBlock(1000);
+  core.RunBlock(1000);
+
+  u32 r15 = core.state.r15;
+
+  CHECK(core.state.cpsr.f.mask_irq);
+  core.IRQLine() = true;
+  core.RunBlock(1000);
+  CHECK_EQ(core.state.r15 - r15, u32(BasicBlock<Core>::kMaxLength * 4));
+}
+
+int main() {
+  TestMaskedIRQ();
+
+  for (u32 seed = 1; seed <= 16; seed++) {
+    TestRandomCode(seed);
+  }
+
+  return 0;
+}
@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2021 fleroviux
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <common/punning.hpp>
+#include <cstring>
+#include <emulator/core/arm/arm7tdmi.hpp>
+
+#include "test.hpp"
+
+using namespace nba::core;
+using namespace nba::core::arm;
+
+using Core = ARM7TDMI<MemoryBase>;
+
+/* 64 KiB of memory, mirrored over the whole address space.
+ * Every access takes one cycle. Code is cached only from the first mirror,
+ * so that writes invalidate it at the same address.
+ * The IRQ line is asserted for 50 cycles out of every 1000.
+ */
+struct TestBus final : MemoryBase {
+  static constexpr u32 kMemorySize = 0x10000;
+  static constexpr u32 kMemoryMask = kMemorySize - 1;
+
+  TestBus(Scheduler& scheduler) : scheduler(scheduler) {}
+
+  u8  ReadByte(u32 address, Access access) final { Tick(); return memory[address & kMemoryMask]; }
+  u16 ReadHalf(u32 address, Access access) final { Tick(); return common::read<u16>(memory, address & kMemoryMask & ~1); }
+  u32 ReadWord(u32 address, Access access) final { Tick(); return common::read<u32>(memory, address & kMemoryMask & ~3); }
+
+  void WriteByte(u32 address, u8  value, Access access) final { Write<u8>(address, value); }
+  void WriteHalf(u32 address, u16 value, Access access) final { Write<u16>(address & ~1, value); }
+  void WriteWord(u32 address, u32 value, Access access) final { Write<u32>(address & ~3, value); }
+
+  void Idle() final { Tick(); }
+
+  auto GetCodePointer(u32 address) -> u8 const* final {
+    return address < kMemorySize ? &memory[address] : nullptr;
+  }
+
+  template<typename T>
+  void Write(u32 address, T value) {
+    Tick();
+    common::write<T>(memory, address & kMemoryMask, value);
+    core->InvalidateBlockCache(address & kMemoryMask);
+  }
+
+  void Tick() {
+    scheduler.AddCycles(1);
+    core->IRQLine() = (scheduler.GetTimestampNow() % 1000) < 50;
+  }
+
+  Scheduler& scheduler;
+  Core* core = nullptr;
+  u8 memory[kMemorySize];
+};
+
+struct System {
+  System() : bus(scheduler), core(scheduler, &bus) {
+    bus.core = &core;
+    core.Reset();
+  }
+
+  Scheduler scheduler;
+  TestBus bus;
+  Core core;
+};
+
+static void CheckEqual(System& a, System& b) {
+  auto& state_a = a.core.state;
+  auto& state_b = b.core.state;
+
+  CHECK_EQ(a.scheduler.GetTimestampNow(), b.scheduler.GetTimestampNow());
+
+  for (int i = 0; i < 16; i++) {
+    CHECK_EQ(state_a.reg[i], state_b.reg[i]);
+  }
+
+  for (int i = 0; i < BANK_COUNT; i++) {
+    for (int j = 0; j < 7; j++) {
+      CHECK_EQ(state_a.bank[i][j], state_b.bank[i][j]);
+    }
+    CHECK_EQ(state_a.spsr[i].v, state_b.spsr[i].v);
+  }
+
+  CHECK_EQ(state_a.cpsr.v, state_b.cpsr.v);
+  CHECK(std::memcmp(a.bus.memory, b.bus.memory, TestBus::kMemorySize) == 0);
+}
+
+/* Runs both systems from their current state until the given timestamp.
+ * The reference system executes one instruction at a time with Run(),
+ * so after each block of the other system it must arrive at the same timestamp and state.
+ * Each RunBlock() call is limited to a varying number of cycles, so that the states are
+ * compared regularly even when cached blocks chain into each other.
+ * @returns the number of blocks.
+ */
+static auto RunLockstep(System& reference, System& system, u64 timestamp_limit) -> int {
+  int blocks = 0;
+
+  while (system.scheduler.GetTimestampNow() < timestamp_limit) {
+    /* Code in the mirrors is not cached. Move back to the first mirror,
+     * the pipeline already holds the same opcodes as memory there.
+     */
+    if (system.core.state.r15 >= TestBus::kMemorySize) {
+      system.core.state.r15 &= TestBus::kMemoryMask;
+      reference.core.state.r15 &= TestBus::kMemoryMask;
+    }
+
+    u64 limit = std::min(timestamp_limit, system.scheduler.GetTimestampNow() + 1 + blocks % 1000);
+
+    system.core.RunBlock(limit);
+
+    while (reference.scheduler.GetTimestampNow() < system.scheduler.GetTimestampNow()) {
+      reference.core.Run();
+    }
+
+    CheckEqual(reference, system);
+    blocks++;
+  }
+
+  return blocks;
+}
@@ -0,0 +1,145 @@
+/*
+ * Copyright (C) 2021 fleroviux
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <emulator/core/cpu.hpp>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+#include "test.hpp"
+
+using namespace nba;
+using namespace nba::core;
+
+using Backend = Config::CPU::Backend;
+
+/* Copies an ARM routine to IWRAM and then calls it from a Thumb loop in ROM:
+ *   - the Thumb loop reads, combines and writes back 64 words of EWRAM
+ *   - the ARM routine does the same on 32 other words, with conditional execution
+ */
+static const u32 kProgram[] = {
+  0xE59F001C, // ldr r0, =arm_routine
+  0xE3A01403, // mov r1, #0x03000000
+  0xE3A0200D, // mov r2, #13
+  // copy:
+  0xE4903004, // ldr r3, [r0], #4
+  0xE4813004, // str r3, [r1], #4
+  0xE2522001, // subs r2, r2, #1
+  0x1AFFFFFB, // bne copy
+  0xE59F0004, // ldr r0, =thumb_main + 1
+  0xE12FFF10, // bx r0
+  0x08000054,
+  0x0800002D,
+  // thumb_main:
+  0x21404807, // ldr r0, =0x02000000; movs r1, #64
+  // t_loop:
+  0x68032201, // movs r2, #1; ldr r3, [r0]
+  0x005B18D2, // adds r2, r2, r3; lsls r3, r3, #1
+  0x60034053, // eors r3, r2; str r3, [r0]
+  0x39013004, // adds r0, #4; subs r1, #1
+  0x4803D1F7, // bne t_loop; ldr r0, =0x03000000
+  0xF801F000, // bl call_r0
+  0x4700E7F0, // b thumb_main; call_r0: bx r0
+  0x02000000,
+  0x03000000,
+  // arm_routine:
+  0xE3A04402, // mov r4, #0x02000000
+  0xE3A05020, // mov r5, #32
+  // a_loop:
+  0xE5946100, // ldr r6, [r4, #0x100]
+  0xE0866185, // add r6, r6, r5, lsl #3
+  0xE02672E6, // eor r7, r6, r6, ror #5
+  0xE3570A01, // cmp r7, #0x1000
+  0x82877001, // addhi r7, r7, #1
+  0x92477001, // subls r7, r7, #1
+  0xE5847100, // str r7, [r4, #0x100]
+  0xE2844004, // add r4, r4, #4
+  0xE2555001, // subs r5, r5, #1
+  0x1AFFFFF5, // bne a_loop
+  0xE12FFF1E  // bx lr
+};
+
+static auto CreateCPU(Backend backend, std::vector<u8> rom) -> std::unique_ptr<CPU> {
+  auto config = std::make_shared<Config>();
+
+  config->skip_bios = true;
+  config->cpu.backend = backend;
+
+  auto cpu = std::make_unique<CPU>(config);
+  cpu->game_pak = GamePak{std::move(rom), nullptr, nullptr};
+  cpu->Reset();
+  // Only measure the CPU, the PPU does not render.
+  cpu->ppu.SetFrameskip(-1);
+  return cpu;
+}
+
+/* Runs the built-in program or the ROM given on the command line
+ * with each CPU backend and reports the speed relative to the interpreter.
+ * All backends must arrive at the same state.
+ */
+int main(int argc, char** argv) {
+  static constexpr int kCyclesPerFrame = 228 * 1232;
+
+  int frames = 600;
+  auto rom = std::vector<u8>(0x10000);
+
+  std::memcpy(rom.data(), kProgram, sizeof(kProgram));
+
+  if (argc >= 2) {
+    std::ifstream file{argv[1], std::ios::binary};
+    CHECK(file.good());
+    rom.assign(std::istreambuf_iterator<char>{file}, {});
+  }
+  if (argc >= 3) {
+    frames = std::atoi(argv[2]);
+  }
+
+  struct Run {
+    char const* name;
+    Backend backend;
+  } runs[] = {
+    { "interpreter", Backend::Interpreter },
+    { "cached interpreter", Backend::CachedInterpreter },
+    { "JIT", Backend::JIT }
+  };
+
+  double baseline = 0;
+  std::unique_ptr<CPU> reference;
+
+  for (auto& run : runs) {
+    auto cpu = CreateCPU(run.backend, rom);
+    auto t0 = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < frames; i++) {
+      cpu->RunFor(kCyclesPerFrame);
+    }
+
+    auto t1 = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(t1 - t0).count();
+
+    if (reference == nullptr) {
+      baseline = seconds;
+    } else {
+      CHECK_EQ(cpu->scheduler.GetTimestampNow(), reference->scheduler.GetTimestampNow());
+      CHECK(std::memcmp(cpu->memory.wram, reference->memory.wram, 0x40000) == 0);
+      CHECK(std::memcmp(cpu->memory.iram, reference->memory.iram, 0x8000) == 0);
+    }
+
+    std::printf("%-20s %8.3f s  %7.1f fps  %5.2fx\n",
+      run.name, seconds, frames / seconds, baseline / seconds);
+
+    if (reference == nullptr) {
+      reference = std::move(cpu);
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2021 fleroviux
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#include <emulator/core/arm/block_cache.hpp>
+#include <emulator/core/arm/idle_loop.hpp>
+#include <initializer_list>
+
+#include "test.hpp"
+
+using namespace nba::core::arm;
+
+struct Core {};
+
+using Block = BasicBlock<Core>;
+
+static auto MakeBlock(u32 address, bool thumb, std::initializer_list<u32> opcodes) -> Block {
+  Block block;
+
+  block.address = address;
+  block.thumb = thumb;
+  for (u32 opcode : opcodes) {
+    block.code.emplace_back().opcode = opcode;
+  }
+  return block;
+}
+
+/* Loops which wait for memory (e.g. an IO register) to change and may be skipped. */
+static void TestIdleLoops() {
+  CHECK(IdleLoop::Analyze16(MakeBlock(0x08000000, true, {
+    0x8808, // ldrh r0, [r1]
+    0x28A0, // cmp r0, #160
+    0xD1FC  // bne 0x08000000
+  })));
+
+  // r2 is written before it is read, so each iteration starts over.
+  CHECK(IdleLoop::Analyze16(MakeBlock(0x08000006, true, {
+    0x4A00, // ldr r2, [pc, #0]
+    0x88D0, // ldrh r0, [r2, #6]
+    0x0840, // lsrs r0, r0, #1
+    0x2850, // cmp r0, #80
+    0xD1FA  // bne 0x08000006
+  })));
+
+  CHECK(IdleLoop::Analyze32(MakeBlock(0x08000000, false, {
+    0xE1D100B2, // ldrh r0, [r1, #2]
+    0xE3100001, // tst r0, #1
+    0x0AFFFFFC  // beq 0x08000000
+  })));
+}
+
+/* Loops with side effects make progress on each iteration and must not be skipped. */
+static void TestBusyLoops() {
+  // Increments a counter.
+  CHECK(!IdleLoop::Analyze16(MakeBlock(0x08000010, true, {
+    0x8808, // ldrh r0, [r1]
+    0x3201, // adds r2, #1
+    0x28A0, // cmp r0, #160
+    0xD1FB  // bne 0x08000010
+  })));
+
+  // Writes to memory.
+  CHECK(!IdleLoop::Analyze16(MakeBlock(0x08000018, true, {
+    0x8008, // strh r0, [r1]
+    0x8848, // ldrh r0, [r1, #2]
+    0x2800, // cmp r0, #0
+    0xD0FB  // beq 0x08000018
+  })));
+
+  // Delay loop, counts down.
+  CHECK(!IdleLoop::Analyze32(MakeBlock(0x0800000C, false, {
+    0xE2522001, // subs r2, r2, #1
+    0x1AFFFFFD  // bne 0x0800000C
+  })));
+
+  // Walks through memory with a post-indexed load.
+  CHECK(!IdleLoop::Analyze32(MakeBlock(0x08000014, false, {
+    0xE4910004, // ldr r0, [r1], #4
+    0xE3500000, // cmp r0, #0
+    0x0AFFFFFC  // beq 0x08000014
+  })));
+
+  // Does not branch back to its start.
+  CHECK(!IdleLoop::Analyze16(MakeBlock(0x08000004, true, {
+    0x8808, // ldrh r0, [r1]
+    0x28A0, // cmp r0, #160
+    0xD1FB  // bne 0x08000002
+  })));
+}
+
+int main() {
+  TestIdleLoops();
+  TestBusyLoops();
+  return 0;
+}
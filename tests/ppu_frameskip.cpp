@@ -0,0 +1,157 @@
+/*
+ * Copyright (C) 2021 fleroviux
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#include <common/punning.hpp>
+#include <cstring>
+#include <emulator/core/cpu.hpp>
+#include <memory>
+#include <vector>
+
+#include "test.hpp"
+
+using namespace nba;
+using namespace nba::core;
+
+/* Enables the PPU features that the CPU can observe and then polls them:
+ *   - mode 1 with BG2, OBJs and window 0 enabled
+ *   - V-blank, H-blank and V-count (line 100) IRQs
+ *   - BG2 affine parameters and reference points
+ *   - an H-blank DMA which copies VCOUNT to IWRAM on every line
+ * The loop acknowledges and collects IF, accumulates DISPSTAT and VCOUNT
+ * and stores its state to 0x03004000.
+ */
+static const u32 kProgram[] = {
+  0xE3A00301, // mov r0, #0x04000000
+  0xE59F1090, // ldr r1, =0x3401
+  0xE1C010B0, // strh r1, [r0]          @ DISPCNT
+  0xE59F108C, // ldr r1, =0x6438
+  0xE1C010B4, // strh r1, [r0, #0x04]   @ DISPSTAT
+  0xE59F1088, // ldr r1, =0x10C8
+  0xE1C014B0, // strh r1, [r0, #0x40]   @ WIN0H
+  0xE59F1084, // ldr r1, =0x1478
+  0xE1C014B4, // strh r1, [r0, #0x44]   @ WIN0V
+  0xE59F1080, // ldr r1, =0x00370100
+  0xE5801020, // str r1, [r0, #0x20]    @ BG2PA, BG2PB
+  0xE59F107C, // ldr r1, =0x0101FFF0
+  0xE5801024, // str r1, [r0, #0x24]    @ BG2PC, BG2PD
+  0xE59F1078, // ldr r1, =0x00012345
+  0xE5801028, // str r1, [r0, #0x28]    @ BG2X
+  0xE59F1074, // ldr r1, =0xFFFF8000
+  0xE580102C, // str r1, [r0, #0x2C]    @ BG2Y
+  0xE59F1070, // ldr r1, =0x04000006
+  0xE58010D4, // str r1, [r0, #0xD4]    @ DMA3SAD = VCOUNT
+  0xE3A01403, // mov r1, #0x03000000
+  0xE58010D8, // str r1, [r0, #0xD8]    @ DMA3DAD
+  0xE59F1064, // ldr r1, =0xA3000001
+  0xE58010DC, // str r1, [r0, #0xDC]    @ DMA3CNT: H-blank, repeat, fixed source
+  0xE3A09403, // mov r9, #0x03000000
+  0xE2899901, // add r9, r9, #0x4000
+  0xE2808C02, // add r8, r0, #0x200
+  0xE3A05000, // mov r5, #0
+  0xE3A06000, // mov r6, #0
+  0xE3A07000, // mov r7, #0
+  // loop:
+  0xE1D030B4, // ldrh r3, [r0, #4]      @ DISPSTAT
+  0xE1D020B6, // ldrh r2, [r0, #6]      @ VCOUNT
+  0xE1D840B2, // ldrh r4, [r8, #2]      @ IF
+  0xE1C840B2, // strh r4, [r8, #2]
+  0xE1866004, // orr r6, r6, r4
+  0xE02373E7, // eor r7, r3, r7, ror #7
+  0xE0877002, // add r7, r7, r2
+  0xE2855001, // add r5, r5, #1
+  0xE88900E0, // stmia r9, {r5, r6, r7}
+  0xEAFFFFF5, // b loop
+  // literal pool
+  0x00003401,
+  0x00006438,
+  0x000010C8,
+  0x00001478,
+  0x00370100,
+  0x0101FFF0,
+  0x00012345,
+  0xFFFF8000,
+  0x04000006,
+  0xA3000001
+};
+
+static auto CreateCPU(int frameskip) -> std::unique_ptr<CPU> {
+  auto config = std::make_shared<Config>();
+  auto rom = std::vector<u8>(0x1000);
+
+  config->skip_bios = true;
+
+  std::memcpy(rom.data(), kProgram, sizeof(kProgram));
+
+  auto cpu = std::make_unique<CPU>(config);
+  cpu->game_pak = GamePak{std::move(rom), nullptr, nullptr};
+  cpu->Reset();
+  cpu->ppu.SetFrameskip(frameskip);
+  return cpu;
+}
+
+/* Everything in here is visible to the CPU, either through registers
+ * or as the result of an IRQ or DMA, and must not depend on frameskip.
+ */
+static void CheckEqual(CPU& a, CPU& b) {
+  auto& mmio_a = a.ppu.mmio;
+  auto& mmio_b = b.ppu.mmio;
+
+  CHECK_EQ(a.scheduler.GetTimestampNow(), b.scheduler.GetTimestampNow());
+
+  CHECK_EQ(mmio_a.vcount, mmio_b.vcount);
+  CHECK_EQ(mmio_a.dispstat.Read(0), mmio_b.dispstat.Read(0));
+  CHECK_EQ(mmio_a.dispstat.Read(1), mmio_b.dispstat.Read(1));
+
+  for (int i = 0; i < 2; i++) {
+    CHECK_EQ(mmio_a.bgx[i].initial, mmio_b.bgx[i].initial);
+    CHECK_EQ(mmio_a.bgy[i].initial, mmio_b.bgy[i].initial);
+    CHECK_EQ(mmio_a.bgx[i]._current, mmio_b.bgx[i]._current);
+    CHECK_EQ(mmio_a.bgy[i]._current, mmio_b.bgy[i]._current);
+  }
+
+  // DMA destination and the state of the test program.
+  CHECK(std::memcmp(a.memory.iram, b.memory.iram, 0x8000) == 0);
+}
+
+int main() {
+  static constexpr int kFrames = 12;
+  static constexpr int kCyclesPerFrame = 228 * 1232;
+  static constexpr int kStep = 1232 / 8;
+
+  auto reference = CreateCPU(0);
+
+  std::unique_ptr<CPU> skipping[] = {
+    CreateCPU(1),
+    CreateCPU(3),
+    CreateCPU(-1) // never renders
+  };
+
+  for (int cycles = 0; cycles < kFrames * kCyclesPerFrame; cycles += kStep) {
+    reference->RunFor(kStep);
+
+    for (auto& cpu : skipping) {
+      cpu->RunFor(kStep);
+      CheckEqual(*reference, *cpu);
+    }
+
+    // Requested frames are rendered regardless of frameskip.
+    if ((cycles % (kCyclesPerFrame * 5)) == 0) {
+      skipping[1]->ppu.RequestFrame();
+    }
+  }
+
+  // Make sure that the program ran and observed each IRQ source and the DMA.
+  auto loop_count = common::read<u32>(reference->memory.iram, 0x4000);
+  auto if_mask = common::read<u32>(reference->memory.iram, 0x4004);
+  auto vcount = common::read<u16>(reference->memory.iram, 2);
+
+  CHECK(loop_count > 1000);
+  CHECK_EQ(if_mask, 7u); // V-blank, H-blank and V-count
+  CHECK(vcount > 0);
+
+  return 0;
+}
@@ -0,0 +1,147 @@
+/*
+ * Copyright (C) 2021 fleroviux
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#include <common/dsp/ring_buffer.hpp>
+#include <common/integer.hpp>
+#include <thread>
+
+#include "test.hpp"
+
+using common::dsp::SPSCRingBuffer;
+
+static void TestEmpty() {
+  SPSCRingBuffer<u32> buffer{16};
+
+  CHECK_EQ(buffer.Available(), 0);
+  CHECK_EQ(buffer.Read(), 0u);
+  CHECK_EQ(buffer.Available(), 0);
+
+  // An empty buffer must stay empty at every position of the ring.
+  for (u32 i = 1; i <= 100; i++) {
+    buffer.Write(i);
+    CHECK_EQ(buffer.Available(), 1);
+    CHECK_EQ(buffer.Read(), i);
+    CHECK_EQ(buffer.Available(), 0);
+    CHECK_EQ(buffer.Read(), 0u);
+  }
+}
+
+static void TestFull() {
+  SPSCRingBuffer<u32> buffer{10};
+
+  CHECK_EQ(buffer.Capacity(), 16);
+
+  u32 next_write = 0;
+  u32 next_read = 0;
+
+  // Start filling at every position of the ring, so that the full buffer wraps around.
+  for (int offset = 0; offset < 2 * buffer.Capacity(); offset++) {
+    while (buffer.Available() < buffer.Capacity()) {
+      buffer.Write(next_write++);
+    }
+
+    // Values written to a full buffer are dropped.
+    buffer.Write(0xDEADBEEF);
+    CHECK_EQ(buffer.Available(), buffer.Capacity());
+
+    u32 peeked = next_read;
+    auto spans = buffer.PeekSpans(buffer.Capacity());
+    CHECK_EQ(spans[0].length + spans[1].length, buffer.Capacity());
+    for (auto& span : spans) {
+      for (int i = 0; i < span.length; i++) {
+        CHECK_EQ(span.data[i], peeked++);
+      }
+    }
+
+    for (int i = 0; i <= offset % buffer.Capacity(); i++) {
+      CHECK_EQ(buffer.Read(), next_read++);
+    }
+  }
+
+  while (buffer.Available() > 0) {
+    CHECK_EQ(buffer.Read(), next_read++);
+  }
+  CHECK_EQ(next_read, next_write);
+}
+
+/* Streams a sequence of numbers from one thread to another and checks that
+ * every number arrives exactly once and in order. A slow consumer keeps the
+ * buffer mostly full, a slow producer keeps it mostly empty.
+ */
+static void TestConcurrent(bool slow_producer, bool slow_consumer, bool use_spans) {
+  static constexpr u32 kCount = 1 << 20;
+
+  SPSCRingBuffer<u32> buffer{64};
+
+  auto delay = [](u32 i) {
+    if ((i & 127) == 0) {
+      std::this_thread::yield();
+    }
+  };
+
+  std::thread producer{[&]() {
+    for (u32 i = 0; i < kCount; i++) {
+      // Available() may overestimate for the producer, so there is space if it is below capacity.
+      while (buffer.Available() == buffer.Capacity()) {
+        std::this_thread::yield();
+      }
+      buffer.Write(i);
+      if (slow_producer) delay(i);
+    }
+  }};
+
+  int full = 0;
+  int empty = 0;
+  u32 expected = 0;
+
+  while (expected < kCount) {
+    int available = buffer.Available();
+
+    if (available == 0) {
+      empty++;
+      std::this_thread::yield();
+      continue;
+    }
+    if (available == buffer.Capacity()) {
+      full++;
+    }
+
+    if (use_spans) {
+      for (auto& span : buffer.PeekSpans(available)) {
+        for (int i = 0; i < span.length; i++) {
+          CHECK_EQ(span.data[i], expected++);
+        }
+      }
+      buffer.Skip(available);
+    } else {
+      CHECK_EQ(buffer.Read(), expected++);
+    }
+
+    if (slow_consumer) delay(expected);
+  }
+
+  producer.join();
+
+  CHECK_EQ(buffer.Available(), 0);
+  CHECK_EQ(buffer.Read(), 0u);
+
+  std::printf("slow_producer=%d slow_consumer=%d spans=%d: full %d times, empty %d times\n",
+    slow_producer, slow_consumer, use_spans, full, empty);
+}
+
+int main() {
+  TestEmpty();
+  TestFull();
+
+  for (bool use_spans : { false, true }) {
+    TestConcurrent(false, false, use_spans);
+    TestConcurrent(false, true, use_spans);
+    TestConcurrent(true, false, use_spans);
+  }
+
+  return 0;
+}
@@ -0,0 +1,34 @@
+/*
+ * Copyright (C) 2021 fleroviux
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+
+/* Minimal test helpers. A test is a plain executable,
+ * it fails by returning a non-zero exit code to CTest.
+ */
+
+#define CHECK(condition) \
+  do { \
+    if (!(condition)) { \
+      std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+      std::exit(EXIT_FAILURE); \
+    } \
+  } while (0)
+
+#define CHECK_EQ(a, b) \
+  do { \
+    auto _a = (a); \
+    auto _b = (b); \
+    if (!(_a == _b)) { \
+      std::fprintf(stderr, "%s:%d: check failed: %s == %s (%lld != %lld)\n", \
+                   __FILE__, __LINE__, #a, #b, (long long)_a, (long long)_b); \
+      std::exit(EXIT_FAILURE); \
+    } \
+  } while (0)